@@ -10,6 +10,7 @@ namespace pc {
   export class InterpolatedKey {
     public _written: boolean = false;
     public _name: string = "";
+    public _depth: number = 0; // of the node below the root of the skeleton
     public _keyFrames: any[] = [];
 
     // Result of interpolation
@@ -35,11 +36,14 @@ namespace pc {
    * @classdesc Represents a skeleton used to play animations.
    * @param {pc.GraphNode} graph The root pc.GraphNode of the skeleton.
    * @property {Boolean} looping Determines whether skeleton is looping its animation.
+   * @property {Number} maxDepth Only nodes up to this depth below the root of the skeleton are
+   * sampled by {@link pc.Skeleton#addTime}, the others keep their last pose. Infinity by default.
    */
   export class Skeleton {
     public _animation: Animation | null = null;
     public _time: number = 0;
     public looping: boolean = true;
+    public maxDepth: number = Infinity;
 
     public _interpolatedKeys: InterpolatedKey[] = [];
     public _interpolatedKeyDict: IInterpolatedKeyDict = {};
@@ -52,18 +56,19 @@ namespace pc {
 
       var self: this = this;
 
-      function addInterpolatedKeys(node: GraphNode): void {
+      function addInterpolatedKeys(node: GraphNode, depth: number): void {
         var interpKey = new InterpolatedKey();
         interpKey._name = node.name;
+        interpKey._depth = depth;
         self._interpolatedKeys.push(interpKey);
         self._interpolatedKeyDict[node.name] = interpKey;
         self._currKeyIndices[node.name] = 0;
 
         for (var i = 0; i < node._children.length; i++)
-          addInterpolatedKeys(node._children[i]);
+          addInterpolatedKeys(node._children[i], depth + 1);
       }
 
-      addInterpolatedKeys(graph);
+      addInterpolatedKeys(graph, 0);
     }
 
     /**
@@ -129,6 +134,9 @@ namespace pc {
             // #endif
             continue;
         }
+        if (interpKey._depth > this.maxDepth)
+            continue;
+
         // If there's only a single key, just copy the key to the interpolated key...
         foundKey = false;
         if (keys.length !== 1) {
@@ -226,7 +234,13 @@ namespace pc {
       return this._time;
     }
     public set currentTime(value: number) {
-      this._time = value;
+      this._sampleTime(value);
+      this.updateGraph();
+    }
+
+    // Jumps to the time and samples it, leaving the linked node hierarchy as it is.
+    public _sampleTime(time: number): void {
+      this._time = time;
       var numNodes: number = this._interpolatedKeys.length;
       for (var i = 0; i < numNodes; i++) {
         var node: InterpolatedKey = this._interpolatedKeys[i];
@@ -235,7 +249,6 @@ namespace pc {
       }
 
       this.addTime(0);
-      this.updateGraph();
     }
 
     /**
@@ -313,11 +326,19 @@ namespace pc {
       this.graph = graph;
 
       if (graph) {
+        // index the graph for the duration of the lookups unless it already is
+        var indexGraph: boolean = !graph._nameIndex;
+        if (indexGraph)
+          graph.enableNameIndex();
+
         for (i = 0; i < this._interpolatedKeys.length; i++) {
           var interpKey: InterpolatedKey = this._interpolatedKeys[i];
           var graphNode: GraphNode = graph.findByName(interpKey._name);
           this._interpolatedKeys[i].setTarget(graphNode);
         }
+
+        if (indexGraph)
+          graph.disableNameIndex();
       } else {
         for (i = 0; i < this._interpolatedKeys.length; i++) {
           this._interpolatedKeys[i].setTarget(null);
@@ -354,6 +375,38 @@ namespace pc {
       }
     }
 
+    /**
+     * @function
+     * @name pc.Skeleton#lerpGraph
+     * @description Moves the linked node hierarchy part of the way towards the current state of
+     * the skeleton. Unlike {@link pc.Skeleton#updateGraph}, the sampled keyframes are kept until
+     * the hierarchy reaches them, so calling this once per frame with 1 / frames left reaches the
+     * sampled pose linearly over several frames.
+     * @param {Number} alpha How far to move, 0 keeps the current pose, 1 is the same as
+     * {@link pc.Skeleton#updateGraph}.
+     */
+    public lerpGraph(alpha: number): void {
+      if (alpha >= 1) {
+        this.updateGraph();
+        return;
+      }
+      if (!this.graph) return;
+
+      for (var i = 0; i < this._interpolatedKeys.length; i++) {
+        var interpKey = this._interpolatedKeys[i];
+        if (interpKey._written) {
+          var transform: Node = interpKey.getTarget()!;
+
+          transform.localPosition.lerp(transform.localPosition, interpKey._pos, alpha);
+          transform.localRotation.slerp(transform.localRotation, interpKey._quat, alpha);
+          transform.localScale.lerp(transform.localScale, interpKey._scale, alpha);
+
+          if (!transform._dirtyLocal)
+            transform._dirtifyLocal();
+        }
+      }
+    }
+
     /**
      * @private
      * @deprecated
@@ -16,4 +16,25 @@ namespace pc {
         }
         return hash;
     }
+
+    /**
+     * @private
+     * @function
+     * @name pc.hashCodeRange
+     * @description Same as {@link pc.hashCode} for the part of a string between start and end,
+     * without creating the substring.
+     * @param {String} str String
+     * @param {Number} start Index of the first character
+     * @param {Number} end Index one past the last character
+     * @returns {Number} Hash value
+     */
+    export function hashCodeRange(str: string, start: number, end: number): number {
+        var hash: number = 0;
+        for (var i = start; i < end; i++) {
+            hash = ((hash << 5) - hash) + str.charCodeAt(i);
+            // Convert to 32bit integer
+            hash |= 0;
+        }
+        return hash;
+    }
 }
@@ -11,6 +11,96 @@ namespace pc {
         //[kex: string]: TagsIndex;
     }
 
+    // Every tag string ever added to a pc.Tags gets a bit index, shared by all tag sets, so that
+    // sets can be stored and compared as bitsets.
+    var tagBits: { [tag: string]: number } = { };
+    var numTagBits = 0;
+
+    /**
+     * @private
+     * @function
+     * @name pc.getTagBit
+     * @description Get the bit index of a tag.
+     * @param {String} tag Name of a tag.
+     * @param {Boolean} [create] Assign a new bit index to tags that have none yet.
+     * @returns {Number} Bit index, -1 if the tag has none.
+     */
+    export function getTagBit(tag: string, create?: boolean): number {
+        var bit = tagBits[tag];
+        if (bit === undefined) {
+            if (!create)
+                return -1;
+
+            bit = numTagBits++;
+            tagBits[tag] = bit;
+        }
+        return bit;
+    }
+
+    /**
+     * @private
+     * @constructor
+     * @name pc.TagsQuery
+     * @classdesc A tag query (as returned by pc.Tags#_processArguments) compiled into one bit mask
+     * per AND clause, so that testing a tag set is a few integer operations per clause.
+     * @param {String[][]} tags The clauses, any of which has to be satisfied.
+     */
+    export class TagsQuery {
+        _tags: string[][];
+        // per clause, null when the clause names a tag nobody ever had (it can't match)
+        _masks: (number[] | null)[];
+        _bits: (number[] | null)[];
+
+        constructor(tags: string[][]) {
+            this._tags = tags;
+            this._masks = [];
+            this._bits = [];
+
+            for (var i = 0; i < tags.length; i++) {
+                var mask: number[] | null = [];
+                var bits: number[] | null = [];
+
+                for (var t = 0; t < tags[i].length; t++) {
+                    var bit = getTagBit(tags[i][t]);
+                    if (bit === -1) {
+                        mask = bits = null;
+                        break;
+                    }
+
+                    var word = bit >> 5;
+                    while (mask.length <= word)
+                        mask.push(0);
+                    mask[word] |= 1 << (bit & 31);
+                    bits.push(bit);
+                }
+
+                this._masks.push(mask);
+                this._bits.push(bits);
+            }
+        }
+
+        // true when the bitset satisfies every tag of clause i
+        _testClause(i: number, bits: number[]): boolean {
+            var mask = this._masks[i];
+            if (!mask || mask.length > bits.length)
+                return false;
+
+            for (var w = 0; w < mask.length; w++) {
+                if ((bits[w] & mask[w]) !== mask[w])
+                    return false;
+            }
+            return true;
+        }
+
+        _test(bits: number[]): boolean {
+            for (var i = 0; i < this._masks.length; i++) {
+                if (this._testClause(i, bits))
+                    return true;
+            }
+            return false;
+        }
+    }
+
     export class TagsCache {
         _index: TagsIndex;
         _key: TagsIndex;
@@ -72,7 +162,7 @@ namespace pc {
             }
 
             // by position in list
-            var ind = this._index[tag].indexOf(item);
+            var ind = this._index[tag].list.indexOf(item);
             if (ind === -1)
                 return;
 
@@ -93,7 +183,7 @@ namespace pc {
             var index = { };
             var items = [];
             var i, n, t;
-            var item, tag, tags, tagsRest, missingIndex;
+            var item, tag, tags, query, missingIndex;
 
             var sort = function (a: any, b: any) {
                 return self._index[a].list.length - self._index[b].list.length;
@@ -123,14 +213,12 @@ namespace pc {
                         // sort tags by least number of matches first
                         tags = tag.slice(0).sort(sort);
 
-                        // remainder of tags for `has` checks
-                        tagsRest = tags.slice(1);
-                        if (tagsRest.length === 1)
-                            tagsRest = tagsRest[0];
+                        // every tag of the clause as one mask test
+                        query = new TagsQuery([tags]);
 
                         for (n = 0; n < this._index[tags[0]].list.length; n++) {
                             item = this._index[tags[0]].list[n];
-                            if ((this._key ? !index[item[this._key]] : (items.indexOf(item) === -1)) && item.tags.has(tagsRest)) {
+                            if ((this._key ? !index[item[this._key]] : (items.indexOf(item) === -1)) && item.tags._has(query)) {
                                 if (this._key)
                                     index[item[this._key]] = true;
                                 items.push(item);
@@ -195,6 +283,7 @@ namespace pc {
     export class Tags implements events.IEvents {
         _index: any;
         _list: any;
+        _bits: number[];
         _parent: any;
 
         // IEvent hackery:
@@ -210,6 +299,8 @@ namespace pc {
         constructor(parent: any) {
             this._index = { };
             this._list = [];
+            // one bit per tag (see pc.getTagBit), 32 per word
+            this._bits = [];
             this._parent = parent;
 
             pc.events.attach(this);
@@ -244,6 +335,11 @@ namespace pc {
                 this._index[tags[i]] = true;
                 this._list.push(tags[i]);
 
+                var bit = getTagBit(tags[i], true);
+                this._setBit(bit);
+                if (this._parent && this._parent._tagIndex)
+                    this._parent._tagIndex.addTag(this._parent, bit);
+
                 this.fire('add', tags[i], this._parent);
             }
 
@@ -287,6 +383,11 @@ namespace pc {
                 delete this._index[tags[i]];
                 this._list.splice(this._list.indexOf(tags[i]), 1);
 
+                var bit = getTagBit(tags[i]);
+                this._clearBit(bit);
+                if (this._parent && this._parent._tagIndex)
+                    this._parent._tagIndex.removeTag(this._parent, bit);
+
                 this.fire('remove', tags[i], this._parent);
             }
 
@@ -312,8 +413,14 @@ namespace pc {
             this._list = [];
             this._index = { };
 
-            for (var i = 0; i < tags.length; i++)
+            for (var i = 0; i < tags.length; i++) {
+                var bit = getTagBit(tags[i]);
+                this._clearBit(bit);
+                if (this._parent && this._parent._tagIndex)
+                    this._parent._tagIndex.removeTag(this._parent, bit);
+
                 this.fire('remove', tags[i], this._parent);
+            }
 
             this.fire('change', this._parent);
         }
@@ -342,37 +449,41 @@ namespace pc {
             if (!this._list.length)
                 return false;
 
-            return this._has(this._processArguments(arguments));
+            // a single tag is one bit test, no query needs to be compiled
+            if (arguments.length === 1 && typeof arguments[0] === 'string')
+                return this._hasBit(getTagBit(arguments[0]));
+
+            return this._has(new TagsQuery(this._processArguments(arguments)));
         }
 
 
-        _has(tags: any) {
-            if (!this._list.length || !tags.length)
+        _has(query: TagsQuery) {
+            if (!this._list.length)
                 return false;
 
-            for (var i = 0; i < tags.length; i++) {
-                if (tags[i].length === 1) {
-                    // single occurance
-                    if (this._index[tags[i][0]])
-                        return true;
-                } else {
-                    // combined occurance
-                    var multiple = true;
-
-                    for (var t = 0; t < tags[i].length; t++) {
-                        if (this._index[tags[i][t]])
-                            continue;
+            return query._test(this._bits);
+        }
 
-                        multiple = false;
-                        break;
-                    }
 
-                    if (multiple)
-                        return true;
-                }
-            }
+        _hasBit(bit: number): boolean {
+            if (bit === -1)
+                return false;
 
-            return false;
+            var word = bit >> 5;
+            return word < this._bits.length && (this._bits[word] & (1 << (bit & 31))) !== 0;
+        }
+
+
+        _setBit(bit: number) {
+            var word = bit >> 5;
+            while (this._bits.length <= word)
+                this._bits.push(0);
+            this._bits[word] |= 1 << (bit & 31);
+        }
+
+
+        _clearBit(bit: number) {
+            this._bits[bit >> 5] &= ~(1 << (bit & 31));
         }
 
 
@@ -387,7 +498,7 @@ namespace pc {
         }
 
 
-        _processArguments(args: IArguments, flat?: any): Tags {
+        _processArguments(args: IArguments, flat?: any): any[] {
             var tags: any[] = [];
             var tmp: any[] = [];
 
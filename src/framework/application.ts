@@ -1047,6 +1047,7 @@ namespace pc {
             stats.materials = this.renderer._materialSwitches;
             stats.shaders = this.graphicsDevice._shaderSwitchesPerFrame;
             stats.shadowMapUpdates = this.renderer._shadowMapUpdates;
+            stats.shadowMapsReused = this.renderer._shadowMapsReused;
             stats.shadowMapTime = this.renderer._shadowMapTime;
             stats.depthMapTime = this.renderer._depthMapTime;
             stats.forwardTime = this.renderer._forwardTime;
@@ -1059,6 +1060,8 @@ namespace pc {
             stats.skinTime = this.renderer._skinTime;
             stats.morphTime = this.renderer._morphTime;
             stats.instancingTime = this.renderer._instancingTime;
+            stats.syncRoots = this.syncQueue._stats.roots;
+            stats.syncNodes = this.syncQueue._stats.nodes;
             stats.otherPrimitives = 0;
             for (var i = 0; i < prims.length; i++) {
                 if (i < pc.PRIMITIVE_TRIANGLES) {
@@ -1069,6 +1072,7 @@ namespace pc {
             this.renderer._camerasRendered = 0;
             this.renderer._materialSwitches = 0;
             this.renderer._shadowMapUpdates = 0;
+            this.renderer._shadowMapsReused = 0;
             this.graphicsDevice._shaderSwitchesPerFrame = 0;
             this.renderer._cullTime = 0;
             this.renderer._sortTime = 0;
@@ -1087,8 +1091,8 @@ namespace pc {
             stats.shadow = this.renderer._shadowDrawCalls;
             stats.skinned = this.renderer._skinDrawCalls;
             stats.immediate = 0;
-            stats.instanced = 0;
-            stats.removedByInstancing = 0;
+            stats.instanced = this.renderer._instancedDrawCalls;
+            stats.removedByInstancing = this.renderer._removedByInstancing;
             stats.total = this.graphicsDevice._drawCallsPerFrame;
             stats.misc = stats.total - (stats.forward + stats.shadow);
             this.renderer._depthDrawCalls = 0;
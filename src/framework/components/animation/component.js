@@ -71,6 +71,9 @@ Object.assign(pc, function () {
                 }
             }
 
+            // restart the level of detail on the new animation
+            data.lodFrame = 0;
+            data.lodPending = 0;
             data.playing = true;
         },
 
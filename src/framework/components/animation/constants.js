@@ -0,0 +1,25 @@
+Object.assign(pc, {
+    /**
+     * @constant
+     * @type Number
+     * @name pc.ANIMLOD_NONE
+     * @description Every animated model is sampled every frame.
+     */
+    ANIMLOD_NONE: 0,
+
+    /**
+     * @constant
+     * @type Number
+     * @name pc.ANIMLOD_DISTANCE
+     * @description The animation level of detail is picked by the distance of the entity to the camera.
+     */
+    ANIMLOD_DISTANCE: 1,
+
+    /**
+     * @constant
+     * @type Number
+     * @name pc.ANIMLOD_SCREENSIZE
+     * @description The animation level of detail is picked by the height of the model on screen.
+     */
+    ANIMLOD_SCREENSIZE: 2
+});
@@ -19,6 +19,12 @@ Object.assign(pc, function () {
         this.blendTime = 0;
         this.blendTimeRemaining = 0;
         this.playing = false;
+
+        // Level of detail, see pc.AnimationComponentSystem#lodMode
+        this.lod = 0;
+        this.lodPeriod = 1; // frames between samples at the current LOD
+        this.lodFrame = 0; // frames left until the next sample
+        this.lodPending = 0; // animation time not sampled yet
     };
 
     return {
@@ -24,6 +24,24 @@ Object.assign(pc, function () {
      * @description Create an AnimationComponentSystem
      * @param {pc.Application} app The application managing this system.
      * @extends pc.ComponentSystem
+     * @property {Number} lodMode How the animation level of detail (LOD) of each model is picked:
+     * <ul>
+     *     <li>{@link pc.ANIMLOD_NONE}: every model is sampled every frame.</li>
+     *     <li>{@link pc.ANIMLOD_DISTANCE}: by the distance of the entity to the camera.</li>
+     *     <li>{@link pc.ANIMLOD_SCREENSIZE}: by the height of the model's bounds on screen.</li>
+     * </ul>
+     * Defaults to pc.ANIMLOD_NONE.
+     * @property {pc.CameraComponent} lodCamera The camera the LOD is measured from. When null, the
+     * first active camera.
+     * @property {Number[]} lodThresholds Where LOD 1, 2 and 3 start. Distances for pc.ANIMLOD_DISTANCE,
+     * defaults to [15, 30, 60]. For pc.ANIMLOD_SCREENSIZE the bounding sphere diameter as a fraction
+     * of the screen height, which decreases with the LOD, e.g. [0.25, 0.1, 0.04].
+     * @property {Number[]} lodPeriods Frames between two samples of the animation per LOD, defaults
+     * to [1, 2, 4, 4]. The frames in between interpolate towards the next sample.
+     * @property {Number} lodBoneDepth At LOD 3 only the bones up to this depth below the root of the
+     * skeleton are sampled, deeper bones such as fingers keep their last pose. Defaults to 4.
+     * @property {Boolean} lodFreezeOffscreen Do not sample models none of whose mesh instances were
+     * visible to a camera in the last frame. Their animation time still advances. Defaults to true.
      */
     var AnimationComponentSystem = function AnimationComponentSystem(app) {
         pc.ComponentSystem.call(this, app);
@@ -36,6 +54,14 @@ Object.assign(pc, function () {
 
         this.schema = _schema;
 
+        this.lodMode = pc.ANIMLOD_NONE;
+        this.lodCamera = null;
+        this.lodThresholds = [15, 30, 60];
+        this.lodPeriods = [1, 2, 4, 4];
+        this.lodBoneDepth = 4;
+        this.lodFreezeOffscreen = true;
+        this._lodStagger = 0;
+
         this.on('beforeremove', this.onBeforeRemove, this);
         this.on('update', this.onUpdate, this);
 
@@ -85,9 +111,108 @@ Object.assign(pc, function () {
             component.onBeforeRemove();
         },
 
+        _getLod: function (data, entity, camera) {
+            var i, meshInstances = data.model.meshInstances;
+
+            if (this.lodFreezeOffscreen && meshInstances.length > 0) {
+                // visibleThisFrame still holds the culling result of the last frame
+                for (i = 0; i < meshInstances.length; i++) {
+                    if (meshInstances[i].visibleThisFrame) break;
+                }
+                if (i === meshInstances.length) return -1;
+            }
+
+            var distance = entity.getPosition().distance(camera.entity.getPosition());
+            var value = distance;
+            var thresholds = this.lodThresholds;
+            var lod;
+
+            if (this.lodMode === pc.ANIMLOD_SCREENSIZE) {
+                var radius = 0;
+                for (i = 0; i < meshInstances.length; i++) {
+                    // the bounds of the last frame, the current ones are computed when rendering
+                    radius = Math.max(radius, meshInstances[i]._aabb.halfExtents.length());
+                }
+                var halfHeight = camera.projection === pc.PROJECTION_ORTHOGRAPHIC ?
+                    camera.orthoHeight :
+                    distance * Math.tan(camera.fov * pc.math.DEG_TO_RAD * 0.5);
+                value = halfHeight > 0 ? radius / halfHeight : Infinity;
+
+                for (lod = 0; lod < thresholds.length; lod++) {
+                    if (value > thresholds[lod]) break;
+                }
+                return lod;
+            }
+
+            for (lod = 0; lod < thresholds.length; lod++) {
+                if (value < thresholds[lod]) break;
+            }
+            return lod;
+        },
+
+        // Skeleton#addTime wraps a looping animation to its start wherever a step ends past the
+        // end, which loses the rest of steps that cover several frames; those wrap around by the
+        // duration instead. A step past the end of an animation that doesn't loop is clamped by
+        // addTime.
+        _addLodTime: function (skeleton, step) {
+            var animation = skeleton._animation;
+            var time = skeleton._time + step;
+            if (animation && skeleton.looping && animation.duration > 0 && (time > animation.duration || time < 0)) {
+                time %= animation.duration;
+                skeleton._sampleTime(time < 0 ? time + animation.duration : time);
+            } else {
+                skeleton.addTime(step);
+            }
+        },
+
+        // Advances the animation at the component's LOD, returns false when it is frozen.
+        _updateLod: function (data, entity, camera, delta, stats) {
+            var skeleton = data.skeleton;
+            var lod = camera ? this._getLod(data, entity, camera) : 0;
+
+            data.lodPending += delta;
+            if (lod < 0) {
+                stats.frozen++;
+                return false;
+            }
+
+            lod = Math.min(lod, this.lodPeriods.length - 1);
+            data.lod = lod;
+            stats.lods[Math.min(lod, stats.lods.length - 1)]++;
+            skeleton.maxDepth = lod >= 3 ? this.lodBoneDepth : Infinity;
+
+            var period = this.lodPeriods[lod];
+            if (data.lodFrame <= 0 || period !== data.lodPeriod) {
+                // spread the models entering a LOD over its period, so they don't all sample at once
+                var frames = period === data.lodPeriod ? period : 1 + (this._lodStagger++ % period);
+                data.lodPeriod = period;
+
+                // sample the pose of the time the next sample is due and move towards it
+                this._addLodTime(skeleton, data.lodPending + delta * (frames - 1));
+                data.lodPending = -delta * (frames - 1);
+                data.lodFrame = frames;
+                stats.sampled++;
+            } else {
+                stats.interpolated++;
+            }
+
+            skeleton.lerpGraph(1 / data.lodFrame);
+            data.lodFrame--;
+            return true;
+        },
+
         onUpdate: function (dt) {
             var components = this.store;
 
+            var stats = this.app.stats.animation;
+            stats.lods[0] = stats.lods[1] = stats.lods[2] = stats.lods[3] = 0;
+            stats.frozen = stats.sampled = stats.interpolated = 0;
+
+            var camera = null;
+            if (this.lodMode !== pc.ANIMLOD_NONE) {
+                camera = this.lodCamera || this.app.systems.camera.cameras[0] || null;
+            }
+
             for (var id in components) {
                 if (components.hasOwnProperty(id)) {
                     var component = components[id];
@@ -102,11 +227,26 @@ Object.assign(pc, function () {
                                 }
                                 var alpha = 1.0 - (componentData.blendTimeRemaining / componentData.blendTime);
                                 skeleton.blend(componentData.fromSkel, componentData.toSkel, alpha);
+                                stats.lods[0]++;
+                                stats.sampled++;
                             } else {
                                 // Advance the animation, interpolating keyframes at each animated node in
                                 // skeleton
                                 var delta = dt * componentData.speed;
+                                if (camera) {
+                                    // the LOD updates the graph itself
+                                    if (this._updateLod(componentData, component.entity, camera, delta, stats) &&
+                                        componentData.lodFrame === 0 &&
+                                        (skeleton._time === skeleton._animation.duration) && !componentData.loop) {
+                                        componentData.playing = false;
+                                    }
+                                    continue;
+                                }
+
+                                skeleton.maxDepth = Infinity;
                                 skeleton.addTime(delta);
+                                stats.lods[0]++;
+                                stats.sampled++;
                                 if ((skeleton._time === skeleton._animation.duration) && !componentData.loop) {
                                     componentData.playing = false;
                                 }
@@ -115,6 +255,8 @@ Object.assign(pc, function () {
                             if (componentData.blending && (componentData.blendTimeRemaining === 0.0)) {
                                 componentData.blending = false;
                                 skeleton.animation = componentData.toSkel._animation;
+                                componentData.lodFrame = 0;
+                                componentData.lodPending = 0;
                             }
 
                             skeleton.updateGraph();
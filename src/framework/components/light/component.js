@@ -73,6 +73,8 @@ Object.assign(pc, function () {
      * <li>{@link pc.SHADOWUPDATE_NONE}: Don't render shadows.</li>
      * <li>{@link pc.SHADOWUPDATE_THISFRAME}: Render shadows only once (then automatically switches to pc.SHADOWUPDATE_NONE).</li>
      * <li>{@link pc.SHADOWUPDATE_REALTIME}: Render shadows every frame (default).</li>
+     * <li>{@link pc.SHADOWUPDATE_ONCHANGE}: Render shadows when the light or a shadow caster in its view changed, reusing the shadow map otherwise.
+     * Skinned and morphed casters count as changed every frame.</li>
      * </ul>
      * @property {Number} shadowType Type of shadows being rendered by this light. Options:
      * <ul>
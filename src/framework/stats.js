@@ -28,9 +28,12 @@ pc.ApplicationStats = function (device) {
         materials: 0,
         cameras: 0,
         shadowMapUpdates: 0,
+        shadowMapsReused: 0, // shadow map passes of SHADOWUPDATE_ONCHANGE lights that did not need rendering
         shadowMapTime: 0,
         depthMapTime: 0, // deprecated
         forwardTime: 0,
+        syncRoots: 0, // moved nodes whose subtrees were synced this frame
+        syncNodes: 0, // graph nodes visited to update world transforms this frame
 
         _timeToCountFrames: 0,
         _fpsAccum: 0
@@ -46,9 +49,16 @@ pc.ApplicationStats = function (device) {
 
         // Some of forward/depth/shadow/misc draw calls:
         skinned: 0,
-        instanced: 0, // deprecated
+        instanced: 0, // instanced draw calls, manual or automatic
 
-        removedByInstancing: 0 // deprecated
+        removedByInstancing: 0 // draw calls saved by instancing
+    };
+
+    this.animation = {
+        lods: [0, 0, 0, 0], // animated models per level of detail in the last update
+        frozen: 0, // offscreen animated models that were not sampled
+        sampled: 0, // animated models whose animation was sampled
+        interpolated: 0 // animated models that only moved towards their last sample
     };
 
     this.misc = {
@@ -3219,6 +3219,15 @@ Object.assign(pc, function () {
         }
     });
 
+    /**
+     * @name pc.GraphicsDevice#enableAutoInstancing
+     * @type Boolean
+     * @description When enabled, the forward renderer draws runs of sorted mesh instances that share
+     * mesh, standard material and shader variant as one instanced draw call, with up to
+     * autoInstancingMaxObjects world matrices per layer in a shared instance buffer. Mesh instances
+     * that are skinned, morphed, static, or have their own parameters or stencil state are drawn as
+     * usual. Only takes effect when the device supports instancing.
+     */
     Object.defineProperty(GraphicsDevice.prototype, 'enableAutoInstancing', {
         get: function () {
             return this._enableAutoInstancing;
@@ -1,6 +1,9 @@
 Object.assign(pc, function () {
     'use strict';
 
+    // bumped on every upload, so a buffer version also tells buffers apart
+    var version = 0;
+
     /**
      * @constructor
      * @name pc.IndexBuffer
@@ -41,6 +44,7 @@ Object.assign(pc, function () {
         this.bytesPerIndex = bytesPerIndex;
 
         this.numBytes = this.numIndices * bytesPerIndex;
+        this._version = ++version;
 
         if (initialData) {
             this.setData(initialData);
@@ -116,6 +120,8 @@ Object.assign(pc, function () {
          * currently active device.
          */
         unlock: function () {
+            this._version = ++version;
+
             // Upload the new index data
             var gl = this.device.gl;
 
@@ -1,6 +1,9 @@
 Object.assign(pc, function () {
     'use strict';
 
+    // bumped on every upload, so a buffer version also tells buffers apart
+    var version = 0;
+
     /**
      * @constructor
      * @name pc.VertexBuffer
@@ -25,6 +28,7 @@ Object.assign(pc, function () {
 
         // Create the WebGL vertex buffer object
         this.device = graphicsDevice;
+        this._version = ++version;
 
         // Allocate the storage
         if (initialData) {
@@ -117,6 +121,8 @@ Object.assign(pc, function () {
          * memory can be returned to the control of the graphics driver.
          */
         unlock: function () {
+            this._version = ++version;
+
             // Upload the new vertex data
             var gl = this.device.gl;
 
@@ -148,6 +154,29 @@ Object.assign(pc, function () {
             gl.bufferData(gl.ARRAY_BUFFER, this.storage, glUsage);
         },
 
+        /**
+         * @private
+         * @function
+         * @name pc.VertexBuffer#unlockRange
+         * @description Like {@link pc.VertexBuffer#unlock}, but only uploads a range of vertices.
+         * Falls back to uploading everything when the buffer has not been uploaded yet.
+         * @param {Number} firstVertex The first vertex to upload.
+         * @param {Number} numVertices The number of vertices to upload.
+         */
+        unlockRange: function (firstVertex, numVertices) {
+            if (!this.bufferId) {
+                this.unlock();
+                return;
+            }
+
+            this._version = ++version;
+
+            var gl = this.device.gl;
+            var size = this.format.size;
+            gl.bindBuffer(gl.ARRAY_BUFFER, this.bufferId);
+            gl.bufferSubData(gl.ARRAY_BUFFER, firstVertex * size, new Uint8Array(this.storage, firstVertex * size, numVertices * size));
+        },
+
         setData: function (data) {
             if (data.byteLength !== this.numBytes) {
                 console.error("VertexBuffer: wrong initial data size: expected " + this.numBytes + ", got " + data.byteLength);
@@ -0,0 +1,298 @@
+Object.assign(pc, function () {
+    // lists shorter than this, or with at most this many keys smaller than the key before them,
+    // are finished with an insertion sort
+    var INSERTION_MAX_COUNT = 64;
+    var INSERTION_MAX_DESCENTS = 16;
+
+    // a few descents can still need many moves (e.g. a block of keys that moved to the other end
+    // of the list), the insertion sort of a longer list gives up on the radix sort after this
+    // many moves per key
+    var INSERTION_MAX_MOVES = 8;
+
+    var SORT_SHADOW = -1;
+
+    var floatBuffer = new Float32Array(1);
+    var floatBits = new Uint32Array(floatBuffer.buffer);
+
+    // maps a number to an unsigned integer with the same order, through its float32 bits
+    function floatKey(value) {
+        floatBuffer[0] = value;
+        var bits = floatBits[0];
+        return (bits & 0x80000000) ? (~bits >>> 0) : ((bits | 0x80000000) >>> 0);
+    }
+
+    // marks the draw calls of the list being sorted, to tell if it holds last frame's draw calls
+    var sortStamp = 0;
+
+    /**
+     * @private
+     * @constructor
+     * @name pc.DrawCallSorter
+     * @classdesc Sorts lists of draw calls by 64 bit keys with an LSD radix sort, replacing
+     * Array#sort with comparator callbacks. One sorter is kept per list that is sorted every frame
+     * (see pc.VisibleInstanceList) and remembers the order it produced; when the list holds the
+     * same draw calls next frame, that order is the starting point, and as it is usually still
+     * sorted or close to it the sort ends after a check or a short insertion sort.
+     * <br/>
+     * The key of a draw call is split into two 32 bit halves, most significant first:
+     * <ul>
+     * <li>pc.SORTMODE_MATERIALMESH: inverted forward key (layer, blend type, command bit, material id), inverted mesh id</li>
+     * <li>pc.SORTMODE_BACK2FRONT: inverted depth, 0</li>
+     * <li>pc.SORTMODE_FRONT2BACK: depth, 0</li>
+     * <li>pc.SORTMODE_MANUAL: draw order, 0</li>
+     * <li>shadow casters: inverted depth key (skinning, opacity channel), inverted mesh id</li>
+     * </ul>
+     * Inverted fields sort descending, matching the comparators this replaces. The sort is stable.
+     */
+    var DrawCallSorter = function () {
+        this._capacity = 0;
+        this._high = null;
+        this._low = null;
+        this._indices = null;
+        this._tempHigh = null;
+        this._tempLow = null;
+        this._tempIndices = null;
+        this._histograms = new Uint32Array(8 * 256);
+
+        this._items = [];
+        this._previous = [];
+
+        this._stats = {
+            sorts: 0,
+            presorted: 0, // lists that were already in order
+            insertion: 0, // lists finished with an insertion sort
+            passes: 0 // radix passes made
+        };
+    };
+
+    Object.assign(DrawCallSorter.prototype, {
+        _reserve: function (count) {
+            if (this._capacity >= count) return;
+
+            var capacity = Math.max(count, this._capacity * 2, 64);
+            this._high = new Uint32Array(capacity);
+            this._low = new Uint32Array(capacity);
+            this._indices = new Uint32Array(capacity);
+            this._tempHigh = new Uint32Array(capacity);
+            this._tempLow = new Uint32Array(capacity);
+            this._tempIndices = new Uint32Array(capacity);
+            this._capacity = capacity;
+        },
+
+        _fillKeys: function (items, count, mode) {
+            var high = this._high;
+            var low = this._low;
+            var indices = this._indices;
+            var i, drawCall;
+
+            for (i = 0; i < count; i++) {
+                drawCall = items[i];
+                indices[i] = i;
+                switch (mode) {
+                    case pc.SORTMODE_MATERIALMESH:
+                        high[i] = ~drawCall._key[pc.SORTKEY_FORWARD] >>> 0;
+                        low[i] = drawCall.mesh ? (~drawCall.mesh.id >>> 0) : 0;
+                        break;
+                    case pc.SORTMODE_BACK2FRONT:
+                        high[i] = ~floatKey(drawCall.zdist) >>> 0;
+                        low[i] = 0;
+                        break;
+                    case pc.SORTMODE_FRONT2BACK:
+                        high[i] = floatKey(drawCall.zdist);
+                        low[i] = 0;
+                        break;
+                    case pc.SORTMODE_MANUAL:
+                        high[i] = floatKey(drawCall.drawOrder);
+                        low[i] = 0;
+                        break;
+                    case SORT_SHADOW:
+                        high[i] = ~drawCall._key[pc.SORTKEY_DEPTH] >>> 0;
+                        low[i] = drawCall.mesh ? (~drawCall.mesh.id >>> 0) : 0;
+                        break;
+                }
+            }
+        },
+
+        // returns false when more than maxMoves keys were moved; the keys are left partly sorted,
+        // with equal keys still in input order, for the radix sort to finish
+        _insertionSort: function (count, maxMoves) {
+            var high = this._high;
+            var low = this._low;
+            var indices = this._indices;
+            var moves = 0;
+
+            for (var i = 1; i < count; i++) {
+                var h = high[i];
+                var l = low[i];
+                var index = indices[i];
+                var j = i - 1;
+                while (j >= 0 && (high[j] > h || (high[j] === h && low[j] > l))) {
+                    high[j + 1] = high[j];
+                    low[j + 1] = low[j];
+                    indices[j + 1] = indices[j];
+                    j--;
+                }
+                high[j + 1] = h;
+                low[j + 1] = l;
+                indices[j + 1] = index;
+
+                moves += i - 1 - j;
+                if (moves > maxMoves) return false;
+            }
+            return true;
+        },
+
+        // 8 passes of 8 bits, low half first; passes where every key has the same digit are skipped
+        _radixSort: function (count) {
+            var histograms = this._histograms;
+            var srcHigh = this._high, srcLow = this._low, srcIndices = this._indices;
+            var dstHigh = this._tempHigh, dstLow = this._tempLow, dstIndices = this._tempIndices;
+            var i, pass, h, l, swap;
+
+            histograms.fill(0);
+            for (i = 0; i < count; i++) {
+                l = srcLow[i];
+                h = srcHigh[i];
+                histograms[l & 0xff]++;
+                histograms[256 + ((l >>> 8) & 0xff)]++;
+                histograms[512 + ((l >>> 16) & 0xff)]++;
+                histograms[768 + (l >>> 24)]++;
+                histograms[1024 + (h & 0xff)]++;
+                histograms[1280 + ((h >>> 8) & 0xff)]++;
+                histograms[1536 + ((h >>> 16) & 0xff)]++;
+                histograms[1792 + (h >>> 24)]++;
+            }
+
+            for (pass = 0; pass < 8; pass++) {
+                var base = pass * 256;
+                var shift = (pass & 3) * 8;
+                var digits = pass < 4 ? srcLow : srcHigh;
+                if (histograms[base + ((digits[0] >>> shift) & 0xff)] === count) continue;
+
+                var offset = 0;
+                for (i = 0; i < 256; i++) {
+                    var n = histograms[base + i];
+                    histograms[base + i] = offset;
+                    offset += n;
+                }
+
+                for (i = 0; i < count; i++) {
+                    var slot = histograms[base + ((digits[i] >>> shift) & 0xff)]++;
+                    dstHigh[slot] = srcHigh[i];
+                    dstLow[slot] = srcLow[i];
+                    dstIndices[slot] = srcIndices[i];
+                }
+
+                swap = srcHigh; srcHigh = dstHigh; dstHigh = swap;
+                swap = srcLow; srcLow = dstLow; dstLow = swap;
+                swap = srcIndices; srcIndices = dstIndices; dstIndices = swap;
+                this._stats.passes++;
+            }
+
+            // only the order is needed, keep the sorted indices where the caller looks for them
+            if (srcIndices !== this._indices) {
+                this._indices.set(srcIndices.subarray(0, count));
+            }
+        },
+
+        _sort: function (list, count, mode) {
+            var i;
+            var previous = this._previous;
+            this._stats.sorts++;
+
+            if (list.length !== count) {
+                list.length = count;
+            }
+
+            // start from last frame's order if the list holds the same draw calls
+            var stamp = ++sortStamp;
+            for (i = 0; i < count; i++) {
+                list[i]._sortStamp = stamp;
+            }
+            var items = this._items;
+            var same = previous.length === count;
+            for (i = 0; same && i < count; i++) {
+                same = previous[i]._sortStamp === stamp;
+            }
+            var source = same ? previous : list;
+            for (i = 0; i < count; i++) {
+                items[i] = source[i];
+            }
+            items.length = count;
+
+            this._reserve(count);
+            this._fillKeys(items, count, mode);
+
+            var high = this._high;
+            var low = this._low;
+            var descents = 0;
+            for (i = 1; i < count; i++) {
+                if (high[i] < high[i - 1] || (high[i] === high[i - 1] && low[i] < low[i - 1])) {
+                    descents++;
+                }
+            }
+
+            var sorted = descents === 0;
+            if (sorted) {
+                this._stats.presorted++;
+            } else if (count <= INSERTION_MAX_COUNT || descents <= INSERTION_MAX_DESCENTS) {
+                sorted = this._insertionSort(count, count <= INSERTION_MAX_COUNT ? count * count : count * INSERTION_MAX_MOVES);
+                if (sorted) this._stats.insertion++;
+            }
+            if (!sorted) {
+                this._radixSort(count);
+            }
+
+            var indices = this._indices;
+            for (i = 0; i < count; i++) {
+                list[i] = items[indices[i]];
+            }
+
+            previous.length = count;
+            for (i = 0; i < count; i++) {
+                previous[i] = list[i];
+            }
+        },
+
+        /**
+         * @private
+         * @function
+         * @name pc.DrawCallSorter#sort
+         * @description Sorts the first count draw calls of the list, which is truncated to count.
+         * @param {pc.MeshInstance[]} list The draw calls.
+         * @param {Number} count The number of draw calls to sort.
+         * @param {Number} sortMode pc.SORTMODE_MANUAL, pc.SORTMODE_MATERIALMESH, pc.SORTMODE_BACK2FRONT
+         * or pc.SORTMODE_FRONT2BACK. Depths must be calculated for the last two.
+         */
+        sort: function (list, count, sortMode) {
+            this._sort(list, count, sortMode);
+        },
+
+        /**
+         * @private
+         * @function
+         * @name pc.DrawCallSorter#sortShadowCasters
+         * @description Sorts shadow casters by depth key and mesh id, in the order of pc.ForwardRenderer#depthSortCompare.
+         * @param {pc.MeshInstance[]} list The draw calls, truncated to count.
+         * @param {Number} count The number of draw calls to sort.
+         */
+        sortShadowCasters: function (list, count) {
+            this._sort(list, count, SORT_SHADOW);
+        },
+
+        /**
+         * @private
+         * @function
+         * @name pc.DrawCallSorter#clear
+         * @description Forgets the remembered order, e.g. when the list is used for something else.
+         */
+        clear: function () {
+            this._previous.length = 0;
+            this._items.length = 0;
+        }
+    });
+
+    return {
+        DrawCallSorter: DrawCallSorter
+    };
+}());
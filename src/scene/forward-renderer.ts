@@ -54,6 +54,7 @@ namespace pc {
 
     export var frustumDiagonal = new pc.Vec3();
     export var tempSphere = { center: null, radius: 0 };
+    export var tempShadowCameraState = [];
     export var meshPos: any;
     export var visibleSceneAabb = new pc.BoundingBox();
     export var boneTextureSize = [0, 0];
@@ -64,6 +65,8 @@ namespace pc {
 
     export var shadowMapCubeCache = {};
     export var maxBlurSize = 25;
+    // light setups whose splits are cached per mesh and render style
+    export var maxStaticSplits = 8;
 
     export var keyA: any;
     export var keyB: any;
@@ -373,6 +376,7 @@ namespace pc {
         _camerasRendered: number;
         _materialSwitches: number;
         _shadowMapUpdates: number;
+        _shadowMapsReused: number;
         _shadowMapTime: number;
         _depthMapTime: number;
         _forwardTime: number;
@@ -381,6 +385,8 @@ namespace pc {
         _skinTime: number;
         _morphTime: number;
         _instancingTime: number;
+        _instancedDrawCalls: number;
+        _removedByInstancing: number;
 
         constructor(graphicsDevice: any) {
             this.device = graphicsDevice;
@@ -392,6 +398,7 @@ namespace pc {
             this._camerasRendered = 0;
             this._materialSwitches = 0;
             this._shadowMapUpdates = 0;
+            this._shadowMapsReused = 0;
             this._shadowMapTime = 0;
             this._depthMapTime = 0;
             this._forwardTime = 0;
@@ -400,6 +407,12 @@ namespace pc {
             this._skinTime = 0;
             this._morphTime = 0;
             this._instancingTime = 0;
+            this._instancedDrawCalls = 0;
+            this._removedByInstancing = 0;
+
+            // instancing data of the runs found by _prepareAutoInstancing, reused every frame
+            this._autoInstancingData = [];
+            this._autoInstanced = [];
 
             // Shaders
             var library = device.getProgramLibrary();
@@ -544,7 +557,7 @@ namespace pc {
             tempSphere.radius = meshInstance._aabb._radius;
             tempSphere.center = meshPos;
 
-            return camera.frustum.containsSphere(tempSphere);
+            return camera.frustum.containsSphere(tempSphere, meshInstance);
         }
 
         getShadowCamera(device, light) {
@@ -1144,6 +1157,8 @@ namespace pc {
                 morph = drawCalls[i].morphInstance;
                 if (morph && morph._dirty) {
                     morph.updateBounds(drawCalls[i].mesh);
+                    // the world bounds need recomputing even if the node did not move
+                    drawCalls[i]._aabbVer = -1;
                 }
             }
             // #ifdef PROFILER
@@ -1200,7 +1215,7 @@ namespace pc {
             instancingData = meshInstance.instancingData;
             if (instancingData) {
                 this._instancedDrawCalls++;
-                this._removedByInstancing += instancingData.count;
+                this._removedByInstancing += instancingData.count - 1;
                 device.setVertexBuffer(instancingData._buffer, 1, instancingData.offset);
                 device.draw(mesh.primitive[style], instancingData.count);
                 if (instancingData._buffer === pc._autoInstanceBuffer) {
@@ -1231,7 +1246,7 @@ namespace pc {
             instancingData = meshInstance.instancingData;
             if (instancingData) {
                 this._instancedDrawCalls++;
-                this._removedByInstancing += instancingData.count;
+                this._removedByInstancing += instancingData.count - 1;
                 device.setVertexBuffer(instancingData._buffer, 1, instancingData.offset);
                 device.draw(mesh.primitive[style], instancingData.count);
                 if (instancingData._buffer === pc._autoInstanceBuffer) {
@@ -1245,6 +1260,112 @@ namespace pc {
             }
         }
 
+        // the shadow camera state a shadow map pass is rendered from
+        _getShadowCameraState(light, shadowCam, state) {
+            var node = shadowCam._node;
+            var p = node.getPosition();
+            var r = node.getRotation();
+            state[0] = p.x;
+            state[1] = p.y;
+            state[2] = p.z;
+            state[3] = r.x;
+            state[4] = r.y;
+            state[5] = r.z;
+            state[6] = r.w;
+            state[7] = shadowCam.orthoHeight;
+            state[8] = shadowCam.nearClip;
+            state[9] = shadowCam.farClip;
+            state[10] = shadowCam.fov;
+            state[11] = light.shadowBias;
+            state[12] = light._shadowType;
+            state[13] = light._vsmBlurSize;
+            return state;
+        }
+
+        // True when rendering a shadow map pass again would produce what the map holds: the shadow
+        // camera and the casters (same draw calls, node transforms, mesh buffers and materials) did
+        // not change since the pass was rendered, and nothing else rendered into the map in the
+        // meantime, as directional lights seen by several cameras or pooled shadow maps do. Skinned
+        // and morphed casters change without their node moving, they always need the pass rendered.
+        _isShadowMapCurrent(light, pass, shadowCam, visibleList, visibleLength) {
+            var entry = light._shadowCache[pass];
+            var target = shadowCam.renderTarget;
+            if (!entry || !target || target._shadowCacheEntry !== entry) return false;
+
+            var state = this._getShadowCameraState(light, shadowCam, tempShadowCameraState);
+            var i;
+            for (i = 0; i < state.length; i++) {
+                if (entry.camera[i] !== state[i]) return false;
+            }
+
+            if (entry.casters.length !== visibleLength) return false;
+            for (i = 0; i < visibleLength; i++) {
+                var meshInstance = visibleList[i];
+                var mesh = meshInstance.mesh;
+                var material = meshInstance.material;
+                if (entry.casters[i] !== meshInstance._id ||
+                    entry.versions[i] !== meshInstance.node._aabbVer ||
+                    entry.aabbVersions[i] !== meshInstance._aabbVer ||
+                    entry.materials[i] !== material.id ||
+                    entry.materialVersions[i] !== material._version ||
+                    entry.meshes[i] !== mesh.id ||
+                    entry.vertexVersions[i] !== this._getShadowVertexVersion(mesh) ||
+                    entry.indexVersions[i] !== this._getShadowIndexVersion(meshInstance) ||
+                    meshInstance.skinInstance || meshInstance.morphInstance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        _getShadowVertexVersion(mesh) {
+            return mesh.vertexBuffer ? mesh.vertexBuffer._version : 0;
+        }
+
+        _getShadowIndexVersion(meshInstance) {
+            var indexBuffer = meshInstance.mesh.indexBuffer[meshInstance.renderStyle];
+            return indexBuffer ? indexBuffer._version : 0;
+        }
+
+        // Remembers what the pass is rendered from for _isShadowMapCurrent. The entry keeps ids and
+        // versions rather than the casters, meshes and materials themselves, so a light does not
+        // keep removed casters alive.
+        _storeShadowMapState(light, pass, shadowCam, visibleList, visibleLength) {
+            var entry = light._shadowCache[pass];
+            if (!entry) {
+                entry = light._shadowCache[pass] = {
+                    camera: [],
+                    casters: [],
+                    versions: [],
+                    aabbVersions: [],
+                    materials: [],
+                    materialVersions: [],
+                    meshes: [],
+                    vertexVersions: [],
+                    indexVersions: []
+                };
+            }
+
+            this._getShadowCameraState(light, shadowCam, entry.camera);
+            entry.casters.length = entry.versions.length = entry.aabbVersions.length = visibleLength;
+            entry.materials.length = entry.materialVersions.length = visibleLength;
+            entry.meshes.length = entry.vertexVersions.length = entry.indexVersions.length = visibleLength;
+            for (var i = 0; i < visibleLength; i++) {
+                var meshInstance = visibleList[i];
+                entry.casters[i] = meshInstance._id;
+                entry.versions[i] = meshInstance.node._aabbVer;
+                entry.aabbVersions[i] = meshInstance._aabbVer;
+                entry.materials[i] = meshInstance.material.id;
+                entry.materialVersions[i] = meshInstance.material._version;
+                entry.meshes[i] = meshInstance.mesh.id;
+                entry.vertexVersions[i] = this._getShadowVertexVersion(meshInstance.mesh);
+                entry.indexVersions[i] = this._getShadowIndexVersion(meshInstance);
+            }
+
+            // the map now holds this pass
+            shadowCam.renderTarget._shadowCacheEntry = entry;
+        }
+
         renderShadows(lights, cameraPass) {
             var device = this.device;
             // #ifdef PROFILER
@@ -1256,6 +1377,7 @@ namespace pc {
             var style;
             var settings;
             var visibleList, visibleLength;
+            var rendered;
 
             var passFlag = 1 << pc.SHADER_SHADOW;
             var paramName, parameter, parameters;
@@ -1331,8 +1453,6 @@ namespace pc {
 
                     if (light.shadowUpdateMode === pc.SHADOWUPDATE_THISFRAME) light.shadowUpdateMode = pc.SHADOWUPDATE_NONE;
 
-                    this._shadowMapUpdates += passes;
-
                     // Set standard shadowmap states
                     device.setBlending(false);
                     device.setDepthWrite(true);
@@ -1349,17 +1469,34 @@ namespace pc {
                         pass = 0; // point light passes
                     }
 
+                    rendered = 0;
                     while (pass < passes) {
                         if (type === pc.LIGHTTYPE_POINT) {
                             shadowCamNode.setRotation(pointLightRotations[pass]);
                             shadowCam.renderTarget = light._shadowCubeMap[pass];
                         }
 
-                        this.setCamera(shadowCam, shadowCam.renderTarget, true, type !== pc.LIGHTTYPE_POINT);
-
                         visibleList = light._visibleList[pass];
                         visibleLength = light._visibleLength[pass];
 
+                        if (light.shadowUpdateMode === pc.SHADOWUPDATE_ONCHANGE) {
+                            if (this._isShadowMapCurrent(light, pass, shadowCam, visibleList, visibleLength)) {
+                                this._shadowMapsReused++;
+                                pass++;
+                                if (type === pc.LIGHTTYPE_DIRECTIONAL) light._visibleLength[cameraPass] = -1;
+                                continue;
+                            }
+                            this._storeShadowMapState(light, pass, shadowCam, visibleList, visibleLength);
+                        } else if (shadowCam.renderTarget) {
+                            // the map is shared with other lights (pooled maps, the lightmapper), it
+                            // no longer holds the pass they stored
+                            shadowCam.renderTarget._shadowCacheEntry = null;
+                        }
+                        rendered++;
+                        this._shadowMapUpdates++;
+
+                        this.setCamera(shadowCam, shadowCam.renderTarget, true, type !== pc.LIGHTTYPE_POINT);
+
                         // Sort shadow casters
                         shadowType = light._shadowType;
                         smode = shadowType + type * numShadowModes;
@@ -1425,7 +1562,8 @@ namespace pc {
                         if (type === pc.LIGHTTYPE_DIRECTIONAL) light._visibleLength[cameraPass] = -1; // prevent light from rendering more than once for this camera
                     } // end pass
 
-                    if (light._isVsm) {
+                    // a reused map was blurred when it was rendered
+                    if (light._isVsm && rendered > 0) {
                         var filterSize = light._vsmBlurSize;
                         if (filterSize > 1) {
                             var origShadowMap = shadowCam.renderTarget;
@@ -1511,9 +1649,15 @@ namespace pc {
             var prevMaterial = null, prevObjDefs, prevLightMask, prevStatic;
             var paramName, parameter, parameters;
             var stencilFront, stencilBack;
+            var shader, autoInstanced;
 
             var halfWidth = device.width * 0.5;
 
+            var autoInstancing = device.enableAutoInstancing && !drawCallback && !(vrDisplay && vrDisplay.presenting);
+            if (autoInstancing) {
+                this._prepareAutoInstancing(drawCalls, drawCallsCount, cullingMask);
+            }
+
             // Render the scene
             for (i = 0; i < drawCallsCount; i++) {
 
@@ -1542,6 +1686,12 @@ namespace pc {
                     objDefs = drawCall._shaderDefs;
                     lightMask = drawCall.mask;
 
+                    // the different objDefs also make a run switch shaders like a new material would
+                    autoInstanced = drawCall.instancingData && drawCall.instancingData._buffer === pc._autoInstanceBuffer;
+                    if (autoInstanced) {
+                        objDefs |= pc.SHADERDEF_INSTANCING;
+                    }
+
                     this.setSkinning(device, drawCall, material);
 
                     if (material && material === prevMaterial && objDefs !== prevObjDefs) {
@@ -1560,28 +1710,43 @@ namespace pc {
                             material.dirty = false;
                         }
 
-                        if (!drawCall._shader[pass] || drawCall._shaderDefs !== objDefs || drawCall._lightHash !== lightHash) {
-                            if (!drawCall.isStatic) {
-                                variantKey = pass + "_" + objDefs + "_" + lightHash;
-                                drawCall._shader[pass] = material.variants[variantKey];
-                                if (!drawCall._shader[pass]) {
-                                    this.updateShader(drawCall, objDefs, null, pass, sortedLights);
-                                    material.variants[variantKey] = drawCall._shader[pass];
+                        if (autoInstanced) {
+                            // the instanced variant is not kept on the mesh instance, which is
+                            // drawn alone when it is not part of a run
+                            variantKey = pass + "_" + objDefs + "_" + lightHash;
+                            shader = material.variants[variantKey];
+                            if (!shader) {
+                                shader = drawCall._shader[pass];
+                                this.updateShader(drawCall, objDefs, null, pass, sortedLights);
+                                material.variants[variantKey] = drawCall._shader[pass];
+                                drawCall._shader[pass] = shader;
+                                shader = material.variants[variantKey];
+                            }
+                        } else {
+                            if (!drawCall._shader[pass] || drawCall._shaderDefs !== objDefs || drawCall._lightHash !== lightHash) {
+                                if (!drawCall.isStatic) {
+                                    variantKey = pass + "_" + objDefs + "_" + lightHash;
+                                    drawCall._shader[pass] = material.variants[variantKey];
+                                    if (!drawCall._shader[pass]) {
+                                        this.updateShader(drawCall, objDefs, null, pass, sortedLights);
+                                        material.variants[variantKey] = drawCall._shader[pass];
+                                    }
+                                } else {
+                                    this.updateShader(drawCall, objDefs, drawCall._staticLightList, pass, sortedLights);
                                 }
-                            } else {
-                                this.updateShader(drawCall, objDefs, drawCall._staticLightList, pass, sortedLights);
+                                drawCall._shaderDefs = objDefs;
+                                drawCall._lightHash = lightHash;
                             }
-                            drawCall._shaderDefs = objDefs;
-                            drawCall._lightHash = lightHash;
+                            shader = drawCall._shader[pass];
                         }
 
                         // #ifdef DEBUG
-                        if (!device.setShader(drawCall._shader[pass])) {
+                        if (!device.setShader(shader)) {
                             console.error('Error in material "' + material.name + '" with flags ' + objDefs);
                             drawCall.material = scene.defaultMaterial;
                         }
                         // #else
-                        device.setShader(drawCall._shader[pass]);
+                        device.setShader(shader);
                         // #endif
 
                         // Uniforms I: material
@@ -1745,11 +1910,100 @@ namespace pc {
             }
             device.updateEnd();
 
+            if (autoInstancing) {
+                // runs that were skipped must not keep their instancing data into the next frame
+                for (i = 0; i < this._autoInstanced.length; i++) {
+                    this._autoInstanced[i].instancingData = null;
+                }
+                this._autoInstanced.length = 0;
+            }
+
             // #ifdef PROFILER
             this._forwardTime += pc.now() - forwardStartTime;
             // #endif
         }
 
+        _isAutoInstanceable(drawCall, cullingMask) {
+            var paramName;
+            if (drawCall.command || drawCall.instancingData || drawCall.skinInstance || drawCall.morphInstance ||
+                drawCall.isStatic || drawCall.stencilFront || drawCall.stencilBack) {
+                return false;
+            }
+            if (cullingMask && drawCall.mask && !(cullingMask & drawCall.mask)) {
+                return false;
+            }
+            // only the standard material has an instanced shader variant
+            if (!(drawCall.material instanceof pc.StandardMaterial)) {
+                return false;
+            }
+            // per instance parameters cannot be applied to the other instances of a run
+            for (paramName in drawCall.parameters) {
+                return false;
+            }
+            return true;
+        }
+
+        // Finds runs of sorted draw calls that share mesh, material and shader variant, and gives
+        // the first of each run instancing data in the auto instance buffer, so that drawInstance
+        // draws the run with one instanced draw call and skips the rest of it. The world matrices
+        // of all runs are copied into the buffer and uploaded once.
+        _prepareAutoInstancing(drawCalls, drawCallsCount, cullingMask) {
+            // #ifdef PROFILER
+            var instancingTime = pc.now();
+            // #endif
+
+            if (!pc._autoInstanceBuffer) {
+                this.setupInstancing(this.device);
+            }
+
+            var data = pc._autoInstanceBufferData;
+            var maxObjects = this.device.autoInstancingMaxObjects;
+            var used = 0;
+            var runs = 0;
+            var i, j, k, first, next, instancingData;
+
+            for (i = 0; i < drawCallsCount; i = j) {
+                first = drawCalls[i];
+                j = i + 1;
+                if (!this._isAutoInstanceable(first, cullingMask)) continue;
+
+                while (j < drawCallsCount && used + j - i < maxObjects) {
+                    next = drawCalls[j];
+                    if (next.mesh !== first.mesh || next.material !== first.material || next.renderStyle !== first.renderStyle ||
+                        next._shaderDefs !== first._shaderDefs || next.mask !== first.mask || !this._isAutoInstanceable(next, cullingMask)) {
+                        break;
+                    }
+                    j++;
+                }
+                if (j - i < 2) continue;
+
+                for (k = i; k < j; k++) {
+                    data.set(drawCalls[k].node.worldTransform.data, (used + k - i) * 16);
+                }
+
+                instancingData = this._autoInstancingData[runs];
+                if (!instancingData) {
+                    instancingData = this._autoInstancingData[runs] = { count: 0, offset: 0, _buffer: null };
+                }
+                instancingData.count = j - i;
+                instancingData.offset = used * 64; // bytes, 16 floats per instance
+                instancingData._buffer = pc._autoInstanceBuffer;
+                first.instancingData = instancingData;
+                this._autoInstanced.push(first);
+
+                used += j - i;
+                runs++;
+            }
+
+            if (runs > 0) {
+                pc._autoInstanceBuffer.unlock();
+            }
+
+            // #ifdef PROFILER
+            this._instancingTime += pc.now() - instancingTime;
+            // #endif
+        }
+
         setupInstancing(device) {
             if (!pc._instanceVertexFormat) {
                 var formatDesc = [
@@ -1806,6 +2060,7 @@ namespace pc {
             var subWriteMeshTime = 0;
             var combineTime = 0;
             var subCombineTime = 0;
+            var cacheHits = 0;
             // #endif
 
             var i, j, k, v, s, index;
@@ -1835,8 +2090,9 @@ namespace pc {
             var aabb;
             var triBounds = [];
             var staticLights = [];
+            var localBounds = [];
+            var splitKey, splitCache, split;
             var bit;
-            var lht;
             for (i = 0; i < drawCallsCount; i++) {
                 drawCall = drawCalls[i];
                 if (!drawCall.isStatic) {
@@ -1875,6 +2131,38 @@ namespace pc {
                     }
 
                     mesh = drawCall.mesh;
+
+                    // light boxes in the local space of the mesh decide the split, so they also key
+                    // the splits cached on the mesh, reused when the layer is prepared again
+                    invMatrix.copy(drawCall.node.worldTransform).invert();
+                    splitKey = "";
+                    localBounds.length = staticLights.length * 6;
+                    for (s = 0; s < staticLights.length; s++) {
+                        localLightBounds.setFromTransformedAabb(lightAabb[staticLights[s]], invMatrix);
+                        minv = localLightBounds.getMin();
+                        maxv = localLightBounds.getMax();
+                        index = s * 6;
+                        localBounds[index] = minv.x;
+                        localBounds[index + 1] = minv.y;
+                        localBounds[index + 2] = minv.z;
+                        localBounds[index + 3] = maxv.x;
+                        localBounds[index + 4] = maxv.y;
+                        localBounds[index + 5] = maxv.z;
+                        splitKey += localBounds.slice(index, index + 6).join(",") + ";";
+                    }
+
+                    splitCache = this._getStaticSplitCache(mesh, drawCall.renderStyle);
+                    split = splitCache.splits[splitKey];
+                    if (split) {
+                        // #ifdef PROFILER
+                        cacheHits++;
+                        // #endif
+                        this._addStaticSplit(drawCall, split, staticLights, lights, newDrawCalls);
+                        continue;
+                    }
+                    split = splitCache.splits[splitKey] = [];
+                    splitCache.count++;
+
                     vertexBuffer = mesh.vertexBuffer;
                     indexBuffer = mesh.indexBuffer[drawCall.renderStyle];
                     indices = indexBuffer.bytesPerIndex === 2 ? new Uint16Array(indexBuffer.lock()) : new Uint32Array(indexBuffer.lock());
@@ -1938,20 +2226,19 @@ namespace pc {
                     subSearchTime = pc.now();
                     // #endif
                     for (s = 0; s < staticLights.length; s++) {
-                        j = staticLights[s];
-                        light = lights[j];
-
-                        invMatrix.copy(drawCall.node.worldTransform).invert();
-                        localLightBounds.setFromTransformedAabb(lightAabb[j], invMatrix);
-                        minv = localLightBounds.getMin();
-                        maxv = localLightBounds.getMax();
+                        minx = localBounds[s * 6];
+                        miny = localBounds[s * 6 + 1];
+                        minz = localBounds[s * 6 + 2];
+                        maxx = localBounds[s * 6 + 3];
+                        maxy = localBounds[s * 6 + 4];
+                        maxz = localBounds[s * 6 + 5];
                         bit = 1 << s;
 
                         for (k = 0; k < numTris; k++) {
                             index = k * 6;
-                            if ((triBounds[index] <= maxv.x) && (triBounds[index + 3] >= minv.x) &&
-                                (triBounds[index + 1] <= maxv.y) && (triBounds[index + 4] >= minv.y) &&
-                                (triBounds[index + 2] <= maxv.z) && (triBounds[index + 5] >= minv.z)) {
+                            if ((triBounds[index] <= maxx) && (triBounds[index + 3] >= minx) &&
+                                (triBounds[index + 1] <= maxy) && (triBounds[index + 4] >= miny) &&
+                                (triBounds[index + 2] <= maxz) && (triBounds[index + 5] >= minz)) {
 
                                 // triLightComb[k] += j + "_";  // uncomment to remove 32 lights limit
                                 triLightComb[k] |= bit; // comment to remove 32 lights limit
@@ -2027,54 +2314,15 @@ namespace pc {
                             mesh2.primitive[0].indexed = true;
                             mesh2.aabb = chunkAabb;
 
-                            var instance = new pc.MeshInstance(drawCall.node, mesh2, drawCall.material);
-                            instance.isStatic = drawCall.isStatic;
-                            instance.visible = drawCall.visible;
-                            instance.layer = drawCall.layer;
-                            instance.castShadow = drawCall.castShadow;
-                            instance._receiveShadow = drawCall._receiveShadow;
-                            instance.cull = drawCall.cull;
-                            instance.pick = drawCall.pick;
-                            instance.mask = drawCall.mask;
-                            instance.parameters = drawCall.parameters;
-                            instance._shaderDefs = drawCall._shaderDefs;
-                            instance._staticSource = drawCall;
-
-                            if (drawCall._staticLightList) {
-                                instance._staticLightList = drawCall._staticLightList; // add forced assigned lights
-                            } else {
-                                instance._staticLightList = [];
-                            }
-
-                            // uncomment to remove 32 lights limit
-                            // var lnames = combIbName.split("_");
-                            // lnames.length = lnames.length - 1;
-                            // for(k = 0; k < lnames.length; k++) {
-                            //     instance._staticLightList[k] = lights[parseInt(lnames[k])];
-                            // }
-
-                            // comment to remove 32 lights limit
-                            for (k = 0; k < staticLights.length; k++) {
-                                bit = 1 << k;
-                                if (combIbName & bit) {
-                                    lht = lights[staticLights[k]];
-                                    if (instance._staticLightList.indexOf(lht) < 0) {
-                                        instance._staticLightList.push(lht);
-                                    }
-                                }
-                            }
-
-                            instance._staticLightList.sort(this.lightCompare);
-
-                            newDrawCalls.push(instance);
+                            split.push({ mask: combIbName | 0, mesh: mesh2 });
                         }
 
                         // #ifdef PROFILER
                         writeMeshTime += pc.now() - subWriteMeshTime;
                         // #endif
-                    } else {
-                        newDrawCalls.push(drawCall);
                     }
+
+                    this._addStaticSplit(drawCall, split, staticLights, lights, newDrawCalls);
                 }
             }
             // Set array to new
@@ -2088,9 +2336,78 @@ namespace pc {
             scene._stats.lastStaticPrepareWriteTime = writeMeshTime;
             scene._stats.lastStaticPrepareTriAabbTime = triAabbTime;
             scene._stats.lastStaticPrepareCombineTime = combineTime;
+            scene._stats.lastStaticPrepareCacheHits = cacheHits;
             // #endif
         }
 
+        // Splits of a mesh render style, by local light bounds. The cache starts over when the mesh
+        // buffers were uploaded again, and when it holds maxStaticSplits light setups, as lights that
+        // keep moving make a new key every time the layer is prepared.
+        _getStaticSplitCache(mesh, renderStyle) {
+            var indexBuffer = mesh.indexBuffer[renderStyle];
+            var vertexVersion = mesh.vertexBuffer ? mesh.vertexBuffer._version : 0;
+            var indexVersion = indexBuffer ? indexBuffer._version : 0;
+
+            if (!mesh._staticSplits) mesh._staticSplits = [];
+            var cache = mesh._staticSplits[renderStyle];
+            if (!cache || cache.vertexVersion !== vertexVersion || cache.indexVersion !== indexVersion ||
+                cache.count >= maxStaticSplits) {
+                cache = mesh._staticSplits[renderStyle] = {
+                    vertexVersion: vertexVersion,
+                    indexVersion: indexVersion,
+                    count: 0,
+                    splits: {}
+                };
+            }
+            return cache;
+        }
+
+        // adds an instance per chunk of a split static mesh, or the mesh instance itself when no light
+        // touched any of its triangles
+        _addStaticSplit(drawCall, split, staticLights, lights, newDrawCalls) {
+            var i, k, bit, lht, instance;
+
+            if (split.length === 0) {
+                newDrawCalls.push(drawCall);
+                return;
+            }
+
+            for (i = 0; i < split.length; i++) {
+                instance = new pc.MeshInstance(drawCall.node, split[i].mesh, drawCall.material);
+                instance.isStatic = drawCall.isStatic;
+                instance.visible = drawCall.visible;
+                instance.layer = drawCall.layer;
+                instance.castShadow = drawCall.castShadow;
+                instance._receiveShadow = drawCall._receiveShadow;
+                instance.cull = drawCall.cull;
+                instance.pick = drawCall.pick;
+                instance.mask = drawCall.mask;
+                instance.parameters = drawCall.parameters;
+                instance._shaderDefs = drawCall._shaderDefs;
+                instance._staticSource = drawCall;
+
+                if (drawCall._staticLightList) {
+                    instance._staticLightList = drawCall._staticLightList.slice(); // add forced assigned lights
+                } else {
+                    instance._staticLightList = [];
+                }
+
+                for (k = 0; k < staticLights.length; k++) {
+                    bit = 1 << k;
+                    if (split[i].mask & bit) {
+                        lht = lights[staticLights[k]];
+                        if (instance._staticLightList.indexOf(lht) < 0) {
+                            instance._staticLightList.push(lht);
+                        }
+                    }
+                }
+
+                instance._staticLightList.sort(this.lightCompare);
+
+                newDrawCalls.push(instance);
+            }
+        }
+
         updateShaders(drawCalls) {
             // #ifdef PROFILER
             var time = pc.now();
@@ -2203,6 +2520,7 @@ namespace pc {
                 layer._skipRenderCounter = 0;
                 layer._forwardDrawCalls = 0;
                 layer._shadowDrawCalls = 0;
+                layer._removedByInstancing = 0;
                 layer._renderTime = 0;
                 // #endif
 
@@ -2236,7 +2554,7 @@ namespace pc {
 
                 // Generate static lighting for meshes in this layer if needed
                 if (layer._needsStaticPrepare && layer._staticLightHash) {
-                    // TODO: reuse with the same staticLightHash
+                    // splits are cached on the meshes, so preparing again with the same lights is cheap
                     if (layer._staticPrepareDone) {
                         this.revertStaticMeshes(layer.opaqueMeshInstances);
                         this.revertStaticMeshes(layer.transparentMeshInstances);
@@ -2251,6 +2569,15 @@ namespace pc {
             }
         }
 
+        // one sorter per shadow pass, so each keeps the order of the casters it sorted last frame
+        _getShadowSorter(light, pass) {
+            var sorter = light._visibleSorters[pass];
+            if (!sorter) {
+                sorter = light._visibleSorters[pass] = new pc.DrawCallSorter();
+            }
+            return sorter;
+        }
+
         cullLocalShadowmap(light, drawCalls) {
             var i, type, shadowCam, shadowCamNode, passes, pass, numInstances, meshInstance, visibleList, vlen, visible;
             var lightNode;
@@ -2308,10 +2635,7 @@ namespace pc {
                 }
                 light._visibleLength[pass] = vlen;
 
-                if (visibleList.length !== vlen) {
-                    visibleList.length = vlen;
-                }
-                visibleList.sort(this.depthSortCompare); // sort shadowmap drawcalls here, not in render
+                this._getShadowSorter(light, pass).sortShadowCasters(visibleList, vlen); // sort shadowmap drawcalls here, not in render
             }
         }
 
@@ -2420,10 +2744,7 @@ namespace pc {
             }
             light._visibleLength[pass] = vlen;
 
-            if (visibleList.length !== vlen) {
-                visibleList.length = vlen;
-            }
-            visibleList.sort(this.depthSortCompare); // sort shadowmap drawcalls here, not in render
+            this._getShadowSorter(light, pass).sortShadowCasters(visibleList, vlen); // sort shadowmap drawcalls here, not in render
 
             // Positioning directional light frustum II
             // Fit clipping planes tightly around visible shadow casters
@@ -2681,7 +3002,7 @@ namespace pc {
             // Rendering
             renderedLength = 0;
             var cameraPass;
-            var sortTime, draws, drawTime;
+            var sortTime, draws, removed, drawTime;
             for (i = 0; i < comp._renderList.length; i++) {
                 layer = comp.layerList[comp._renderList[i]];
                 if (!layer.enabled || !comp.subLayerEnabled[comp._renderList[i]]) continue;
@@ -2761,6 +3082,7 @@ namespace pc {
 
                     // #ifdef PROFILER
                     draws = this._forwardDrawCalls;
+                    removed = this._removedByInstancing;
                     // #endif
                     this.renderForward(camera.camera,
                                        visible.list,
@@ -2772,6 +3094,7 @@ namespace pc {
                                        layer);
                     // #ifdef PROFILER
                     layer._forwardDrawCalls += this._forwardDrawCalls - draws;
+                    layer._removedByInstancing += this._removedByInstancing - removed;
                     // #endif
 
                     // Revert temp frame stuff
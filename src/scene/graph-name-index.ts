@@ -0,0 +1,111 @@
+namespace pc {
+
+    /**
+     * @private
+     * @constructor
+     * @name pc.GraphNameIndex
+     * @classdesc Hashed index of the names of every node in a hierarchy, used by
+     * {@link pc.GraphNode#findByName}. Created by {@link pc.GraphNode#enableNameIndex} and kept up
+     * to date when nodes are added, removed or renamed.
+     * @param {pc.GraphNode} root The top node of the indexed hierarchy.
+     */
+    export class GraphNameIndex {
+        root: GraphNode;
+        // name hash -> nodes with that hash, unordered
+        _nodes: { [hash: number]: GraphNode[] };
+
+        constructor(root: GraphNode) {
+            this.root = root;
+            this._nodes = {};
+
+            this.addHierarchy(root);
+        }
+
+        add(node: GraphNode): void {
+            var list = this._nodes[node._nameHash];
+            if (!list) {
+                list = [];
+                this._nodes[node._nameHash] = list;
+            }
+
+            node._nameIndex = this;
+            node._nameIndexSlot = list.length;
+            list.push(node);
+        }
+
+        remove(node: GraphNode): void {
+            var list = this._nodes[node._nameHash];
+
+            // swap with the last entry, nodes often share a name ("Untitled")
+            var last = list.pop();
+            if (last !== node) {
+                list[node._nameIndexSlot] = last;
+                last._nameIndexSlot = node._nameIndexSlot;
+            }
+            if (list.length === 0)
+                delete this._nodes[node._nameHash];
+
+            node._nameIndex = null;
+            node._nameIndexSlot = -1;
+        }
+
+        addHierarchy(node: GraphNode): void {
+            this.add(node);
+
+            var children = node._children;
+            for (var i = 0, len = children.length; i < len; i++) {
+                this.addHierarchy(children[i]);
+            }
+        }
+
+        removeHierarchy(node: GraphNode): void {
+            if (node._nameIndex !== this)
+                return;
+
+            this.remove(node);
+
+            var children = node._children;
+            for (var i = 0, len = children.length; i < len; i++) {
+                this.removeHierarchy(children[i]);
+            }
+        }
+
+        /**
+         * @private
+         * @function
+         * @name pc.GraphNameIndex#find
+         * @description Looks up the nodes called name in the hierarchy under scope (inclusive).
+         * @param {pc.GraphNode} scope An indexed node to search under.
+         * @param {String} name The name to look for.
+         * @returns {pc.GraphNode} The node when there is exactly one match, null when there is none
+         * and undefined when there are several, in which case only a depth first search can tell
+         * which comes first.
+         */
+        find(scope: GraphNode, name: string): GraphNode | null | undefined {
+            var list = this._nodes[pc.hashCode(name)];
+            if (!list)
+                return null;
+
+            var found = null;
+            for (var i = 0, len = list.length; i < len; i++) {
+                var node = list[i];
+                if (node._name !== name)
+                    continue;
+
+                if (scope !== this.root) {
+                    var parent = node;
+                    while (parent && parent !== scope)
+                        parent = parent._parent;
+                    if (!parent)
+                        continue;
+                }
+
+                if (found)
+                    return undefined;
+                found = node;
+            }
+
+            return found;
+        }
+    }
+}
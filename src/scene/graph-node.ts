@@ -14,7 +14,13 @@ namespace pc {
      * @property {pc.Tags} tags Interface for tagging graph nodes. Tag based searches can be performed using the {@link pc.GraphNode#findByTag} function.
      */
     export class GraphNode {
-        name: string;
+        _name: string;
+        _nameHash: number;
+        _nameIndex: GraphNameIndex | null;
+        _nameIndexSlot: number;
+        _childNames: { [hash: number]: GraphNode } | null;
+        _tagIndex: GraphTagIndex | null;
+        _tagIndexSlots: { [bit: number]: number } | null;
         tags: Tags;
         _labels: any;
         localPosition: Vec3;
@@ -31,6 +37,8 @@ namespace pc {
         _dirtyWorld: boolean;
         normalMatrix: Mat3;
         _dirtyNormal: boolean;
+        _syncQueued: boolean;
+        _syncChildren: boolean;
         _right: any;
         _up: any;
         _forward: any;
@@ -53,6 +61,15 @@ namespace pc {
         tmpQuat = new pc.Quat();
 
         constructor(name?: string) {
+            // Optional name index shared by the whole hierarchy (see enableNameIndex)
+            this._nameIndex = null;
+            this._nameIndexSlot = -1;
+            // First child per name hash, built on demand by findByPath
+            this._childNames = null;
+            // Optional tag index shared by the whole hierarchy (see enableTagIndex)
+            this._tagIndex = null;
+            this._tagIndexSlots = null;
+
             this.name = typeof name === "string" ? name : "Untitled"; // Non-unique human readable name
             this.tags = new pc.Tags(this);
 
@@ -79,6 +96,12 @@ namespace pc {
             this.normalMatrix = new pc.Mat3();
             this._dirtyNormal = true;
 
+            // Set while the node has an entry in the application's sync queue
+            this._syncQueued = false;
+            // Set when the node was synced on its own (see getWorldTransform) while its children are
+            // still dirty, so that syncHierarchy keeps descending through it
+            this._syncChildren = false;
+
             this._right = null;
             this._up = null;
             this._forward = null;
@@ -93,6 +116,27 @@ namespace pc {
             this.scaleCompensation = false;
         };
 
+        get name(): string {
+            return this._name;
+        }
+        set name(name: string) {
+            if (this._name === name)
+                return;
+
+            var index = this._nameIndex;
+            if (index)
+                index.remove(this);
+
+            this._name = name;
+            // names set to something else than a string never match a path, they share a fixed hash
+            this._nameHash = typeof name === 'string' ? pc.hashCode(name) : 0;
+
+            if (index)
+                index.add(this);
+            if (this._parent)
+                this._parent._childNames = null;
+        }
+
         _notifyHierarchyStateChanged(node: any, enabled: boolean) {
             node._onHierarchyStateChanged(enabled);
 
@@ -305,20 +349,23 @@ namespace pc {
          * var meatEatingMammalsAndReptiles = node.findByTag([ "carnivore", "mammal" ], [ "carnivore", "reptile" ]);
          */
         findByTag() {
-            var tags = this.tags._processArguments(arguments);
-            return this._findByTag(tags);
+            var query = new pc.TagsQuery(this.tags._processArguments(arguments));
+            if (this._tagIndex)
+                return this._tagIndex.find(this, query);
+
+            return this._findByTag(query);
         }
 
-        _findByTag(tags: Tags) {
+        _findByTag(query: TagsQuery) {
             var result = [];
             var i, len = this._children.length;
             var descendants;
 
             for (i = 0; i < len; i++) {
-                if (this._children[i].tags._has(tags))
+                if (this._children[i].tags._has(query))
                     result.push(this._children[i]);
 
-                descendants = this._children[i]._findByTag(tags);
+                descendants = this._children[i]._findByTag(query);
                 if (descendants.length)
                     result = result.concat(descendants);
             }
@@ -330,20 +377,86 @@ namespace pc {
          * @function
          * @name pc.GraphNode#findByName
          * @description Get the first node found in the graph with the name. The search
-         * is depth first.
+         * is depth first. When the hierarchy has a name index (see {@link pc.GraphNode#enableNameIndex})
+         * names that occur once are looked up directly.
          * @param {String} name The name of the graph.
          * @returns {pc.GraphNode} The first node to be found matching the supplied name.
          */
         findByName(name: string): GraphNode | null {
-            if (this.name === name) return this;
+            if (this._nameIndex) {
+                var node = this._nameIndex.find(this, name);
+                if (node !== undefined)
+                    return node;
+            }
+
+            return this._findByName(name);
+        }
+
+        _findByName(name: string): GraphNode | null {
+            if (this._name === name) return this;
 
             for (var i = 0; i < this._children.length; i++) {
-                var found = this._children[i].findByName(name);
+                var found = this._children[i]._findByName(name);
                 if (found !== null) return found;
             }
             return null;
         }
 
+        /**
+         * @function
+         * @name pc.GraphNode#enableNameIndex
+         * @description Builds a hashed index of the names of this node and all of its descendants,
+         * which speeds up {@link pc.GraphNode#findByName} on any node of the hierarchy.
+         * The index is kept up to date when nodes are added, removed or renamed, which makes those
+         * operations a little slower. Does nothing if the node is already indexed.
+         * @example
+         * // Index a character before looking up its bones
+         * character.enableNameIndex();
+         * var hand = character.findByName('hand_r');
+         */
+        enableNameIndex(): void {
+            if (!this._nameIndex)
+                new pc.GraphNameIndex(this);
+        }
+
+        /**
+         * @function
+         * @name pc.GraphNode#enableTagIndex
+         * @description Builds an index from tags to the nodes of this hierarchy that have them, so that
+         * {@link pc.GraphNode#findByTag} on any node of the hierarchy only looks at nodes carrying the
+         * queried tags instead of walking the whole hierarchy. The index is kept up to date when nodes
+         * are added or removed and when tags change. Does nothing if the node is already indexed.
+         * @example
+         * app.root.enableTagIndex();
+         * var enemies = app.root.findByTag('enemy');
+         */
+        enableTagIndex(): void {
+            if (!this._tagIndex)
+                new pc.GraphTagIndex(this);
+        }
+
+        /**
+         * @function
+         * @name pc.GraphNode#disableTagIndex
+         * @description Removes a tag index created by {@link pc.GraphNode#enableTagIndex} on this node.
+         */
+        disableTagIndex(): void {
+            var index = this._tagIndex;
+            if (index && index.root === this)
+                index.removeHierarchy(this);
+        }
+
+        /**
+         * @function
+         * @name pc.GraphNode#disableNameIndex
+         * @description Removes a name index created by {@link pc.GraphNode#enableNameIndex} on this node.
+         */
+        disableNameIndex(): void {
+            var index = this._nameIndex;
+            if (index && index.root === this)
+                index.removeHierarchy(this);
+        }
+
         /**
          * @function
          * @name pc.GraphNode#findByPath
@@ -355,32 +468,61 @@ namespace pc {
          * var path = this.entity.findByPath('child/another_child');
          */
         findByPath(path: string): GraphNode | null {
-            // split the paths in parts. Each part represents a deeper hierarchy level
-            var parts = path.split('/');
-            var currentParent = this;
-            var result = null;
+            // walk the path one part at a time, each part represents a deeper hierarchy level
+            var result: GraphNode | null = this;
+            var start = 0;
 
-            for (var i = 0, imax = parts.length; i < imax && currentParent; i++) {
-                var part = parts[i];
+            while (result) {
+                var end = path.indexOf('/', start);
+                if (end < 0)
+                    end = path.length;
 
-                result = null;
+                result = result._findChild(path, start, end);
 
-                // check all the children
-                var children = currentParent._children;
-                for (var j = 0, jmax = children.length; j < jmax; j++) {
-                    if (children[j].name == part) {
-                        result = children[j];
-                        break;
-                    }
-                }
-
-                // keep going deeper in the hierarchy
-                currentParent = result;
+                if (end === path.length)
+                    break;
+                start = end + 1;
             }
 
             return result;
         }
 
+        // True when child is named path[start, end)
+        _isChildName(child: GraphNode, path: string, start: number, end: number): boolean {
+            var name = child._name;
+            return typeof name === 'string' && name.length === end - start && path.startsWith(name, start);
+        }
+
+        // First child named path[start, end)
+        _findChild(path: string, start: number, end: number): GraphNode | null {
+            var children = this._children;
+            var i, len = children.length;
+
+            var childNames = this._childNames;
+            if (!childNames) {
+                childNames = {};
+                for (i = len - 1; i >= 0; i--) {
+                    childNames[children[i]._nameHash] = children[i];
+                }
+                this._childNames = childNames;
+            }
+
+            var hash = pc.hashCodeRange(path, start, end);
+            var child = childNames[hash];
+            if (!child)
+                return null;
+            if (this._isChildName(child, path, start, end))
+                return child;
+
+            // another name with the same hash comes first
+            for (i = 0; i < len; i++) {
+                child = children[i];
+                if (child._nameHash === hash && this._isChildName(child, path, start, end))
+                    return child;
+            }
+            return null;
+        }
+
         /**
          * @private
          * @deprecated
@@ -637,6 +779,9 @@ namespace pc {
 
             this._sync();
 
+            if (this._children.length)
+                this._syncChildren = true;
+
             return this.worldTransform;
         }
 
@@ -1005,6 +1150,18 @@ namespace pc {
 
         _onInsertChild(node: GraphNode) {
             node._parent = this;
+            this._childNames = null;
+
+            if (this._nameIndex) {
+                if (node._nameIndex)
+                    node._nameIndex.removeHierarchy(node);
+                this._nameIndex.addHierarchy(node);
+            }
+            if (this._tagIndex) {
+                if (node._tagIndex)
+                    node._tagIndex.removeHierarchy(node);
+                this._tagIndex.addHierarchy(node);
+            }
 
             // the child node should be enabled in the hierarchy only if itself is enabled and if
             // this parent is enabled
@@ -1066,6 +1223,12 @@ namespace pc {
             for (i = 0; i < length; ++i) {
                 if (this._children[i] === child) {
                     this._children.splice(i, 1);
+                    this._childNames = null;
+
+                    if (this._nameIndex)
+                        this._nameIndex.removeHierarchy(child);
+                    if (this._tagIndex)
+                        this._tagIndex.removeHierarchy(child);
 
                     // Clear parent
                     child._parent = null;
@@ -1222,19 +1385,28 @@ namespace pc {
          * @function
          * @name pc.GraphNode#syncHierarchy
          * @description Updates the world transformation matrices at this node and all of its descendants.
+         * Moving a node flags its whole subtree dirty, so clean children (and everything below them) are
+         * up to date and are not visited.
+         * @returns {Number} The number of nodes visited.
          */
-        syncHierarchy(): void {
+        syncHierarchy(): number {
             if (!this._enabled)
-                return;
+                return 0;
 
             if (this._dirtyLocal || this._dirtyWorld) {
                 this._sync();
             }
 
+            var visited = 1;
             var children = this._children;
             for (var i = 0, len = children.length; i < len; i++) {
-                children[i].syncHierarchy();
+                var child = children[i];
+                if (child._dirtyLocal || child._dirtyWorld || child._syncChildren)
+                    visited += child.syncHierarchy();
             }
+            this._syncChildren = false;
+
+            return visited;
         }
 
         /**
@@ -0,0 +1,180 @@
+namespace pc {
+
+    /**
+     * @private
+     * @constructor
+     * @name pc.GraphTagIndex
+     * @classdesc Inverted index from tags to the nodes of a hierarchy that have them, used by
+     * {@link pc.GraphNode#findByTag}. Created by {@link pc.GraphNode#enableTagIndex} and kept up to
+     * date when nodes are added or removed and when their tags change.
+     * @param {pc.GraphNode} root The top node of the indexed hierarchy.
+     */
+    export class GraphTagIndex {
+        root: GraphNode;
+        // tag bit (see pc.getTagBit) -> nodes with that tag, unordered
+        _nodes: GraphNode[][];
+
+        constructor(root: GraphNode) {
+            this.root = root;
+            this._nodes = [];
+
+            this.addHierarchy(root);
+        }
+
+        addTag(node: GraphNode, bit: number): void {
+            var list = this._nodes[bit];
+            if (!list) {
+                list = [];
+                this._nodes[bit] = list;
+            }
+
+            if (!node._tagIndexSlots)
+                node._tagIndexSlots = {};
+            node._tagIndexSlots[bit] = list.length;
+            list.push(node);
+        }
+
+        removeTag(node: GraphNode, bit: number): void {
+            var list = this._nodes[bit];
+            var slot = node._tagIndexSlots[bit];
+
+            var last = list.pop();
+            if (last !== node) {
+                list[slot] = last;
+                last._tagIndexSlots[bit] = slot;
+            }
+            delete node._tagIndexSlots[bit];
+        }
+
+        add(node: GraphNode): void {
+            node._tagIndex = this;
+
+            var tags = node.tags._list;
+            for (var i = 0; i < tags.length; i++) {
+                this.addTag(node, pc.getTagBit(tags[i]));
+            }
+        }
+
+        remove(node: GraphNode): void {
+            var tags = node.tags._list;
+            for (var i = 0; i < tags.length; i++) {
+                this.removeTag(node, pc.getTagBit(tags[i]));
+            }
+
+            node._tagIndex = null;
+            node._tagIndexSlots = null;
+        }
+
+        addHierarchy(node: GraphNode): void {
+            this.add(node);
+
+            var children = node._children;
+            for (var i = 0, len = children.length; i < len; i++) {
+                this.addHierarchy(children[i]);
+            }
+        }
+
+        removeHierarchy(node: GraphNode): void {
+            if (node._tagIndex !== this)
+                return;
+
+            this.remove(node);
+
+            var children = node._children;
+            for (var i = 0, len = children.length; i < len; i++) {
+                this.removeHierarchy(children[i]);
+            }
+        }
+
+        /**
+         * @private
+         * @function
+         * @name pc.GraphTagIndex#find
+         * @description Same as pc.GraphNode#_findByTag, but only the nodes that have the rarest tag
+         * of each clause are tested.
+         * @param {pc.GraphNode} scope An indexed node, only its descendants are returned.
+         * @param {pc.TagsQuery} query The compiled query.
+         * @returns {pc.GraphNode[]} The matching nodes in depth first order.
+         */
+        find(scope: GraphNode, query: TagsQuery): GraphNode[] {
+            var result: GraphNode[] = [];
+            var i, c, e;
+
+            for (c = 0; c < query._bits.length; c++) {
+                var bits = query._bits[c];
+                if (!bits || !bits.length)
+                    continue;
+
+                var list: GraphNode[] | null = null;
+                for (i = 0; i < bits.length; i++) {
+                    var candidates = this._nodes[bits[i]];
+                    if (!candidates || !candidates.length) {
+                        list = null;
+                        break;
+                    }
+                    if (!list || candidates.length < list.length)
+                        list = candidates;
+                }
+                if (!list)
+                    continue;
+
+                for (i = 0; i < list.length; i++) {
+                    var node = list[i];
+                    if (node === scope || !query._testClause(c, node.tags._bits))
+                        continue;
+
+                    // already added by an earlier clause
+                    for (e = 0; e < c; e++) {
+                        if (query._testClause(e, node.tags._bits))
+                            break;
+                    }
+                    if (e < c)
+                        continue;
+
+                    if (scope !== this.root) {
+                        var parent = node._parent;
+                        while (parent && parent !== scope)
+                            parent = parent._parent;
+                        if (!parent)
+                            continue;
+                    }
+
+                    result.push(node);
+                }
+            }
+
+            if (result.length > 1)
+                result.sort(GraphTagIndex.compareDepthFirst);
+
+            return result;
+        }
+
+        // Orders two nodes of the same hierarchy the way a depth first search visits them
+        static compareDepthFirst(a: GraphNode, b: GraphNode): number {
+            var depthA = a._graphDepth;
+            var depthB = b._graphDepth;
+
+            // an ancestor comes before its descendants
+            while (depthA > depthB) {
+                a = a._parent;
+                depthA--;
+                if (a === b)
+                    return 1;
+            }
+            while (depthB > depthA) {
+                b = b._parent;
+                depthB--;
+                if (b === a)
+                    return -1;
+            }
+
+            while (a._parent !== b._parent) {
+                a = a._parent;
+                b = b._parent;
+            }
+
+            var siblings = a._parent._children;
+            return siblings.indexOf(a) - siblings.indexOf(b);
+        }
+    }
+}
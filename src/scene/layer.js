@@ -1,28 +1,5 @@
 Object.assign(pc, function () {
-    var keyA, keyB, sortPos, sortDir;
-
-    function sortManual(drawCallA, drawCallB) {
-        return drawCallA.drawOrder - drawCallB.drawOrder;
-    }
-
-    function sortMaterialMesh(drawCallA, drawCallB) {
-        keyA = drawCallA._key[pc.SORTKEY_FORWARD];
-        keyB = drawCallB._key[pc.SORTKEY_FORWARD];
-        if (keyA === keyB && drawCallA.mesh && drawCallB.mesh) {
-            return drawCallB.mesh.id - drawCallA.mesh.id;
-        }
-        return keyB - keyA;
-    }
-
-    function sortBackToFront(drawCallA, drawCallB) {
-        return drawCallB.zdist - drawCallA.zdist;
-    }
-
-    function sortFrontToBack(drawCallA, drawCallB) {
-        return drawCallA.zdist - drawCallB.zdist;
-    }
-
-    var sortCallbacks = [null, sortManual, sortMaterialMesh, sortBackToFront, sortFrontToBack];
+    var sortPos, sortDir;
 
     function sortCameras(camA, camB) {
         return camA.priority - camB.priority;
@@ -39,6 +16,9 @@ Object.assign(pc, function () {
         this.list = [];
         this.length = 0;
         this.done = false;
+
+        // pc.DrawCallSorter, created when the list is first sorted
+        this._sorter = null;
     };
 
     var InstanceList = function () {
@@ -242,6 +222,7 @@ Object.assign(pc, function () {
         this._renderTime = 0;
         this._forwardDrawCalls = 0;
         this._shadowDrawCalls = 0;
+        this._removedByInstancing = 0; // draw calls saved by auto instancing
         // #endif
 
         this._shaderVersion = -1;
@@ -697,11 +678,10 @@ Object.assign(pc, function () {
                 this._calculateSortDistances(visible.list, visible.length, sortPos, sortDir);
             }
 
-            if (visible.list.length !== visible.length) {
-                visible.list.length = visible.length;
+            if (!visible._sorter) {
+                visible._sorter = new pc.DrawCallSorter();
             }
-
-            visible.list.sort(sortCallbacks[sortMode]);
+            visible._sorter.sort(visible.list, visible.length, sortMode);
         }
     };
 
@@ -75,6 +75,8 @@ namespace pc {
 
         _visibleLength: [0];
         _visibleList: [][]; // culled mesh instances per pass (1 for spot, 6 for point, cameraCount for directional)
+        _visibleSorters: []; // pc.DrawCallSorter per pass
+        _shadowCache: []; // per pass, what the shadow map was rendered from, see SHADOWUPDATE_ONCHANGE
         _visibleCameraSettings: [];
 
         constructor() {
@@ -142,6 +144,8 @@ namespace pc {
 
             this._visibleLength = [0]; // lengths of passes in culledList
             this._visibleList = [[]]; // culled mesh instances per pass (1 for spot, 6 for point, cameraCount for directional)
+            this._visibleSorters = []; // pc.DrawCallSorter per pass, created when the pass is first sorted
+            this._shadowCache = []; // per pass, what the shadow map was rendered from, see SHADOWUPDATE_ONCHANGE
             this._visibleCameraSettings = []; // camera settings used in each directional light pass
         }
 
@@ -311,6 +315,7 @@ namespace pc {
                 this._shadowCamera.renderTarget = null;
                 this._shadowCamera = null;
                 this._shadowCubeMap = null;
+                this._shadowCache.length = 0;
                 if (this.shadowUpdateMode === pc.SHADOWUPDATE_NONE) {
                     this.shadowUpdateMode = pc.SHADOWUPDATE_THISFRAME;
                 }
@@ -318,7 +323,10 @@ namespace pc {
         }
 
         updateShadow() {
-            if (this.shadowUpdateMode !== pc.SHADOWUPDATE_REALTIME) {
+            if (this.shadowUpdateMode === pc.SHADOWUPDATE_ONCHANGE) {
+                // keep the mode, just forget the state the shadow maps were rendered from
+                this._shadowCache.length = 0;
+            } else if (this.shadowUpdateMode !== pc.SHADOWUPDATE_REALTIME) {
                 this.shadowUpdateMode = pc.SHADOWUPDATE_THISFRAME;
             }
         }
@@ -95,6 +95,7 @@ Object.assign(pc, function () {
         this.meshInstances = []; // The mesh instances referencing this material
 
         this._shaderVersion = 0;
+        this._version = 0;
         this._scene = null;
         this._dirtyBlend = false;
 
@@ -310,6 +311,7 @@ Object.assign(pc, function () {
      */
     Material.prototype.update = function () {
         this.dirty = true;
+        this._version++;
     };
 
     // Parameter management
@@ -37,6 +37,10 @@ Object.assign(pc, function () {
 
         // Array of object space AABBs of vertices affected by each bone
         this.boneAabb = null;
+
+        // Light splits of this mesh made by pc.ForwardRenderer#prepareStaticMeshes, by renderStyle
+        // and local light bounds
+        this._staticSplits = null;
     };
 
     Object.defineProperty(Mesh.prototype, 'aabb', {
@@ -46,6 +50,7 @@ Object.assign(pc, function () {
         set: function (aabb) {
             if (this.morph) {
                 this._aabb = this.morph._baseAabb = aabb;
+                this.morph._aabbVersion++;
                 this.morph._calculateAabb();
             } else {
                 this._aabb = aabb;
@@ -88,6 +93,7 @@ Object.assign(pc, function () {
      * @property {Boolean} visibleThisFrame Read this value in {@link pc.Layer#onPostCull} to determine if the object is actually going to be rendered.
      */
     var MeshInstance = function MeshInstance(node, mesh, material) {
+        this._id = id++;
         this._key = [0, 0];
         this._shader = [null, null, null];
 
@@ -137,6 +143,12 @@ Object.assign(pc, function () {
         this.drawOrder = 0;
         this.visibleThisFrame = 0;
 
+        // set by pc.DrawCallSorter to tell the draw calls of the list it sorts apart
+        this._sortStamp = 0;
+
+        // index of the frustum plane that culled this mesh instance last time, -1 if none
+        this._cullPlane = -1;
+
         // custom function used to customize culling (e.g. for 2D UI elements)
         this.isVisibleFunc = null;
 
@@ -356,7 +368,8 @@ Object.assign(pc, function () {
 
             } else if (this.node._aabbVer !== this._aabbVer) {
                  // if there is no mesh then reset aabb
-                aabb = this.mesh ? this.mesh.aabb : this._aabb;
+                // morphed meshes use the bounds of their current weights
+                aabb = this.morphInstance ? this.morphInstance.aabb : (this.mesh ? this.mesh.aabb : this._aabb);
                 if (!this.mesh) {
                     aabb.center.set(0, 0, 0);
                     aabb.halfExtents.set(0, 0, 0);
@@ -514,6 +527,7 @@ Object.assign(pc, function () {
         this._key = [];
         this._key[pc.SORTKEY_FORWARD] = getKey(layer, blendType, true, 0);
         this.command = command;
+        this._sortStamp = 0;
     };
 
     Object.defineProperty(Command.prototype, 'key', {
@@ -95,6 +95,10 @@ Object.assign(pc, function () {
             var cloneSkinInstances = [];
             var cloneMorphInstances = [];
 
+            // Index the cloned graph while resolving bone names
+            if (this.skinInstances.length)
+                cloneGraph.enableNameIndex();
+
             // Clone the skin instances
             for (i = 0; i < this.skinInstances.length; i++) {
                 var skin = this.skinInstances[i].skin;
@@ -112,6 +116,9 @@ Object.assign(pc, function () {
                 cloneSkinInstances.push(cloneSkinInstance);
             }
 
+            if (this.skinInstances.length)
+                cloneGraph.disableNameIndex();
+
             // Clone the morph instances
             for (i = 0; i < this.morphInstances.length; i++) {
                 var morph = this.morphInstances[i].morph;
@@ -34,6 +34,39 @@ Object.assign(pc, function () {
         this.deltaTangents = options.deltaTangents;
         this.name = options.name;
         this.aabb = options.aabb;
+
+        // range of vertices the target touches, [_firstVertex, _endVertex)
+        this._firstVertex = 0;
+        this._endVertex = 0;
+
+        // extents of the position deltas, including the zero delta of untouched vertices
+        this._deltaMin = new pc.Vec3();
+        this._deltaMax = new pc.Vec3();
+
+        var indices = this.indices;
+        var deltas = this.deltaPositions;
+        for (var i = 0; i < indices.length; i++) {
+            var dx = deltas[i * 3];
+            var dy = deltas[i * 3 + 1];
+            var dz = deltas[i * 3 + 2];
+            if (this._deltaMin.x > dx) this._deltaMin.x = dx;
+            if (this._deltaMin.y > dy) this._deltaMin.y = dy;
+            if (this._deltaMin.z > dz) this._deltaMin.z = dz;
+            if (this._deltaMax.x < dx) this._deltaMax.x = dx;
+            if (this._deltaMax.y < dy) this._deltaMax.y = dy;
+            if (this._deltaMax.z < dz) this._deltaMax.z = dz;
+        }
+
+        if (indices.length > 0) {
+            var first = indices[0];
+            var last = indices[0];
+            for (var j = 1; j < indices.length; j++) {
+                if (indices[j] < first) first = indices[j];
+                if (indices[j] > last) last = indices[j];
+            }
+            this._firstVertex = first;
+            this._endVertex = last + 1;
+        }
     };
 
     /**
@@ -52,6 +85,9 @@ Object.assign(pc, function () {
         this._dirty = true;
         this._aabbDirty = true;
 
+        // incremented when _baseAabb changes, the bounds of the instances start from it
+        this._aabbVersion = 0;
+
         this._baseData = null;
         this._offsetPF = 0;
         this._offsetNF = 0;
@@ -65,6 +101,7 @@ Object.assign(pc, function () {
         _setBaseMesh: function (baseMesh) {
             this._baseBuffer = baseMesh.vertexBuffer;
             this._baseAabb = baseMesh._aabb;
+            this._aabbVersion++;
 
             this._baseData = new Float32Array(this._baseBuffer.storage);
 
@@ -96,39 +133,15 @@ Object.assign(pc, function () {
 
             this.aabb.copy(this._baseAabb);
 
-            var numIndices;
-            var i, j, target, index, id;
-            var x, y, z;
-
-            var vertSizeF = this._vertSizeF;
-            var offsetPF = this._offsetPF;
-            var baseData = this._baseData;
-
+            var i, target;
             for (i = 0; i < this._targets.length; i++) {
                 target = this._targets[i];
 
                 if (!target.aabb && target.indices.length > 0) {
-                    target.aabb = this.aabb.clone();
-                    _morphMin.set(Number.MAX_VALUE, Number.MAX_VALUE, Number.MAX_VALUE);
-                    _morphMax.set(-Number.MAX_VALUE, -Number.MAX_VALUE, -Number.MAX_VALUE);
-
-                    numIndices = target.indices.length;
-                    for (j = 0; j < numIndices; j++) {
-                        index = target.indices[j];
-                        id = index * vertSizeF + offsetPF;
-
-                        x = baseData[id] + target.deltaPositions[j * 3];
-                        y = baseData[id + 1] + target.deltaPositions[j * 3 + 1];
-                        z = baseData[id + 2] + target.deltaPositions[j * 3 + 2];
-
-                        if (_morphMin.x > x) _morphMin.x = x;
-                        if (_morphMin.y > y) _morphMin.y = y;
-                        if (_morphMin.z > z) _morphMin.z = z;
-
-                        if (_morphMax.x < x) _morphMax.x = x;
-                        if (_morphMax.y < y) _morphMax.y = y;
-                        if (_morphMax.z < z) _morphMax.z = z;
-                    }
+                    // the base bounds moved by the delta extents, which needs no vertex scan
+                    _morphMin.copy(this._baseAabb.getMin()).add(target._deltaMin);
+                    _morphMax.copy(this._baseAabb.getMax()).add(target._deltaMax);
+                    target.aabb = new pc.BoundingBox();
                     target.aabb.setMinMax(_morphMin, _morphMax);
                 }
                 if (target.aabb) this.aabb.add(target.aabb);
@@ -182,14 +195,24 @@ Object.assign(pc, function () {
      * @name pc.MorphInstance
      * @classdesc An instance of pc.Morph. Contains weights to assign to every pc.MorphTarget, holds morphed buffer and associated data.
      * @param {pc.Morph} morph The pc.Morph to instance.
+     * @property {pc.BoundingBox} aabb Conservative bounds of the morphed mesh for the current weights.
      */
     var MorphInstance = function (morph) {
         this.morph = morph;
+        this.aabb = new pc.BoundingBox();
+        this._aabbDirty = true;
+        this._aabbVersion = -1;
 
+        this._baseBuffer = null;
         this._vertexBuffer = null;
         this._vertexData = null;
         this._weights = [];
         this._dirty = true;
+
+        // vertices the active targets touched in the last update, restored from the base mesh
+        // on the next one
+        this._activeFirst = 0;
+        this._activeEnd = 0;
     };
 
     Object.assign(MorphInstance.prototype, {
@@ -197,6 +220,7 @@ Object.assign(pc, function () {
         // called if the mesh is changed
         _setBaseMesh: function (baseMesh) {
             this.destroy();
+            this._baseBuffer = this.morph._baseBuffer;
             this._vertexBuffer = new pc.VertexBuffer(this.morph._baseBuffer.device, this.morph._baseBuffer.format,
                                                      this.morph._baseBuffer.numVertices, pc.BUFFER_DYNAMIC, this.morph._baseBuffer.storage.slice(0));
             this._vertexData = new Float32Array(this._vertexBuffer.storage);
@@ -205,7 +229,10 @@ Object.assign(pc, function () {
             for (var i = 0; i < this.morph._targets.length; i++) {
                 this._weights[i] = 0;
             }
+            this._activeFirst = 0;
+            this._activeEnd = 0;
             this._dirty = true;
+            this._aabbDirty = true;
         },
 
         /**
@@ -218,6 +245,7 @@ Object.assign(pc, function () {
                 this._vertexBuffer.destroy();
                 this._vertexBuffer = null;
             }
+            this._baseBuffer = null;
         },
 
         /**
@@ -241,8 +269,11 @@ Object.assign(pc, function () {
          * @param {Number} weight Weight
          */
         setWeight: function (index, weight) {
-            this._weights[index] = weight;
-            this._dirty = true;
+            if (this._weights[index] !== weight) {
+                this._weights[index] = weight;
+                this._dirty = true;
+                this._aabbDirty = true;
+            }
         },
 
         /**
@@ -256,13 +287,45 @@ Object.assign(pc, function () {
             if (this.morph._baseBuffer !== mesh.vertexBuffer) {
                 this.morph._setBaseMesh(mesh);
             }
-            if (!this._vertexData) {
+            // the morphed buffer is a copy of the base mesh, rebuilt when the base changes
+            if (this._baseBuffer !== this.morph._baseBuffer) {
                 this._setBaseMesh(mesh);
             }
 
             if (this.morph._aabbDirty) {
                 this.morph._calculateAabb();
             }
+
+            if (this._aabbDirty || this._aabbVersion !== this.morph._aabbVersion) {
+                this._calculateAabb();
+            }
+        },
+
+        // Moves the base bounds by the weighted delta extents of every active target, a negative
+        // weight swaps the extents. O(active targets), no vertices are read.
+        _calculateAabb: function () {
+            var targets = this.morph._targets;
+            var weights = this._weights;
+
+            _morphMin.copy(this.morph._baseAabb.getMin());
+            _morphMax.copy(this.morph._baseAabb.getMax());
+            for (var i = 0; i < targets.length; i++) {
+                var weight = weights[i];
+                if (weight === 0) continue;
+
+                var lo = weight > 0 ? targets[i]._deltaMin : targets[i]._deltaMax;
+                var hi = weight > 0 ? targets[i]._deltaMax : targets[i]._deltaMin;
+                _morphMin.x += lo.x * weight;
+                _morphMin.y += lo.y * weight;
+                _morphMin.z += lo.z * weight;
+                _morphMax.x += hi.x * weight;
+                _morphMax.y += hi.y * weight;
+                _morphMax.z += hi.z * weight;
+            }
+
+            this.aabb.setMinMax(_morphMin, _morphMax);
+            this._aabbDirty = false;
+            this._aabbVersion = this.morph._aabbVersion;
         },
 
         /**
@@ -276,7 +339,8 @@ Object.assign(pc, function () {
             if (this.morph._baseBuffer !== mesh.vertexBuffer) {
                 this.morph._setBaseMesh(mesh);
             }
-            if (!this._vertexData) {
+            // the morphed buffer is a copy of the base mesh, rebuilt when the base changes
+            if (this._baseBuffer !== this.morph._baseBuffer) {
                 this._setBaseMesh(mesh);
             }
 
@@ -291,9 +355,35 @@ Object.assign(pc, function () {
             var offsetTF = this.morph._offsetTF;
 
             var vdata = this._vertexData;
-            vdata.set(this.morph._baseData);
+            var i;
+
+            // only the vertices touched by the active targets, now or in the last update, differ
+            // from the base mesh
+            var activeFirst = this._vertexBuffer.numVertices;
+            var activeEnd = 0;
+            for (i = 0; i < targets.length; i++) {
+                if (weights[i] === 0) continue;
+                target = targets[i];
+                if (target._firstVertex < activeFirst) activeFirst = target._firstVertex;
+                if (target._endVertex > activeEnd) activeEnd = target._endVertex;
+            }
+            if (activeFirst >= activeEnd) {
+                activeFirst = activeEnd = 0;
+            }
 
-            for (var i = 0; i < targets.length; i++) {
+            var first = activeFirst;
+            var end = activeEnd;
+            if (this._activeFirst < this._activeEnd) {
+                first = first < end ? Math.min(first, this._activeFirst) : this._activeFirst;
+                end = Math.max(end, this._activeEnd);
+            }
+            this._activeFirst = activeFirst;
+            this._activeEnd = activeEnd;
+
+            if (first >= end) return;
+            vdata.set(this.morph._baseData.subarray(first * vertSizeF, end * vertSizeF), first * vertSizeF);
+
+            for (i = 0; i < targets.length; i++) {
                 weight = weights[i];
                 if (weight === 0) continue;
                 target = targets[i];
@@ -330,7 +420,7 @@ Object.assign(pc, function () {
                 }
             }
 
-            this._vertexBuffer.unlock();
+            this._vertexBuffer.unlockRange(first, end - first);
         }
     });
 
@@ -242,6 +242,7 @@
         SHADOWUPDATE_NONE: 0,
         SHADOWUPDATE_THISFRAME: 1,
         SHADOWUPDATE_REALTIME: 2,
+        SHADOWUPDATE_ONCHANGE: 3,
 
         SORTKEY_FORWARD: 0,
         SORTKEY_DEPTH: 1,
@@ -462,6 +463,7 @@ Object.assign(pc, function () {
             lastStaticPrepareWriteTime: 0,
             lastStaticPrepareTriAabbTime: 0,
             lastStaticPrepareCombineTime: 0,
+            lastStaticPrepareCacheHits: 0,
             updateShadersTime: 0
         };
 
@@ -1,23 +1,67 @@
 Object.assign(pc, function () {
+    // Per frame set of the graph nodes whose transform changed, sorted by graph depth. A node is
+    // recorded once (see pc.GraphNode#_queueSync) and only the dirty part of its subtree is synced,
+    // so the cost of a frame depends on what moved rather than on the size of the scene.
     var SyncQueue = function () {
         this._index = [];
         this._values = [];
+        // the arrays of the queue being synced, swapped with the live ones by runSync
+        this._syncIndex = [];
+        this._syncValues = [];
+
+        this._stats = {
+            roots: 0, // nodes synced from the queue
+            nodes: 0 // nodes visited while syncing them
+        };
     };
 
     SyncQueue.prototype.runSync = function () {
-        for (var i = 0, len = this._values.length; i < len; i++) {
-            this._values[i].syncHierarchy();
+        var roots = 0;
+        var nodes = 0;
+
+        // syncing can queue or cancel nodes (element resize handlers, destroy), those changes go to
+        // a fresh queue for the next run instead of shifting the entries being iterated
+        var values = this._values;
+        var index = this._index;
+        this._values = this._syncValues;
+        this._index = this._syncIndex;
+
+        for (var i = 0; i < values.length; i++) {
+            var node = values[i];
+
+            // cancelled since it was queued, or synced already from another entry
+            if (!node._syncQueued)
+                continue;
+            node._syncQueued = false;
+
+            // parents come first, so anything the node still depends on was queued with a depth
+            // that is out of date; bring its ancestors up to date before syncing below them
+            if (node._parent && (node._parent._dirtyLocal || node._parent._dirtyWorld))
+                node._parent.getWorldTransform();
+
+            roots++;
+            nodes += node.syncHierarchy();
         }
-        this._values.length = 0;
-        this._index.length = 0;
+
+        values.length = 0;
+        index.length = 0;
+        this._syncValues = values;
+        this._syncIndex = index;
+
+        this._stats.roots = roots;
+        this._stats.nodes = nodes;
     };
 
     SyncQueue.prototype.erase = function (n) {
+        if (!n._syncQueued)
+            return;
+
         var idx = this._values.indexOf(n);
         if (idx >= 0) {
             this._index.splice(idx, 1);
             this._values.splice(idx, 1);
         }
+        n._syncQueued = false;
     };
 
     var bs = function (index, s, e, k) {
@@ -31,6 +75,10 @@ Object.assign(pc, function () {
     };
 
     SyncQueue.prototype.push = function (p, v) {
+        if (v._syncQueued)
+            return;
+        v._syncQueued = true;
+
         var i = bs(this._index, 0, this._index.length, p);
         this._values.splice(i, 0, v);
         this._index.splice(i, 0, p);
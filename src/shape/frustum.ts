@@ -139,10 +139,13 @@ namespace pc {
          * the frustum, 2 is returned. Note that a sphere touching a frustum plane from the outside is considered to
          * be outside the frustum.
          * @param {pc.BoundingSphere} sphere The sphere to test
+         * @param {Object} [planeCache] An object owned by the tested shape (usually a mesh instance). Its _cullPlane
+         * property remembers the plane that rejected the sphere last time, which is tested first on the next call.
+         * Objects tend to stay outside the same plane for many frames, so most rejections then cost one plane test.
          * @returns {Number} 0 if the bounding sphere is outside the frustum, 1 if it intersects the frustum and 2 if
          * it is contained by the frustum
          */
-        containsSphere(sphere: BoundingSphere): number {
+        containsSphere(sphere: BoundingSphere, planeCache?: any): number {
             var c = 0;
             var d;
             var p;
@@ -154,12 +157,30 @@ namespace pc {
             var scz = sc.z;
             var planes = this.planes;
             var plane;
+            var cached = -1;
+
+            if (planeCache) {
+                cached = planeCache._cullPlane;
+                if (cached >= 0) {
+                    plane = planes[cached];
+                    d = plane[0] * scx + plane[1] * scy + plane[2] * scz + plane[3];
+                    if (d <= -sr)
+                        return 0;
+                    if (d > sr)
+                        c++;
+                }
+            }
 
             for (p = 0; p < 6; p++) {
+                if (p === cached)
+                    continue;
                 plane = planes[p];
                 d = plane[0] * scx + plane[1] * scy + plane[2] * scz + plane[3];
-                if (d <= -sr)
+                if (d <= -sr) {
+                    if (planeCache)
+                        planeCache._cullPlane = p;
                     return 0;
+                }
                 if (d > sr)
                     c++;
             }
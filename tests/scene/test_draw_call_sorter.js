@@ -0,0 +1,147 @@
+describe('pc.DrawCallSorter', function () {
+    beforeEach(function () {
+        this.sorter = new pc.DrawCallSorter();
+    });
+
+    afterEach(function () {
+        this.sorter = null;
+    });
+
+    // draw calls only need what the sorter reads, the id tells them apart in failures
+    function drawCall(id, drawOrder) {
+        return { id: id, drawOrder: drawOrder, zdist: 0, mesh: null, _key: [0, 0] };
+    }
+
+    function ids(list) {
+        return list.map(function (item) {
+            return item.id;
+        });
+    }
+
+    // stable reference order by draw order, ties keep the order of the input list
+    function referenceOrder(list) {
+        return list.map(function (item, index) {
+            return { item: item, index: index };
+        }).sort(function (a, b) {
+            return a.item.drawOrder - b.item.drawOrder || a.index - b.index;
+        }).map(function (entry) {
+            return entry.item.id;
+        });
+    }
+
+    function sortManual(sorter, list) {
+        sorter.sort(list, list.length, pc.SORTMODE_MANUAL);
+        return ids(list);
+    }
+
+    it('sort() orders by draw order and keeps the order of equal keys', function () {
+        var list = [drawCall('a', 2), drawCall('b', 1), drawCall('c', 2), drawCall('d', 1), drawCall('e', 0)];
+        var expected = referenceOrder(list);
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+    });
+
+    it('sort() truncates the list to count', function () {
+        var list = [drawCall('a', 2), drawCall('b', 1), drawCall('c', 0)];
+
+        this.sorter.sort(list, 2, pc.SORTMODE_MANUAL);
+
+        expect(ids(list)).to.deep.equal(['b', 'a']);
+    });
+
+    it('sort() orders material and mesh keys like the material and mesh comparator', function () {
+        var list = [drawCall('a'), drawCall('b'), drawCall('c'), drawCall('d')];
+        list[0]._key[pc.SORTKEY_FORWARD] = 1;
+        list[0].mesh = { id: 1 };
+        list[1]._key[pc.SORTKEY_FORWARD] = 2;
+        list[1].mesh = { id: 1 };
+        list[2]._key[pc.SORTKEY_FORWARD] = 1;
+        list[2].mesh = { id: 2 };
+        list[3]._key[pc.SORTKEY_FORWARD] = 2;
+        list[3].mesh = { id: 3 };
+
+        this.sorter.sort(list, list.length, pc.SORTMODE_MATERIALMESH);
+
+        // both keys descending
+        expect(ids(list)).to.deep.equal(['d', 'b', 'c', 'a']);
+    });
+
+    it('sort() is stable when the same draw calls are sorted again', function () {
+        var list = [drawCall('a', 1), drawCall('b', 0), drawCall('c', 1), drawCall('d', 0)];
+        var first = sortManual(this.sorter, list);
+
+        // same draw calls in a different order, equal keys keep last frame's order
+        list.reverse();
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(first);
+    });
+
+    it('sort() is stable when draw calls are added between frames', function () {
+        var list = [drawCall('a', 1), drawCall('b', 0), drawCall('c', 1)];
+        sortManual(this.sorter, list);
+
+        list.push(drawCall('d', 1), drawCall('e', 0));
+        var expected = referenceOrder(list);
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+    });
+
+    it('sort() is stable when draw calls are removed between frames', function () {
+        var list = [drawCall('a', 1), drawCall('b', 0), drawCall('c', 1), drawCall('d', 0)];
+        sortManual(this.sorter, list);
+
+        list.splice(1, 1);
+        var expected = referenceOrder(list);
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+    });
+
+    it('sort() is stable for lists sorted with the radix sort', function () {
+        var list = [];
+        for (var i = 0; i < 500; i++) {
+            list.push(drawCall(i, (i * 7919) % 13));
+        }
+        var expected = referenceOrder(list);
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+
+        // drop every third draw call and add new ones
+        list = list.filter(function (item, index) {
+            return index % 3 !== 0;
+        });
+        for (i = 500; i < 600; i++) {
+            list.push(drawCall(i, (i * 7919) % 13));
+        }
+        expected = referenceOrder(list);
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+    });
+
+    it('sort() hands a rotated list to the radix sort', function () {
+        var list = [];
+        for (var i = 0; i < 1000; i++) {
+            list.push(drawCall(i, i));
+        }
+        sortManual(this.sorter, list);
+
+        // the first half moves behind the second, one descent but too many moves for an insertion sort
+        for (i = 0; i < 500; i++) {
+            list[i].drawOrder += 1000;
+        }
+        var expected = referenceOrder(list);
+        var insertion = this.sorter._stats.insertion;
+        var passes = this.sorter._stats.passes;
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(expected);
+        equal(this.sorter._stats.insertion, insertion);
+        ok(this.sorter._stats.passes > passes);
+    });
+
+    it('clear() forgets the previous order', function () {
+        var list = [drawCall('a', 0), drawCall('b', 0)];
+        sortManual(this.sorter, list);
+
+        list.reverse();
+        this.sorter.clear();
+
+        expect(sortManual(this.sorter, list)).to.deep.equal(['b', 'a']);
+    });
+});
@@ -106,6 +106,120 @@ describe('pc.GraphNode', function () {
         equal(found, null);
     });
 
+    it('GraphNode: findByName after rename', function () {
+        var node = buildGraph();
+        var grandchild = node.getChildren()[0].getChildren()[0];
+
+        grandchild.name = 'renamed';
+
+        equal(node.findByName('g3'), null);
+        equal(node.findByName('renamed'), grandchild);
+    });
+
+    it('GraphNode: findByName after rename with name index', function () {
+        var node = buildGraph();
+        var grandchild = node.getChildren()[0].getChildren()[0];
+        node.enableNameIndex();
+
+        equal(node.findByName('g3'), grandchild);
+        grandchild.name = 'renamed';
+
+        equal(node.findByName('g3'), null);
+        equal(node.findByName('renamed'), grandchild);
+    });
+
+    it('GraphNode: findByPath after rename', function () {
+        var node = buildGraph();
+        var child = node.getChildren()[0];
+        var grandchild = child.getChildren()[0];
+
+        equal(node.findByPath('g2/g3'), grandchild);
+        child.name = 'renamed';
+
+        equal(node.findByPath('g2/g3'), null);
+        equal(node.findByPath('renamed/g3'), grandchild);
+    });
+
+    it('GraphNode: findByPath with a name that is not a string', function () {
+        var node = buildGraph();
+        var child = node.getChildren()[0];
+
+        child.name = null;
+
+        equal(node.findByPath('g2'), null);
+        equal(node.findByPath(''), null);
+    });
+
+    it('GraphNode: tags has after add and remove', function () {
+        var node = new pc.GraphNode('g1');
+
+        node.tags.add('a', 'b');
+        ok(node.tags.has('a'));
+        ok(node.tags.has(['a', 'b']));
+        equal(node.tags.has('never-added'), false);
+
+        node.tags.remove('a');
+        equal(node.tags.has('a'), false);
+        equal(node.tags.has(['a', 'b']), false);
+        ok(node.tags.has('a', 'b'));
+    });
+
+    it('GraphNode: findByTag after add and remove', function () {
+        var node = buildGraph();
+        var child = node.getChildren()[0];
+        var grandchild = child.getChildren()[0];
+        var found;
+
+        grandchild.tags.add('t');
+        child.tags.add('t', 'u');
+        found = node.findByTag('t');
+        equal(found.length, 2);
+        equal(found[0], child);
+        equal(found[1], grandchild);
+        found = node.findByTag(['t', 'u']);
+        equal(found.length, 1);
+        equal(found[0], child);
+
+        child.tags.remove('t');
+        found = node.findByTag('t');
+        equal(found.length, 1);
+        equal(found[0], grandchild);
+        found = node.findByTag(['t', 'u']);
+        equal(found.length, 0);
+    });
+
+    it('GraphNode: findByTag after add and remove with tag index', function () {
+        var node = buildGraph();
+        var child = node.getChildren()[0];
+        var grandchild = child.getChildren()[0];
+        var found;
+        node.enableTagIndex();
+
+        grandchild.tags.add('t');
+        child.tags.add('t', 'u');
+        found = node.findByTag('t');
+        equal(found.length, 2);
+        equal(found[0], child);
+        equal(found[1], grandchild);
+        found = node.findByTag(['t', 'u']);
+        equal(found.length, 1);
+        equal(found[0], child);
+
+        child.tags.remove('t');
+        found = node.findByTag('t');
+        equal(found.length, 1);
+        equal(found[0], grandchild);
+
+        node.removeChild(child);
+        found = node.findByTag('t');
+        equal(found.length, 0);
+
+        node.addChild(child);
+        found = node.findByTag('t');
+        equal(found.length, 1);
+        equal(found[0], grandchild);
+    });
+
     it('GraphNode: getPath', function () {
         var node = buildGraph();
         var child = node.getChildren()[0];
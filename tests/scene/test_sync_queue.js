@@ -0,0 +1,99 @@
+describe('pc.SyncQueue', function () {
+    beforeEach(function () {
+        this.app = new pc.Application(document.createElement('canvas'));
+        this.queue = this.app.syncQueue;
+        this.queue.runSync();
+    });
+
+    afterEach(function () {
+        this.app.destroy();
+    });
+
+    // calls callback once, the first time node is synced
+    function onSync(node, callback) {
+        var syncHierarchy = node.syncHierarchy;
+        node.syncHierarchy = function () {
+            node.syncHierarchy = syncHierarchy;
+            callback();
+            return syncHierarchy.call(node);
+        };
+    }
+
+    it('syncs the queued nodes', function () {
+        var a = new pc.GraphNode('a');
+        var b = new pc.GraphNode('b');
+
+        a.setLocalPosition(1, 0, 0);
+        b.setLocalPosition(2, 0, 0);
+        equal(this.queue._values.length, 2);
+
+        this.queue.runSync();
+
+        equal(this.queue._values.length, 0);
+        equal(a._syncQueued, false);
+        equal(b._syncQueued, false);
+        equal(a._dirtyWorld, false);
+        equal(b._dirtyWorld, false);
+        equal(a.getPosition().x, 1);
+    });
+
+    it('queues nodes moved while syncing for the next run', function () {
+        var a = new pc.GraphNode('a');
+        var b = new pc.GraphNode('b');
+        var queue = this.queue;
+
+        a.setLocalPosition(1, 0, 0);
+        onSync(a, function () {
+            b.setLocalPosition(2, 0, 0);
+        });
+
+        queue.runSync();
+
+        equal(b._syncQueued, true);
+        equal(queue._values.length, 1);
+        equal(queue._values[0], b);
+
+        queue.runSync();
+
+        equal(b._syncQueued, false);
+        equal(b._dirtyWorld, false);
+        equal(queue._values.length, 0);
+    });
+
+    it('skips nodes cancelled while syncing and lets them be queued again', function () {
+        var a = new pc.GraphNode('a');
+        var b = new pc.GraphNode('b');
+        var c = new pc.GraphNode('c');
+        var queue = this.queue;
+
+        // one level deeper than a, so that a is synced first
+        var parent = new pc.GraphNode('parent');
+        parent.addChild(b);
+        parent.addChild(c);
+        queue.runSync();
+
+        a.setLocalPosition(1, 0, 0);
+        b.setLocalPosition(2, 0, 0);
+        c.setLocalPosition(3, 0, 0);
+        onSync(a, function () {
+            b._cancelSync();
+        });
+
+        queue.runSync();
+
+        equal(b._syncQueued, false);
+        equal(b._dirtyWorld, true);
+        equal(c._syncQueued, false);
+        equal(c._dirtyWorld, false);
+        equal(queue._values.length, 0);
+
+        // the cancelled node is not stuck as queued
+        b.getWorldTransform();
+        b.setLocalPosition(4, 0, 0);
+        equal(b._syncQueued, true);
+
+        queue.runSync();
+
+        equal(b._dirtyWorld, false);
+    });
+});
@@ -0,0 +1,93 @@
+#include "anim_blend.h"
+#include "simd_float4.h"
+
+#include <string.h>
+
+using namespace pc::simd;
+
+static inline float4 loadVec3(const float *v) {
+	return set(v[0], v[1], v[2], 0.0f);
+}
+
+static inline void storeVec3(float *v, float4 a) {
+	float tmp[4];
+	store(tmp, a);
+	v[0] = tmp[0];
+	v[1] = tmp[1];
+	v[2] = tmp[2];
+}
+
+static inline float dot4(float4 a, float4 b) {
+	float tmp[4];
+	store(tmp, a * b);
+	return (tmp[0] + tmp[1]) + (tmp[2] + tmp[3]);
+}
+
+CCALL void anim_blend_poses(const AnimPose *const *poses, const float *weights, const float *const *masks, int numPoses, AnimPose *out) {
+	int numBones = out->numBones;
+
+	for (int bone = 0; bone < numBones; bone++) {
+		float4 position = zero();
+		float4 rotation = zero();
+		float4 scale = zero();
+		float4 reference = zero();
+		float totalWeight = 0.0f;
+		int numContributions = 0;
+		int last = -1;
+
+		for (int i = 0; i < numPoses; i++) {
+			const AnimPose *pose = poses[i];
+			if (!pose->written[bone])
+				continue;
+
+			float weight = weights[i];
+			if (masks && masks[i])
+				weight *= masks[i][bone];
+			if (weight <= 0.0f)
+				continue;
+
+			float4 w = set1(weight);
+			float4 q = load(&pose->rotations[bone * 4]);
+
+			// keep every rotation in the hemisphere of the first one, q and -q are the same rotation
+			if (numContributions == 0)
+				reference = q;
+			else if (dot4(reference, q) < 0.0f)
+				w = set1(-weight);
+
+			position = position + loadVec3(&pose->positions[bone * 3]) * set1(weight);
+			rotation = rotation + q * w;
+			scale = scale + loadVec3(&pose->scales[bone * 3]) * set1(weight);
+			totalWeight += weight;
+			numContributions++;
+			last = i;
+		}
+
+		if (numContributions == 0) {
+			out->written[bone] = 0;
+			continue;
+		}
+
+		if (numContributions == 1) {
+			const AnimPose *pose = poses[last];
+			memcpy(&out->positions[bone * 3], &pose->positions[bone * 3], sizeof(float) * 3);
+			memcpy(&out->rotations[bone * 4], &pose->rotations[bone * 4], sizeof(float) * 4);
+			memcpy(&out->scales[bone * 3], &pose->scales[bone * 3], sizeof(float) * 3);
+			out->written[bone] = 1;
+			continue;
+		}
+
+		float4 invWeight = set1(1.0f / totalWeight);
+		storeVec3(&out->positions[bone * 3], position * invWeight);
+		storeVec3(&out->scales[bone * 3], scale * invWeight);
+
+		float length = dot4(rotation, rotation);
+		if (length > 0.0f) {
+			store(&out->rotations[bone * 4], rotation / pc::simd::sqrt(set1(length)));
+		} else {
+			// opposite rotations cancelled out, fall back to the first one
+			store(&out->rotations[bone * 4], reference);
+		}
+		out->written[bone] = 1;
+	}
+}
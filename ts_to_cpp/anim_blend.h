@@ -0,0 +1,25 @@
+#ifndef ANIM_BLEND_H
+#define ANIM_BLEND_H
+
+#include "include_ccall.h"
+#include "anim_sampler.h"
+
+/**
+ * N-way pose blending, generalising pc.Skeleton#blend to any number of weighted poses.
+ *
+ * Every bone of the result is the weighted average of the bones of the input poses that were
+ * written (see AnimPose::written). The weight of a pose can be scaled per bone with an optional
+ * mask, which allows layering, e.g. an upper body animation over a locomotion cycle. Positions and
+ * scales are averaged, rotations are accumulated in the hemisphere of the first contributing
+ * rotation and normalized, which avoids slerp and its trigonometry. A bone with a single
+ * contributing pose is copied as is, like pc.Skeleton#blend does.
+ *
+ * All poses must have the same number of bones. out may not be one of the inputs.
+ */
+
+// poses and weights have numPoses entries. masks may be null, or have numPoses entries that are
+// either null (weight applies to every bone) or point to one weight per bone.
+// Bones no pose contributes to are not written.
+CCALL void anim_blend_poses(const AnimPose *const *poses, const float *weights, const float *const *masks, int numPoses, AnimPose *out);
+
+#endif
@@ -0,0 +1,365 @@
+#include "anim_compressed.h"
+#include "native_math.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace pc::native;
+
+#define SQRT2 1.41421356237f
+
+// key values of one track of the clip, 4 floats per rotation and 3 per position or scale
+static inline const float *trackValues(const AnimClip *clip, int track) {
+	if (track == ANIM_TRACK_POSITION)
+		return clip->positions.data();
+	if (track == ANIM_TRACK_ROTATION)
+		return clip->rotations.data();
+	return clip->scales.data();
+}
+
+static inline float vec3Distance(const float *a, const float *b) {
+	float x = a[0] - b[0];
+	float y = a[1] - b[1];
+	float z = a[2] - b[2];
+	return sqrtf(x * x + y * y + z * z);
+}
+
+// Angle of the rotation between two unit quaternions. Goes through the chord between them rather
+// than acos of their dot product, which has no precision left for small angles.
+static inline float quatAngle(const float *a, const float *b) {
+	float sign = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0.0f ? -1.0f : 1.0f;
+	float x = a[0] - b[0] * sign;
+	float y = a[1] - b[1] * sign;
+	float z = a[2] - b[2] * sign;
+	float w = a[3] - b[3] * sign;
+	float chord = sqrtf(x * x + y * y + z * z + w * w) * 0.5f;
+	return 4.0f * asinf(chord < 1.0f ? chord : 1.0f);
+}
+
+static inline float trackDistance(int track, const float *a, const float *b) {
+	return track == ANIM_TRACK_ROTATION ? quatAngle(a, b) : vec3Distance(a, b);
+}
+
+static inline void trackLerp(int track, float *r, const float *a, const float *b, float alpha) {
+	if (track == ANIM_TRACK_ROTATION)
+		quatSlerp(r, a, b, alpha);
+	else
+		vec3Lerp(r, a, b, alpha);
+}
+
+// Smallest-three: drops the largest component, which is positive after flipping the sign of the
+// quaternion, and stores its index in the top bits of the first two values.
+static void encodeQuat(uint16_t *out, const float *q) {
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (fabsf(q[i]) > fabsf(q[largest]))
+			largest = i;
+	}
+
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+	int j = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		// the other components are within [-1/sqrt(2), 1/sqrt(2)]
+		float v = (q[i] * sign * SQRT2 + 1.0f) * 0.5f;
+		v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+		out[j++] = (uint16_t) (v * 32767.0f + 0.5f);
+	}
+	out[0] |= (uint16_t) ((largest >> 1) << 15);
+	out[1] |= (uint16_t) ((largest & 1) << 15);
+}
+
+static void decodeQuat(float *q, const uint16_t *in) {
+	int largest = ((in[0] >> 15) << 1) | (in[1] >> 15);
+	float sum = 0.0f;
+	int j = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float v = ((in[j++] & 0x7fff) * (2.0f / 32767.0f) - 1.0f) * (1.0f / SQRT2);
+		q[i] = v;
+		sum += v * v;
+	}
+	q[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+}
+
+static inline void decodeVec3(float *v, const uint16_t *in, const AnimCompressedTrack &track) {
+	v[0] = track.base[0] + in[0] * track.step[0];
+	v[1] = track.base[1] + in[1] * track.step[1];
+	v[2] = track.base[2] + in[2] * track.step[2];
+}
+
+// Greedy key reduction: starting from a kept key, extends the span to the next kept key as long
+// as interpolating across it reproduces every skipped key within the tolerance. The first and the
+// last key are always kept.
+static void reduceKeys(const AnimClip *clip, int channel, int track, float tolerance, std::vector<int32_t> &kept) {
+	const float *times = clip->times.data();
+	const float *values = trackValues(clip, track);
+	int components = track == ANIM_TRACK_ROTATION ? 4 : 3;
+	int first = clip->keyOffset[channel];
+	int numKeys = clip->keyCount[channel];
+
+	kept.clear();
+	kept.push_back(first);
+	int anchor = 0;
+	int end = 2;
+	while (end < numKeys) {
+		const float *a = values + (first + anchor) * components;
+		const float *b = values + (first + end) * components;
+		float t0 = times[first + anchor];
+		float span = times[first + end] - t0;
+
+		bool fits = true;
+		for (int k = anchor + 1; k < end && fits; k++) {
+			float value[4];
+			float alpha = span > 0.0f ? (times[first + k] - t0) / span : 0.0f;
+			trackLerp(track, value, a, b, alpha);
+			fits = trackDistance(track, value, values + (first + k) * components) <= tolerance;
+		}
+
+		if (fits) {
+			end++;
+		} else {
+			anchor = end - 1;
+			kept.push_back(first + anchor);
+			end = anchor + 2;
+		}
+	}
+	if (numKeys > 1)
+		kept.push_back(first + numKeys - 1);
+}
+
+static void compressTrack(AnimCompressedClip *out, const AnimClip *clip, int channel, int track, float tolerance, std::vector<int32_t> &kept) {
+	const float *times = clip->times.data();
+	const float *values = trackValues(clip, track);
+	int components = track == ANIM_TRACK_ROTATION ? 4 : 3;
+	int first = clip->keyOffset[channel];
+	int numKeys = clip->keyCount[channel];
+
+	AnimCompressedTrack result;
+	memset(&result, 0, sizeof(result));
+	result.type = ANIM_TRACK_CONSTANT;
+	result.timeOffset = (int32_t) out->times.size();
+	result.dataOffset = (int32_t) out->data.size();
+	result.base[3] = 1.0f;
+	out->stats.keys += numKeys;
+	out->stats.tracks++;
+
+	if (numKeys == 0) {
+		out->tracks.push_back(result);
+		out->stats.constantTracks++;
+		return;
+	}
+
+	const float *firstValue = values + first * components;
+	bool constant = true;
+	for (int k = 1; k < numKeys && constant; k++)
+		constant = trackDistance(track, firstValue, values + (first + k) * components) <= tolerance;
+
+	if (constant) {
+		result.numKeys = 1;
+		memcpy(result.base, firstValue, sizeof(float) * components);
+		out->tracks.push_back(result);
+		out->stats.keptKeys++;
+		out->stats.constantTracks++;
+		return;
+	}
+
+	reduceKeys(clip, channel, track, tolerance, kept);
+
+	// position and scale range of the kept keys
+	if (track != ANIM_TRACK_ROTATION) {
+		float lo[3], hi[3];
+		for (int i = 0; i < 3; i++)
+			lo[i] = hi[i] = values[kept[0] * 3 + i];
+		for (size_t k = 1; k < kept.size(); k++) {
+			for (int i = 0; i < 3; i++) {
+				float v = values[kept[k] * 3 + i];
+				lo[i] = v < lo[i] ? v : lo[i];
+				hi[i] = v > hi[i] ? v : hi[i];
+			}
+		}
+		for (int i = 0; i < 3; i++) {
+			result.base[i] = lo[i];
+			result.step[i] = (hi[i] - lo[i]) / 65535.0f;
+		}
+	}
+
+	float timeScale = clip->duration > 0.0f ? 65535.0f / clip->duration : 0.0f;
+	for (size_t k = 0; k < kept.size(); k++) {
+		float t = times[kept[k]] * timeScale;
+		t = t < 0.0f ? 0.0f : (t > 65535.0f ? 65535.0f : t);
+		uint16_t time = (uint16_t) (t + 0.5f);
+		// keys closer than the time resolution would quantize to the same time, keep the first
+		if (result.numKeys > 0 && time <= out->times.back())
+			continue;
+
+		uint16_t data[3];
+		const float *value = values + kept[k] * components;
+		if (track == ANIM_TRACK_ROTATION) {
+			encodeQuat(data, value);
+		} else {
+			for (int i = 0; i < 3; i++) {
+				float v = result.step[i] > 0.0f ? (value[i] - result.base[i]) / result.step[i] : 0.0f;
+				v = v < 0.0f ? 0.0f : (v > 65535.0f ? 65535.0f : v);
+				data[i] = (uint16_t) (v + 0.5f);
+			}
+		}
+
+		out->times.push_back(time);
+		out->data.insert(out->data.end(), data, data + 3);
+		result.numKeys++;
+	}
+
+	result.type = ANIM_TRACK_QUANTIZED;
+	out->tracks.push_back(result);
+	out->stats.keptKeys += result.numKeys;
+}
+
+static void sampleTrack(const AnimCompressedClip *clip, const AnimCompressedTrack &track, int type, float time, float *value) {
+	if (track.type == ANIM_TRACK_CONSTANT) {
+		memcpy(value, track.base, sizeof(float) * (type == ANIM_TRACK_ROTATION ? 4 : 3));
+		return;
+	}
+
+	const uint16_t *times = &clip->times[track.timeOffset];
+	const uint16_t *data = &clip->data[track.dataOffset];
+	float t = clip->duration > 0.0f ? time * (65535.0f / clip->duration) : 0.0f;
+
+	// last key at or before the time
+	int lo = 0;
+	int hi = track.numKeys - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) >> 1;
+		if (times[mid] <= t)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	int k = lo;
+	if (k == track.numKeys - 1 || t <= times[k]) {
+		if (type == ANIM_TRACK_ROTATION)
+			decodeQuat(value, data + k * 3);
+		else
+			decodeVec3(value, data + k * 3, track);
+		return;
+	}
+
+	float alpha = (t - times[k]) / (float) (times[k + 1] - times[k]);
+	float a[4], b[4];
+	if (type == ANIM_TRACK_ROTATION) {
+		decodeQuat(a, data + k * 3);
+		decodeQuat(b, data + k * 3 + 3);
+		quatSlerp(value, a, b, alpha);
+	} else {
+		decodeVec3(a, data + k * 3, track);
+		decodeVec3(b, data + k * 3 + 3, track);
+		vec3Lerp(value, a, b, alpha);
+	}
+}
+
+// The source clip at a time, interpolated like anim_sampler_add_time does.
+static void sampleSource(const AnimClip *clip, int channel, int track, float time, float *value) {
+	const float *times = clip->times.data();
+	const float *values = trackValues(clip, track);
+	int components = track == ANIM_TRACK_ROTATION ? 4 : 3;
+	int first = clip->keyOffset[channel];
+	int numKeys = clip->keyCount[channel];
+
+	int k = 0;
+	while (k < numKeys - 2 && times[first + k + 1] < time)
+		k++;
+
+	if (numKeys == 1 || time <= times[first + k]) {
+		memcpy(value, values + first * components + k * components, sizeof(float) * components);
+		return;
+	}
+	if (time >= times[first + k + 1]) {
+		memcpy(value, values + (first + k + 1) * components, sizeof(float) * components);
+		return;
+	}
+	float alpha = (time - times[first + k]) / (times[first + k + 1] - times[first + k]);
+	trackLerp(track, value, values + (first + k) * components, values + (first + k + 1) * components, alpha);
+}
+
+// Compares the compressed tracks against the source at every source key and halfway between.
+static void measureError(AnimCompressedClip *out, const AnimClip *clip) {
+	float maxError[3] = { 0.0f, 0.0f, 0.0f };
+	for (int c = 0; c < out->numChannels; c++) {
+		int first = clip->keyOffset[c];
+		int numKeys = clip->keyCount[c];
+		for (int k = 0; k < numKeys * 2 - 1; k++) {
+			float time = clip->times[first + k / 2];
+			if (k & 1)
+				time = (time + clip->times[first + k / 2 + 1]) * 0.5f;
+
+			for (int track = 0; track < 3; track++) {
+				float expected[4], actual[4];
+				sampleSource(clip, c, track, time, expected);
+				sampleTrack(out, out->tracks[c * 3 + track], track, time, actual);
+				float error = trackDistance(track, expected, actual);
+				maxError[track] = error > maxError[track] ? error : maxError[track];
+			}
+		}
+	}
+
+	out->stats.maxPositionError = maxError[ANIM_TRACK_POSITION];
+	out->stats.maxRotationError = maxError[ANIM_TRACK_ROTATION];
+	out->stats.maxScaleError = maxError[ANIM_TRACK_SCALE];
+}
+
+CCALL AnimCompressedClip *anim_compress_clip(const AnimClip *clip, float positionTolerance, float rotationTolerance, float scaleTolerance) {
+	AnimCompressedClip *out = new AnimCompressedClip();
+	out->duration = clip->duration;
+	out->numChannels = (int) clip->keyOffset.size();
+	memset(&out->stats, 0, sizeof(out->stats));
+
+	float tolerances[3] = { positionTolerance, rotationTolerance, scaleTolerance };
+	std::vector<int32_t> kept;
+	for (int c = 0; c < out->numChannels; c++) {
+		for (int track = 0; track < 3; track++)
+			compressTrack(out, clip, c, track, tolerances[track], kept);
+	}
+
+	int numKeys = (int) clip->times.size();
+	out->stats.rawBytes = numKeys * (int) sizeof(float) * (1 + 3 + 4 + 3);
+	out->stats.compressedBytes = (int) (out->tracks.size() * sizeof(AnimCompressedTrack) + (out->times.size() + out->data.size()) * sizeof(uint16_t));
+
+	measureError(out, clip);
+	return out;
+}
+
+CCALL void anim_compressed_clip_destroy(AnimCompressedClip *clip) {
+	delete clip;
+}
+
+CCALL AnimCompressionStats *anim_compressed_clip_get_stats(AnimCompressedClip *clip) {
+	return &clip->stats;
+}
+
+CCALL void anim_compressed_clip_print_report(AnimCompressedClip *clip, const char *name) {
+	const AnimCompressionStats &stats = clip->stats;
+	printf("%s: %d -> %d bytes (%.1f%%), keys %d -> %d, %d/%d constant tracks, max error position %g rotation %g rad scale %g\n",
+		name, stats.rawBytes, stats.compressedBytes,
+		stats.rawBytes > 0 ? 100.0 * stats.compressedBytes / stats.rawBytes : 0.0,
+		stats.keys, stats.keptKeys, stats.constantTracks, stats.tracks,
+		stats.maxPositionError, stats.maxRotationError, stats.maxScaleError);
+}
+
+CCALL void anim_compressed_clip_sample(const AnimCompressedClip *clip, float time, const int *channelBones, AnimPose *pose) {
+	for (int c = 0; c < clip->numChannels; c++) {
+		int bone = channelBones[c];
+		const AnimCompressedTrack *tracks = &clip->tracks[c * 3];
+		// channels without keys are not written, like anim_sampler_add_time
+		if (bone < 0 || tracks[ANIM_TRACK_POSITION].numKeys == 0)
+			continue;
+
+		sampleTrack(clip, tracks[ANIM_TRACK_POSITION], ANIM_TRACK_POSITION, time, &pose->positions[bone * 3]);
+		sampleTrack(clip, tracks[ANIM_TRACK_ROTATION], ANIM_TRACK_ROTATION, time, &pose->rotations[bone * 4]);
+		sampleTrack(clip, tracks[ANIM_TRACK_SCALE], ANIM_TRACK_SCALE, time, &pose->scales[bone * 3]);
+		pose->written[bone] = 1;
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef ANIM_COMPRESSED_H
+#define ANIM_COMPRESSED_H
+
+#include "include_ccall.h"
+#include "anim_sampler.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Compressed animation clips.
+ *
+ * anim_compress_clip converts an AnimClip into a compact form that is sampled directly, without
+ * decompressing it first:
+ *
+ *   - every channel has a position, a rotation and a scale track, each with its own keys
+ *   - keys that the neighbouring keys interpolate to within a tolerance are dropped
+ *   - tracks whose keys all stay within the tolerance of the first one become a single constant
+ *   - key times are stored as 16 bit fractions of the clip duration
+ *   - positions and scales are stored as 16 bits per component within the range of the track
+ *   - rotations use smallest-three quantization: the largest component is dropped (it follows
+ *     from the other three of a unit quaternion), its index goes into 2 bits and the other three
+ *     components into 15 bits each, 6 bytes per rotation
+ *
+ * The converter measures the error of the result against the source clip, see
+ * AnimCompressionStats and anim_compressed_clip_print_report.
+ */
+
+#define ANIM_TRACK_CONSTANT 0
+#define ANIM_TRACK_QUANTIZED 1
+
+#define ANIM_TRACK_POSITION 0
+#define ANIM_TRACK_ROTATION 1
+#define ANIM_TRACK_SCALE 2
+
+struct AnimCompressedTrack {
+	uint8_t type;
+	int32_t numKeys;
+	int32_t timeOffset; // first key time in AnimCompressedClip::times
+	int32_t dataOffset; // first value in AnimCompressedClip::data, 3 per key
+	// the value of constant tracks, the minimum of quantized positions and scales
+	float base[4];
+	// size of one quantization step of quantized positions and scales
+	float step[3];
+};
+
+struct AnimCompressionStats {
+	int rawBytes;        // size of the source clip's keys
+	int compressedBytes;
+	int keys;            // keys of all tracks of the source clip
+	int keptKeys;        // keys left after reduction, constant tracks count as one
+	int constantTracks;
+	int tracks;
+	float maxPositionError;
+	float maxRotationError; // radians
+	float maxScaleError;
+};
+
+struct AnimCompressedClip {
+	float duration;
+	int numChannels;
+	std::vector<AnimCompressedTrack> tracks; // 3 per channel: position, rotation, scale
+	std::vector<uint16_t> times;             // fraction of the duration, 0 to 65535
+	std::vector<uint16_t> data;
+	AnimCompressionStats stats;
+};
+
+// Tolerances are in the units of the tracks, the rotation tolerance is an angle in radians.
+CCALL AnimCompressedClip *anim_compress_clip(const AnimClip *clip, float positionTolerance, float rotationTolerance, float scaleTolerance);
+CCALL void anim_compressed_clip_destroy(AnimCompressedClip *clip);
+CCALL AnimCompressionStats *anim_compressed_clip_get_stats(AnimCompressedClip *clip);
+// Prints one line with the size and the error of the clip.
+CCALL void anim_compressed_clip_print_report(AnimCompressedClip *clip, const char *name);
+
+// Samples every channel at time (0 to duration) into the pose, channelBones maps channels to
+// bones as for anim_sampler_create.
+CCALL void anim_compressed_clip_sample(const AnimCompressedClip *clip, float time, const int *channelBones, AnimPose *pose);
+
+#endif
@@ -0,0 +1,158 @@
+#include "anim_crowd.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+CCALL AnimCrowd *anim_crowd_create() {
+	AnimCrowd *crowd = new AnimCrowd();
+	crowd->orderDirty = false;
+	crowd->delta = 0.0f;
+	crowd->stats.members = 0;
+	crowd->stats.clips = 0;
+	crowd->stats.batches = 0;
+	return crowd;
+}
+
+CCALL void anim_crowd_destroy(AnimCrowd *crowd) {
+	for (size_t i = 0; i < crowd->members.size(); i++) {
+		if (crowd->members[i].sampler) {
+			anim_sampler_destroy(crowd->members[i].sampler);
+			anim_pose_destroy(crowd->members[i].pose);
+		}
+	}
+	for (size_t i = 0; i < crowd->freePoses.size(); i++)
+		anim_pose_destroy(crowd->freePoses[i]);
+	delete crowd;
+}
+
+static AnimPose *acquirePose(AnimCrowd *crowd, int numBones) {
+	for (size_t i = 0; i < crowd->freePoses.size(); i++) {
+		AnimPose *pose = crowd->freePoses[i];
+		if (pose->numBones == numBones) {
+			crowd->freePoses[i] = crowd->freePoses.back();
+			crowd->freePoses.pop_back();
+			// the transforms of the last member are still in it
+			anim_pose_reset(pose);
+			return pose;
+		}
+	}
+	return anim_pose_create(numBones);
+}
+
+CCALL int anim_crowd_add(AnimCrowd *crowd, const AnimClip *clip, const int *channelBones, int numBones) {
+	int handle;
+	if (!crowd->freeHandles.empty()) {
+		handle = crowd->freeHandles.back();
+		crowd->freeHandles.pop_back();
+	} else {
+		handle = (int) crowd->members.size();
+		crowd->members.push_back(AnimCrowdMember());
+	}
+
+	AnimCrowdMember &member = crowd->members[handle];
+	member.sampler = anim_sampler_create(clip, channelBones);
+	member.pose = acquirePose(crowd, numBones);
+	member.speed = 1.0f;
+
+	crowd->orderDirty = true;
+	return handle;
+}
+
+CCALL void anim_crowd_remove(AnimCrowd *crowd, int handle) {
+	AnimCrowdMember &member = crowd->members[handle];
+	if (!member.sampler)
+		return;
+
+	anim_sampler_destroy(member.sampler);
+	crowd->freePoses.push_back(member.pose);
+	member.sampler = NULL;
+	member.pose = NULL;
+
+	crowd->freeHandles.push_back(handle);
+	crowd->orderDirty = true;
+}
+
+CCALL AnimSampler *anim_crowd_get_sampler(AnimCrowd *crowd, int handle) {
+	return crowd->members[handle].sampler;
+}
+
+CCALL AnimPose *anim_crowd_get_pose(AnimCrowd *crowd, int handle) {
+	return crowd->members[handle].pose;
+}
+
+CCALL void anim_crowd_set_speed(AnimCrowd *crowd, int handle, float speed) {
+	crowd->members[handle].speed = speed;
+}
+
+struct ByClip {
+	const AnimCrowd *crowd;
+
+	bool operator()(int32_t a, int32_t b) const {
+		const AnimClip *clipA = crowd->members[a].sampler->clip;
+		const AnimClip *clipB = crowd->members[b].sampler->clip;
+		if (clipA != clipB)
+			return clipA < clipB;
+		return a < b;
+	}
+};
+
+// Groups the members by clip and cuts every group into batches.
+static void buildBatches(AnimCrowd *crowd) {
+	crowd->order.clear();
+	for (int i = 0; i < (int) crowd->members.size(); i++) {
+		if (crowd->members[i].sampler)
+			crowd->order.push_back(i);
+	}
+
+	ByClip byClip;
+	byClip.crowd = crowd;
+	std::sort(crowd->order.begin(), crowd->order.end(), byClip);
+
+	crowd->batches.clear();
+	crowd->stats.clips = 0;
+	int count = (int) crowd->order.size();
+	int begin = 0;
+	while (begin < count) {
+		const AnimClip *clip = crowd->members[crowd->order[begin]].sampler->clip;
+		int end = begin + 1;
+		while (end < count && crowd->members[crowd->order[end]].sampler->clip == clip)
+			end++;
+		crowd->stats.clips++;
+
+		for (int b = begin; b < end; b += ANIM_CROWD_BATCH_SIZE) {
+			crowd->batches.push_back(b);
+			crowd->batches.push_back(std::min(b + ANIM_CROWD_BATCH_SIZE, end));
+		}
+		begin = end;
+	}
+
+	crowd->orderDirty = false;
+}
+
+static void updateBatches(void *userData, int begin, int end) {
+	AnimCrowd *crowd = (AnimCrowd *) userData;
+	for (int batch = begin; batch < end; batch++) {
+		int first = crowd->batches[batch * 2];
+		int last = crowd->batches[batch * 2 + 1];
+		for (int i = first; i < last; i++) {
+			AnimCrowdMember &member = crowd->members[crowd->order[i]];
+			anim_sampler_add_time(member.sampler, crowd->delta * member.speed, member.pose);
+		}
+	}
+}
+
+CCALL void anim_crowd_update(AnimCrowd *crowd, float delta) {
+	if (crowd->orderDirty)
+		buildBatches(crowd);
+
+	int numBatches = (int) crowd->batches.size() / 2;
+	crowd->delta = delta;
+	pc::parallel_for(numBatches, 1, updateBatches, crowd);
+
+	crowd->stats.members = (int) crowd->order.size();
+	crowd->stats.batches = numBatches;
+}
+
+CCALL AnimCrowdStats *anim_crowd_get_stats(AnimCrowd *crowd) {
+	return &crowd->stats;
+}
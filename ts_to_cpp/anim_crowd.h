@@ -0,0 +1,70 @@
+#ifndef ANIM_CROWD_H
+#define ANIM_CROWD_H
+
+#include "include_ccall.h"
+#include "anim_sampler.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Evaluates many animated skeletons at once.
+ *
+ * Every member of a crowd is an AnimSampler and the AnimPose it writes to, the native side of one
+ * pc.Skeleton. Members are grouped by clip and the groups are cut into batches that run on the
+ * thread pool, so characters sharing a clip are sampled back to back while its keys are in cache.
+ * Each member runs exactly the code of anim_sampler_add_time on its own sampler and pose, so the
+ * results are bit-identical to stepping the skeletons one by one.
+ *
+ * Poses come from a pool owned by the crowd: removing a member returns its pose, and adding one
+ * reuses a pose of the same size, reset to identity transforms, before allocating a new one.
+ */
+
+// members per job when the crowd is updated on the thread pool
+#define ANIM_CROWD_BATCH_SIZE 16
+
+struct AnimCrowdMember {
+	AnimSampler *sampler; // null when the handle is free
+	AnimPose *pose;
+	float speed;
+};
+
+struct AnimCrowdStats {
+	int members;  // members updated by the last anim_crowd_update
+	int clips;    // distinct clips among them
+	int batches;  // jobs they were split into
+};
+
+struct AnimCrowd {
+	std::vector<AnimCrowdMember> members; // per handle
+	std::vector<int32_t> freeHandles;
+	std::vector<AnimPose *> freePoses;
+
+	// member handles grouped by clip, and [begin, end) ranges of it per job
+	std::vector<int32_t> order;
+	std::vector<int32_t> batches;
+	bool orderDirty;
+
+	float delta; // of the update in progress
+	AnimCrowdStats stats;
+};
+
+CCALL AnimCrowd *anim_crowd_create();
+// Destroys the samplers and poses of all members as well.
+CCALL void anim_crowd_destroy(AnimCrowd *crowd);
+
+// Adds a skeleton playing clip, see anim_sampler_create. Returns the member handle.
+CCALL int anim_crowd_add(AnimCrowd *crowd, const AnimClip *clip, const int *channelBones, int numBones);
+CCALL void anim_crowd_remove(AnimCrowd *crowd, int handle);
+
+// The sampler can be configured with the anim_sampler functions (looping, time).
+CCALL AnimSampler *anim_crowd_get_sampler(AnimCrowd *crowd, int handle);
+CCALL AnimPose *anim_crowd_get_pose(AnimCrowd *crowd, int handle);
+// Multiplies the time step of one member, 1 by default.
+CCALL void anim_crowd_set_speed(AnimCrowd *crowd, int handle, float speed);
+
+// Advances every member by delta times its speed.
+CCALL void anim_crowd_update(AnimCrowd *crowd, float delta);
+CCALL AnimCrowdStats *anim_crowd_get_stats(AnimCrowd *crowd);
+
+#endif
@@ -0,0 +1,321 @@
+#include "anim_sampler.h"
+#include "native_math.h"
+#include "simd_float4.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+using namespace pc::native;
+using namespace pc::simd;
+
+CCALL AnimClip *anim_clip_create(float duration) {
+	AnimClip *clip = new AnimClip();
+	clip->duration = duration;
+	return clip;
+}
+
+CCALL void anim_clip_destroy(AnimClip *clip) {
+	delete clip;
+}
+
+CCALL int anim_clip_add_channel(AnimClip *clip, int numKeys, const float *times, const float *positions, const float *rotations, const float *scales) {
+	int channel = (int) clip->keyOffset.size();
+	clip->keyOffset.push_back((int32_t) clip->times.size());
+	clip->keyCount.push_back(numKeys);
+
+	clip->times.insert(clip->times.end(), times, times + numKeys);
+	clip->positions.insert(clip->positions.end(), positions, positions + numKeys * 3);
+	clip->rotations.insert(clip->rotations.end(), rotations, rotations + numKeys * 4);
+	clip->scales.insert(clip->scales.end(), scales, scales + numKeys * 3);
+	return channel;
+}
+
+CCALL int anim_clip_get_num_channels(AnimClip *clip) {
+	return (int) clip->keyOffset.size();
+}
+
+CCALL float anim_clip_get_duration(AnimClip *clip) {
+	return clip->duration;
+}
+
+CCALL AnimPose *anim_pose_create(int numBones) {
+	AnimPose *pose = new AnimPose();
+	pose->numBones = numBones;
+	pose->positions.resize(numBones * 3);
+	pose->rotations.resize(numBones * 4);
+	pose->scales.resize(numBones * 3);
+	pose->written.resize(numBones);
+	anim_pose_reset(pose);
+	return pose;
+}
+
+CCALL void anim_pose_reset(AnimPose *pose) {
+	int numBones = pose->numBones;
+	std::fill(pose->positions.begin(), pose->positions.end(), 0.0f);
+	std::fill(pose->scales.begin(), pose->scales.end(), 1.0f);
+	for (int i = 0; i < numBones; i++) {
+		float *q = &pose->rotations[i * 4];
+		q[0] = q[1] = q[2] = 0.0f;
+		q[3] = 1.0f;
+	}
+	anim_pose_clear_written(pose);
+}
+
+CCALL void anim_pose_destroy(AnimPose *pose) {
+	delete pose;
+}
+
+CCALL float *anim_pose_get_positions(AnimPose *pose) {
+	return pose->positions.data();
+}
+
+CCALL float *anim_pose_get_rotations(AnimPose *pose) {
+	return pose->rotations.data();
+}
+
+CCALL float *anim_pose_get_scales(AnimPose *pose) {
+	return pose->scales.data();
+}
+
+CCALL uint8_t *anim_pose_get_written(AnimPose *pose) {
+	return pose->written.data();
+}
+
+CCALL void anim_pose_clear_written(AnimPose *pose) {
+	memset(pose->written.data(), 0, pose->written.size());
+}
+
+CCALL AnimSampler *anim_sampler_create(const AnimClip *clip, const int *channelBones) {
+	int numChannels = (int) clip->keyOffset.size();
+
+	AnimSampler *sampler = new AnimSampler();
+	sampler->clip = clip;
+	sampler->time = 0.0f;
+	sampler->looping = true;
+	sampler->channelBone.assign(channelBones, channelBones + numChannels);
+	sampler->cursor.assign(numChannels, 0);
+
+	sampler->sampleBone.reserve(numChannels);
+	sampler->sampleKey.reserve(numChannels);
+	sampler->sampleAlpha.reserve(numChannels);
+	sampler->copyBone.reserve(numChannels);
+	sampler->copyKey.reserve(numChannels);
+	return sampler;
+}
+
+CCALL void anim_sampler_destroy(AnimSampler *sampler) {
+	delete sampler;
+}
+
+CCALL void anim_sampler_set_looping(AnimSampler *sampler, int looping) {
+	sampler->looping = looping != 0;
+}
+
+CCALL void anim_sampler_set_time(AnimSampler *sampler, float time) {
+	sampler->time = time;
+	for (size_t i = 0; i < sampler->cursor.size(); i++)
+		sampler->cursor[i] = 0;
+}
+
+CCALL float anim_sampler_get_time(AnimSampler *sampler) {
+	return sampler->time;
+}
+
+// Finds the key pair around the current time for every channel.
+static void searchKeys(AnimSampler *sampler, int offset) {
+	const AnimClip *clip = sampler->clip;
+	const float *times = clip->times.data();
+	float time = sampler->time;
+	int numChannels = (int) clip->keyOffset.size();
+
+	sampler->sampleBone.clear();
+	sampler->sampleKey.clear();
+	sampler->sampleAlpha.clear();
+	sampler->copyBone.clear();
+	sampler->copyKey.clear();
+
+	for (int c = 0; c < numChannels; c++) {
+		int bone = sampler->channelBone[c];
+		int numKeys = clip->keyCount[c];
+		if (bone < 0 || numKeys == 0)
+			continue;
+
+		int first = clip->keyOffset[c];
+		bool found = false;
+		if (numKeys != 1) {
+			for (int k = sampler->cursor[c]; k < numKeys - 1 && k >= 0; k += offset) {
+				float t1 = times[first + k];
+				float t2 = times[first + k + 1];
+				if (t1 <= time && t2 >= time) {
+					sampler->sampleBone.push_back(bone);
+					sampler->sampleKey.push_back(first + k);
+					sampler->sampleAlpha.push_back((time - t1) / (t2 - t1));
+					sampler->cursor[c] = k;
+					found = true;
+					break;
+				}
+			}
+		}
+
+		if (numKeys == 1 || (!found && time == 0.0f && sampler->looping)) {
+			sampler->copyBone.push_back(bone);
+			sampler->copyKey.push_back(first);
+		}
+	}
+}
+
+static inline float4 loadVec3(const float *v) {
+	return set(v[0], v[1], v[2], 0.0f);
+}
+
+static inline void storeVec3(float *v, float4 a) {
+	float tmp[4];
+	store(tmp, a);
+	v[0] = tmp[0];
+	v[1] = tmp[1];
+	v[2] = tmp[2];
+}
+
+// a + alpha * (b - a) of the xyz at a and the one following it, pc.Vec3#lerp
+static inline void lerpKeys3(float *r, const float *a, float4 alpha) {
+	float4 from = loadVec3(a);
+	storeVec3(r, from + alpha * (loadVec3(a + 3) - from));
+}
+
+// pc.Quat#slerp of 4 key pairs, lane i interpolating the quaternion at keys[i] and the one
+// following it into out[i]. The weights need acosf and sinf, which are left to the scalar code for
+// the lanes that take them; everything else is done for the 4 lanes at once.
+static void slerpKeys4(float *const *out, const float *const *keys, float4 alpha) {
+	float4 ax = load(keys[0]), ay = load(keys[1]), az = load(keys[2]), aw = load(keys[3]);
+	float4 bx = load(keys[0] + 4), by = load(keys[1] + 4), bz = load(keys[2] + 4), bw = load(keys[3] + 4);
+	transpose(ax, ay, az, aw);
+	transpose(bx, by, bz, bw);
+
+	// take the shorter way around
+	float4 cosHalfTheta = aw * bw + ax * bx + ay * by + az * bz;
+	float4 flip = cmplt(cosHalfTheta, zero());
+	bx = select(flip, zero() - bx, bx);
+	by = select(flip, zero() - by, by);
+	bz = select(flip, zero() - bz, bz);
+	bw = select(flip, zero() - bw, bw);
+	cosHalfTheta = select(flip, zero() - cosHalfTheta, cosHalfTheta);
+
+	float4 one = set1(1.0f);
+	float4 sinHalfTheta = pc::simd::sqrt(one - cosHalfTheta * cosHalfTheta);
+
+	// lhs == rhs or lhs == -rhs: all of a; 180 degrees apart: half of each
+	int same = movemask(cmpge(cosHalfTheta, one));
+	int opposite = movemask(cmplt(sinHalfTheta, set1(0.001f)));
+
+	float cosLanes[4], sinLanes[4], alphaLanes[4], ratioA[4], ratioB[4];
+	store(cosLanes, cosHalfTheta);
+	store(sinLanes, sinHalfTheta);
+	store(alphaLanes, alpha);
+	for (int i = 0; i < 4; i++) {
+		if (same & (1 << i)) {
+			ratioA[i] = 1.0f;
+			ratioB[i] = 0.0f;
+		} else if (opposite & (1 << i)) {
+			ratioA[i] = 0.5f;
+			ratioB[i] = 0.5f;
+		} else {
+			float halfTheta = acosf(cosLanes[i]);
+			ratioA[i] = sinf((1 - alphaLanes[i]) * halfTheta) / sinLanes[i];
+			ratioB[i] = sinf(alphaLanes[i] * halfTheta) / sinLanes[i];
+		}
+	}
+
+	float4 wa = load(ratioA);
+	float4 wb = load(ratioB);
+	float4 rx = ax * wa + bx * wb;
+	float4 ry = ay * wa + by * wb;
+	float4 rz = az * wa + bz * wb;
+	float4 rw = aw * wa + bw * wb;
+	transpose(rx, ry, rz, rw);
+	store(out[0], rx);
+	store(out[1], ry);
+	store(out[2], rz);
+	store(out[3], rw);
+}
+
+// Interpolates the key pairs found by searchKeys into the pose.
+static void interpolate(const AnimSampler *sampler, AnimPose *pose) {
+	const AnimClip *clip = sampler->clip;
+	const float *positions = clip->positions.data();
+	const float *rotations = clip->rotations.data();
+	const float *scales = clip->scales.data();
+	float *posePositions = pose->positions.data();
+	float *poseRotations = pose->rotations.data();
+	float *poseScales = pose->scales.data();
+
+	int numSamples = (int) sampler->sampleBone.size();
+	const int32_t *sampleBone = sampler->sampleBone.data();
+	const int32_t *sampleKey = sampler->sampleKey.data();
+	const float *sampleAlpha = sampler->sampleAlpha.data();
+
+	// 4 samples at a time, the rest one by one
+	int i = 0;
+	for (; i + 4 <= numSamples; i += 4) {
+		float4 alpha = load(sampleAlpha + i);
+		float *out[4];
+		const float *keys[4];
+		for (int j = 0; j < 4; j++) {
+			int bone = sampleBone[i + j];
+			int key = sampleKey[i + j];
+			float4 alphaLane = set1(sampleAlpha[i + j]);
+
+			lerpKeys3(posePositions + bone * 3, positions + key * 3, alphaLane);
+			lerpKeys3(poseScales + bone * 3, scales + key * 3, alphaLane);
+			out[j] = poseRotations + bone * 4;
+			keys[j] = rotations + key * 4;
+			pose->written[bone] = 1;
+		}
+		slerpKeys4(out, keys, alpha);
+	}
+	for (; i < numSamples; i++) {
+		int bone = sampleBone[i];
+		int key = sampleKey[i];
+		float alpha = sampleAlpha[i];
+
+		vec3Lerp(posePositions + bone * 3, positions + key * 3, positions + key * 3 + 3, alpha);
+		quatSlerp(poseRotations + bone * 4, rotations + key * 4, rotations + key * 4 + 4, alpha);
+		vec3Lerp(poseScales + bone * 3, scales + key * 3, scales + key * 3 + 3, alpha);
+		pose->written[bone] = 1;
+	}
+
+	int numCopies = (int) sampler->copyBone.size();
+	for (int i = 0; i < numCopies; i++) {
+		int bone = sampler->copyBone[i];
+		int key = sampler->copyKey[i];
+
+		memcpy(posePositions + bone * 3, positions + key * 3, sizeof(float) * 3);
+		memcpy(poseRotations + bone * 4, rotations + key * 4, sizeof(float) * 4);
+		memcpy(poseScales + bone * 3, scales + key * 3, sizeof(float) * 3);
+		pose->written[bone] = 1;
+	}
+}
+
+CCALL void anim_sampler_add_time(AnimSampler *sampler, float delta, AnimPose *pose) {
+	const AnimClip *clip = sampler->clip;
+	float duration = clip->duration;
+	int numChannels = (int) clip->keyOffset.size();
+
+	if (sampler->time == duration && !sampler->looping)
+		return;
+
+	// step the time, then wrap around or clamp
+	sampler->time += delta;
+	if (sampler->time > duration) {
+		sampler->time = sampler->looping ? 0.0f : duration;
+		for (int c = 0; c < numChannels; c++)
+			sampler->cursor[c] = 0;
+	} else if (sampler->time < 0.0f) {
+		sampler->time = sampler->looping ? duration : 0.0f;
+		for (int c = 0; c < numChannels; c++)
+			sampler->cursor[c] = clip->keyCount[c] - 2;
+	}
+
+	searchKeys(sampler, delta >= 0.0f ? 1 : -1);
+	interpolate(sampler, pose);
+}
@@ -0,0 +1,95 @@
+#ifndef ANIM_SAMPLER_H
+#define ANIM_SAMPLER_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Native keyframe sampling for pc.Skeleton#addTime.
+ *
+ * An AnimClip holds the keys of a pc.Animation as contiguous arrays, one channel per pc.Node with
+ * its keys back to back. An AnimSampler plays a clip for one skeleton: the node names of the clip
+ * are resolved to bone indices once when the sampler is created, so stepping the animation only
+ * deals with integers. Sampling writes into an AnimPose, one SoA buffer of local positions,
+ * rotations and scales per skeleton, bone i being pc.Skeleton#_interpolatedKeys[i].
+ *
+ * anim_sampler_add_time follows pc.Skeleton#addTime step by step (key cursors, wrapping, clamping,
+ * the single key and looping special cases). It works in two passes: the key search per channel,
+ * then the interpolation over the flat list of channels that found a key pair. The interpolation
+ * works on simd_float4: positions and scales one channel at a time, rotations 4 channels at a time
+ * with the branches of pc.Quat#slerp turned into lane masks. Only the acosf and sinf of the slerp
+ * weights stay scalar, there is no vector version of them to use.
+ */
+
+struct AnimClip {
+	float duration;
+
+	// per channel
+	std::vector<int32_t> keyOffset; // index of the first key of the channel
+	std::vector<int32_t> keyCount;
+
+	// per key, channel after channel
+	std::vector<float> times;
+	std::vector<float> positions; // xyz
+	std::vector<float> rotations; // xyzw
+	std::vector<float> scales;    // xyz
+};
+
+struct AnimPose {
+	int numBones;
+	std::vector<float> positions; // xyz
+	std::vector<float> rotations; // xyzw
+	std::vector<float> scales;    // xyz
+	// 1 when the bone was sampled since the flags were last cleared, pc.InterpolatedKey#_written
+	std::vector<uint8_t> written;
+};
+
+struct AnimSampler {
+	const AnimClip *clip;
+	float time;
+	bool looping;
+
+	// per channel
+	std::vector<int32_t> channelBone; // -1 when the skeleton has no node of that name
+	std::vector<int32_t> cursor;      // key the last search ended at, pc.Skeleton#_currKeyIndices
+
+	// scratch for the interpolation pass, one entry per channel that found its keys
+	std::vector<int32_t> sampleBone;
+	std::vector<int32_t> sampleKey;   // first key, the second one follows it
+	std::vector<float> sampleAlpha;
+	std::vector<int32_t> copyBone;    // bones that take a key as is
+	std::vector<int32_t> copyKey;
+};
+
+CCALL AnimClip *anim_clip_create(float duration);
+CCALL void anim_clip_destroy(AnimClip *clip);
+// Appends a channel and returns its index. The keys are copied, times must be ascending.
+CCALL int anim_clip_add_channel(AnimClip *clip, int numKeys, const float *times, const float *positions, const float *rotations, const float *scales);
+CCALL int anim_clip_get_num_channels(AnimClip *clip);
+CCALL float anim_clip_get_duration(AnimClip *clip);
+
+CCALL AnimPose *anim_pose_create(int numBones);
+CCALL void anim_pose_destroy(AnimPose *pose);
+// Back to the state of a new pose: identity transforms, no bone written.
+CCALL void anim_pose_reset(AnimPose *pose);
+CCALL float *anim_pose_get_positions(AnimPose *pose);
+CCALL float *anim_pose_get_rotations(AnimPose *pose);
+CCALL float *anim_pose_get_scales(AnimPose *pose);
+CCALL uint8_t *anim_pose_get_written(AnimPose *pose);
+// pc.Skeleton#updateGraph clears the flags of the bones it applied.
+CCALL void anim_pose_clear_written(AnimPose *pose);
+
+// channelBones has one entry per channel of the clip: the skeleton bone driven by the channel, or
+// -1. The clip must outlive the sampler.
+CCALL AnimSampler *anim_sampler_create(const AnimClip *clip, const int *channelBones);
+CCALL void anim_sampler_destroy(AnimSampler *sampler);
+CCALL void anim_sampler_set_looping(AnimSampler *sampler, int looping);
+// Same as setting pc.Skeleton#currentTime, call anim_sampler_add_time with 0 afterwards to sample.
+CCALL void anim_sampler_set_time(AnimSampler *sampler, float time);
+CCALL float anim_sampler_get_time(AnimSampler *sampler);
+// pc.Skeleton#addTime, the sampled bones are written to pose.
+CCALL void anim_sampler_add_time(AnimSampler *sampler, float delta, AnimPose *pose);
+
+#endif
@@ -0,0 +1,66 @@
+#include "auto_instancing.h"
+
+#include <string.h>
+
+CCALL AutoInstancer *auto_instancing_create(TransformStore *store, int maxInstances) {
+	AutoInstancer *instancer = new AutoInstancer();
+	instancer->store = store;
+	instancer->maxInstances = maxInstances;
+	instancer->buffer.resize(maxInstances * AUTO_INSTANCING_FLOATS);
+	memset(&instancer->stats, 0, sizeof(instancer->stats));
+	return instancer;
+}
+
+CCALL void auto_instancing_destroy(AutoInstancer *instancer) {
+	delete instancer;
+}
+
+CCALL int auto_instancing_build(AutoInstancer *instancer, const uint64_t *keys, const int *handles, int count) {
+	const float *world = &instancer->store->worldTransform[0];
+	const int32_t *handleSlot = &instancer->store->handleSlot[0];
+	int maxInstances = instancer->maxInstances;
+	int used = 0;
+
+	instancer->runs.clear();
+	for (int i = 0, j; i < count; i = j) {
+		j = i + 1;
+		if (!keys[i])
+			continue;
+		while (j < count && keys[j] == keys[i] && used + j - i < maxInstances)
+			j++;
+		if (j - i < 2)
+			continue;
+
+		AutoInstancingRun run;
+		run.first = i;
+		run.count = j - i;
+		run.offset = used;
+		instancer->runs.push_back(run);
+
+		float *out = instancer->buffer.data() + used * AUTO_INSTANCING_FLOATS;
+		for (int k = i; k < j; k++, out += AUTO_INSTANCING_FLOATS)
+			memcpy(out, world + handleSlot[handles[k]] * 16, sizeof(float) * 16);
+		used += j - i;
+	}
+
+	int runs = (int) instancer->runs.size();
+	instancer->stats.drawCalls = count;
+	instancer->stats.runs = runs;
+	instancer->stats.instances = used;
+	instancer->stats.drawCallsSaved = used - runs;
+	return runs;
+}
+
+CCALL const AutoInstancingRun *auto_instancing_get_runs(AutoInstancer *instancer, int *count) {
+	*count = (int) instancer->runs.size();
+	return instancer->runs.data();
+}
+
+CCALL const float *auto_instancing_get_buffer(AutoInstancer *instancer, int *numInstances) {
+	*numInstances = instancer->stats.instances;
+	return instancer->buffer.data();
+}
+
+CCALL AutoInstancingStats *auto_instancing_get_stats(AutoInstancer *instancer) {
+	return &instancer->stats;
+}
@@ -0,0 +1,58 @@
+#ifndef AUTO_INSTANCING_H
+#define AUTO_INSTANCING_H
+
+#include "include_ccall.h"
+#include "transform_store.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Automatic instancing of sorted draw calls, the work of pc.ForwardRenderer#_prepareAutoInstancing.
+ *
+ * Every draw call carries a key for the state it is drawn with (mesh, material, render style,
+ * shader defines and light mask), or 0 when it cannot be instanced. Consecutive draw calls with the
+ * same key form a run, and the world matrices of every run are copied from the TransformStore into
+ * one instance buffer in a single pass, so each run is drawn with one instanced draw call.
+ */
+
+// 16 floats per instance, the layout of pc._instanceVertexFormat
+#define AUTO_INSTANCING_FLOATS 16
+
+struct AutoInstancingRun {
+	int first;   // index of the first draw call of the run
+	int count;   // draw calls in the run, at least 2
+	int offset;  // first instance in the buffer
+};
+
+struct AutoInstancingStats {
+	int drawCalls;
+	int runs;
+	int instances;        // draw calls drawn through runs
+	int drawCallsSaved;   // instances - runs
+};
+
+struct AutoInstancer {
+	TransformStore *store;
+	int maxInstances;
+	std::vector<float> buffer;  // maxInstances * AUTO_INSTANCING_FLOATS
+	std::vector<AutoInstancingRun> runs;
+	AutoInstancingStats stats;
+};
+
+// maxInstances is the size of the instance buffer, pc.GraphicsDevice#autoInstancingMaxObjects.
+CCALL AutoInstancer *auto_instancing_create(TransformStore *store, int maxInstances);
+CCALL void auto_instancing_destroy(AutoInstancer *instancer);
+
+// Finds the runs of count sorted draw calls and packs their world matrices. keys holds the state
+// key of every draw call, 0 when it cannot be instanced, and handles its TransformStore handle.
+// Returns the number of runs.
+CCALL int auto_instancing_build(AutoInstancer *instancer, const uint64_t *keys, const int *handles, int count);
+
+CCALL const AutoInstancingRun *auto_instancing_get_runs(AutoInstancer *instancer, int *count);
+// Instance matrices of all runs, run i starting at runs[i].offset * AUTO_INSTANCING_FLOATS.
+CCALL const float *auto_instancing_get_buffer(AutoInstancer *instancer, int *numInstances);
+
+CCALL AutoInstancingStats *auto_instancing_get_stats(AutoInstancer *instancer);
+
+#endif
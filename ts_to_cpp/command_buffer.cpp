@@ -0,0 +1,300 @@
+#include "command_buffer.h"
+#include "thread_pool.h"
+
+#include <string.h>
+
+// layers per job
+#define COMMAND_RECORDER_GRAIN 1
+
+// bits of CommandBuffer::known
+#define KNOWN_SHADER (1u << 0)
+#define KNOWN_BLEND (1u << 1)
+#define KNOWN_DEPTH (1u << 2)
+#define KNOWN_CULL (1u << 3)
+#define KNOWN_VIEWPORT (1u << 4)
+#define KNOWN_VERTEX_BUFFER (1u << 5) // two bits, one per stream
+#define KNOWN_INDEX_BUFFER (1u << 7)
+
+CCALL CommandBuffer *command_buffer_create() {
+	CommandBuffer *buffer = new CommandBuffer();
+	command_buffer_reset(buffer);
+	return buffer;
+}
+
+CCALL void command_buffer_destroy(CommandBuffer *buffer) {
+	delete buffer;
+}
+
+CCALL void command_buffer_reset(CommandBuffer *buffer) {
+	buffer->data.clear();
+	buffer->numCommands = 0;
+	buffer->numDraws = 0;
+	buffer->skipped = 0;
+	buffer->known = 0;
+}
+
+// appends a command with room for size payload bytes and returns the payload
+static void *append(CommandBuffer *buffer, CommandType type, size_t size) {
+	size_t aligned = (size + 3) & ~(size_t) 3;
+	size_t at = buffer->data.size();
+	buffer->data.resize(at + sizeof(CommandHeader) + aligned);
+
+	CommandHeader header;
+	header.type = (uint16_t) type;
+	header.size = (uint16_t) aligned;
+	memcpy(&buffer->data[at], &header, sizeof(header));
+	buffer->numCommands++;
+	return &buffer->data[at + sizeof(CommandHeader)];
+}
+
+template <typename T>
+static void appendPayload(CommandBuffer *buffer, CommandType type, const T &payload) {
+	memcpy(append(buffer, type, sizeof(T)), &payload, sizeof(T));
+}
+
+// true when the state is already recorded, otherwise stores it as known
+template <typename T>
+static bool sameState(CommandBuffer *buffer, uint32_t bit, T &current, const T &value) {
+	if ((buffer->known & bit) && memcmp(&current, &value, sizeof(T)) == 0) {
+		buffer->skipped++;
+		return true;
+	}
+	buffer->known |= bit;
+	current = value;
+	return false;
+}
+
+CCALL void command_buffer_set_shader(CommandBuffer *buffer, uint32_t shader) {
+	if (!sameState(buffer, KNOWN_SHADER, buffer->shader, shader))
+		appendPayload(buffer, COMMAND_SET_SHADER, shader);
+}
+
+CCALL void command_buffer_set_blend(CommandBuffer *buffer, const CommandBlend *blend) {
+	if (!sameState(buffer, KNOWN_BLEND, buffer->blend, *blend))
+		appendPayload(buffer, COMMAND_SET_BLEND, *blend);
+}
+
+CCALL void command_buffer_set_depth(CommandBuffer *buffer, uint32_t test, uint32_t write) {
+	CommandDepth depth;
+	depth.test = test;
+	depth.write = write;
+	if (!sameState(buffer, KNOWN_DEPTH, buffer->depth, depth))
+		appendPayload(buffer, COMMAND_SET_DEPTH, depth);
+}
+
+CCALL void command_buffer_set_cull(CommandBuffer *buffer, uint32_t cull) {
+	if (!sameState(buffer, KNOWN_CULL, buffer->cull, cull))
+		appendPayload(buffer, COMMAND_SET_CULL, cull);
+}
+
+CCALL void command_buffer_set_viewport(CommandBuffer *buffer, float x, float y, float width, float height) {
+	CommandViewport viewport;
+	viewport.x = x;
+	viewport.y = y;
+	viewport.width = width;
+	viewport.height = height;
+	if (!sameState(buffer, KNOWN_VIEWPORT, buffer->viewport, viewport))
+		appendPayload(buffer, COMMAND_SET_VIEWPORT, viewport);
+}
+
+CCALL void command_buffer_set_vertex_buffer(CommandBuffer *buffer, uint32_t vertexBuffer, uint32_t stream, uint32_t offset) {
+	if (stream >= 2)
+		return;
+
+	CommandVertexBuffer binding;
+	binding.buffer = vertexBuffer;
+	binding.stream = stream;
+	binding.offset = offset;
+	if (!sameState(buffer, KNOWN_VERTEX_BUFFER << stream, buffer->vertexBuffer[stream], binding))
+		appendPayload(buffer, COMMAND_SET_VERTEX_BUFFER, binding);
+}
+
+CCALL void command_buffer_set_index_buffer(CommandBuffer *buffer, uint32_t indexBuffer) {
+	if (!sameState(buffer, KNOWN_INDEX_BUFFER, buffer->indexBuffer, indexBuffer))
+		appendPayload(buffer, COMMAND_SET_INDEX_BUFFER, indexBuffer);
+}
+
+CCALL void command_buffer_uniform(CommandBuffer *buffer, uint32_t id, const float *data, uint32_t count) {
+	// the header holds 16 bits of payload size, large arrays take several commands
+	uint32_t offset = 0;
+	do {
+		uint32_t chunk = count - offset;
+		if (chunk > COMMAND_UNIFORM_MAX_FLOATS)
+			chunk = (uint32_t) COMMAND_UNIFORM_MAX_FLOATS;
+
+		CommandUniform uniform;
+		uniform.id = id;
+		uniform.offset = offset;
+		uniform.count = chunk;
+		uint8_t *payload = (uint8_t *) append(buffer, COMMAND_UNIFORM, sizeof(uniform) + sizeof(float) * chunk);
+		memcpy(payload, &uniform, sizeof(uniform));
+		memcpy(payload + sizeof(uniform), data + offset, sizeof(float) * chunk);
+		offset += chunk;
+	} while (offset < count);
+}
+
+CCALL void command_buffer_draw(CommandBuffer *buffer, const CommandDraw *draw) {
+	appendPayload(buffer, COMMAND_DRAW, *draw);
+	buffer->numDraws++;
+}
+
+CCALL void command_buffer_replay(const CommandBuffer *buffer, const CommandBackend *backend) {
+	const uint8_t *at = buffer->data.data();
+	const uint8_t *end = at + buffer->data.size();
+	while (at < end) {
+		CommandHeader header;
+		memcpy(&header, at, sizeof(header));
+		at += sizeof(header);
+
+		CommandFunc func = backend->commands[header.type];
+		if (func)
+			func(backend->userData, at, header.size);
+		at += header.size;
+	}
+}
+
+CCALL CommandRecorder *command_recorder_create(const CommandUniformIds *uniforms) {
+	CommandRecorder *recorder = new CommandRecorder();
+	recorder->uniforms = *uniforms;
+	recorder->numLayers = 0;
+	memset(&recorder->stats, 0, sizeof(recorder->stats));
+	return recorder;
+}
+
+CCALL void command_recorder_destroy(CommandRecorder *recorder) {
+	for (size_t i = 0; i < recorder->buffers.size(); i++)
+		command_buffer_destroy(recorder->buffers[i]);
+	delete recorder;
+}
+
+// the renderForward loop for one layer
+static void recordLayer(const CommandUniformIds &uniforms, const CommandLayer &layer, CommandBuffer *buffer) {
+	command_buffer_reset(buffer);
+	command_buffer_set_viewport(buffer, layer.viewport.x, layer.viewport.y, layer.viewport.width, layer.viewport.height);
+	command_buffer_uniform(buffer, uniforms.viewProjection, layer.viewProjection, 16);
+
+	const CommandMaterialState *prevMaterial = nullptr;
+	for (int i = 0; i < layer.numItems; i++) {
+		const CommandDrawItem &item = layer.items[i];
+		const CommandMaterialState *material = item.material;
+
+		if (material != prevMaterial) {
+			command_buffer_set_shader(buffer, material->shader);
+			for (int u = 0; u < material->numUniforms; u++)
+				command_buffer_uniform(buffer, material->uniformIds[u], material->uniformData[u], material->uniformCounts[u]);
+			command_buffer_set_blend(buffer, &material->blend);
+			command_buffer_set_depth(buffer, material->depth.test, material->depth.write);
+			command_buffer_set_cull(buffer, material->cull);
+			prevMaterial = material;
+		}
+
+		command_buffer_set_vertex_buffer(buffer, item.vertexBuffer, 0, 0);
+		if (item.primitive.indexed)
+			command_buffer_set_index_buffer(buffer, item.indexBuffer);
+
+		if (item.primitive.numInstances > 1)
+			command_buffer_set_vertex_buffer(buffer, item.instanceBuffer, 1, item.instanceOffset);
+		else
+			command_buffer_uniform(buffer, uniforms.model, item.modelMatrix, 16);
+
+		command_buffer_draw(buffer, &item.primitive);
+	}
+}
+
+struct RecordJob {
+	CommandRecorder *recorder;
+	const CommandLayer *layers;
+};
+
+static void recordLayers(void *userData, int begin, int end) {
+	RecordJob *job = (RecordJob *) userData;
+	for (int l = begin; l < end; l++)
+		recordLayer(job->recorder->uniforms, job->layers[l], job->recorder->buffers[l]);
+}
+
+CCALL int command_recorder_record(CommandRecorder *recorder, const CommandLayer *layers, int numLayers) {
+	while ((int) recorder->buffers.size() < numLayers)
+		recorder->buffers.push_back(command_buffer_create());
+	recorder->numLayers = numLayers;
+
+	RecordJob job;
+	job.recorder = recorder;
+	job.layers = layers;
+	pc::parallel_for(numLayers, COMMAND_RECORDER_GRAIN, recordLayers, &job);
+
+	CommandRecorderStats &stats = recorder->stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.layers = numLayers;
+	for (int l = 0; l < numLayers; l++) {
+		const CommandBuffer *buffer = recorder->buffers[l];
+		stats.commands += buffer->numCommands;
+		stats.draws += buffer->numDraws;
+		stats.bytes += (int) buffer->data.size();
+		stats.skipped += buffer->skipped;
+	}
+	return stats.commands;
+}
+
+CCALL CommandBuffer *command_recorder_get_buffer(CommandRecorder *recorder, int layer) {
+	return recorder->buffers[layer];
+}
+
+CCALL void command_recorder_replay(CommandRecorder *recorder, const CommandBackend *backend) {
+	for (int l = 0; l < recorder->numLayers; l++)
+		command_buffer_replay(recorder->buffers[l], backend);
+}
+
+CCALL CommandRecorderStats *command_recorder_get_stats(CommandRecorder *recorder) {
+	return &recorder->stats;
+}
+
+// null backend
+
+static void nullCommand(CommandNullStats *stats, uint16_t type, const void *payload, int size) {
+	stats->commands[type]++;
+
+	// FNV-1a
+	uint64_t hash = stats->hash;
+	hash = (hash ^ type) * 1099511628211ull;
+	const uint8_t *bytes = (const uint8_t *) payload;
+	for (int i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	stats->hash = hash;
+}
+
+template <int Type>
+static void nullFunc(void *userData, const void *payload, int size) {
+	nullCommand((CommandNullStats *) userData, Type, payload, size);
+}
+
+static void nullUniform(void *userData, const void *payload, int size) {
+	CommandNullStats *stats = (CommandNullStats *) userData;
+	CommandUniform uniform;
+	memcpy(&uniform, payload, sizeof(uniform));
+	stats->uniformFloats += uniform.count;
+	nullCommand(stats, COMMAND_UNIFORM, payload, size);
+}
+
+static void nullDraw(void *userData, const void *payload, int size) {
+	CommandNullStats *stats = (CommandNullStats *) userData;
+	CommandDraw draw;
+	memcpy(&draw, payload, sizeof(draw));
+	stats->instances += draw.numInstances > 1 ? draw.numInstances : 1;
+	nullCommand(stats, COMMAND_DRAW, payload, size);
+}
+
+CCALL void command_null_backend_init(CommandBackend *backend, CommandNullStats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	stats->hash = 14695981039346656037ull;
+
+	backend->commands[COMMAND_SET_SHADER] = nullFunc<COMMAND_SET_SHADER>;
+	backend->commands[COMMAND_SET_BLEND] = nullFunc<COMMAND_SET_BLEND>;
+	backend->commands[COMMAND_SET_DEPTH] = nullFunc<COMMAND_SET_DEPTH>;
+	backend->commands[COMMAND_SET_CULL] = nullFunc<COMMAND_SET_CULL>;
+	backend->commands[COMMAND_SET_VIEWPORT] = nullFunc<COMMAND_SET_VIEWPORT>;
+	backend->commands[COMMAND_SET_VERTEX_BUFFER] = nullFunc<COMMAND_SET_VERTEX_BUFFER>;
+	backend->commands[COMMAND_SET_INDEX_BUFFER] = nullFunc<COMMAND_SET_INDEX_BUFFER>;
+	backend->commands[COMMAND_UNIFORM] = nullUniform;
+	backend->commands[COMMAND_DRAW] = nullDraw;
+	backend->userData = stats;
+}
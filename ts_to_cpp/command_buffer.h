@@ -0,0 +1,211 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Recorded render commands, replayed later through a backend.
+ *
+ * pc.ForwardRenderer#renderForward sets state, uploads uniforms and draws through the graphics
+ * device one draw call at a time, on one thread. Here the same work is split in two steps. First,
+ * every layer of a composition is recorded into its own CommandBuffer, the layers in parallel on
+ * the threads of the pool. Second, the buffers are replayed in layer order on the device thread.
+ *
+ * A buffer is a compact binary stream: a 4 byte header per command (type and payload size)
+ * followed by its payload, every command 4 byte aligned. Recording skips state that matches the
+ * state already recorded in the same buffer, like pc.GraphicsDevice does for its setters. Every
+ * buffer starts from unknown state, because layers are recorded independently.
+ *
+ * Shaders, buffers and uniforms are opaque 32 bit ids chosen by the caller. A CommandBackend maps
+ * them to real device calls. The null backend only counts the commands and hashes the stream, so
+ * recording can be tested and benchmarked without a GPU.
+ */
+
+enum CommandType {
+	COMMAND_SET_SHADER,
+	COMMAND_SET_BLEND,
+	COMMAND_SET_DEPTH,
+	COMMAND_SET_CULL,
+	COMMAND_SET_VIEWPORT,
+	COMMAND_SET_VERTEX_BUFFER,
+	COMMAND_SET_INDEX_BUFFER,
+	COMMAND_UNIFORM,
+	COMMAND_DRAW,
+	COMMAND_TYPES
+};
+
+struct CommandHeader {
+	uint16_t type;
+	uint16_t size;  // payload bytes
+};
+
+// largest payload a header can describe, 4 byte aligned
+#define COMMAND_MAX_PAYLOAD 65532
+
+struct CommandBlend {
+	uint32_t enabled;
+	uint32_t src, dst, equation;  // pc.BLENDMODE_*, pc.BLENDEQUATION_*
+};
+
+struct CommandDepth {
+	uint32_t test;
+	uint32_t write;
+};
+
+struct CommandViewport {
+	float x, y, width, height;
+};
+
+struct CommandVertexBuffer {
+	uint32_t buffer;
+	uint32_t stream;
+	uint32_t offset;  // bytes
+};
+
+// followed by count floats, which go to the uniform starting at float offset
+struct CommandUniform {
+	uint32_t id;
+	uint32_t offset;
+	uint32_t count;
+};
+
+#define COMMAND_UNIFORM_MAX_FLOATS ((COMMAND_MAX_PAYLOAD - sizeof(CommandUniform)) / sizeof(float))
+
+struct CommandDraw {
+	uint32_t type;  // pc.PRIMITIVE_*
+	uint32_t base;
+	uint32_t count;
+	uint32_t indexed;
+	uint32_t numInstances;
+};
+
+struct CommandBuffer {
+	std::vector<uint8_t> data;
+	int numCommands;
+	int numDraws;
+	int skipped;  // state changes dropped because the state was already set
+
+	// state recorded so far, valid when the matching bit of known is set
+	uint32_t known;
+	uint32_t shader;
+	CommandBlend blend;
+	CommandDepth depth;
+	uint32_t cull;
+	CommandViewport viewport;
+	CommandVertexBuffer vertexBuffer[2];
+	uint32_t indexBuffer;
+};
+
+CCALL CommandBuffer *command_buffer_create();
+CCALL void command_buffer_destroy(CommandBuffer *buffer);
+// Empties the buffer and forgets the recorded state, keeping the memory.
+CCALL void command_buffer_reset(CommandBuffer *buffer);
+
+CCALL void command_buffer_set_shader(CommandBuffer *buffer, uint32_t shader);
+CCALL void command_buffer_set_blend(CommandBuffer *buffer, const CommandBlend *blend);
+CCALL void command_buffer_set_depth(CommandBuffer *buffer, uint32_t test, uint32_t write);
+CCALL void command_buffer_set_cull(CommandBuffer *buffer, uint32_t cull);
+CCALL void command_buffer_set_viewport(CommandBuffer *buffer, float x, float y, float width, float height);
+// Stream 0 for vertices, 1 for instances, other streams are not recorded. As with
+// pc.GraphicsDevice, a stream stays bound until it is set again: draws that are not instanced leave
+// stream 1 as the last instanced draw set it, and backends only read it for instanced draws.
+CCALL void command_buffer_set_vertex_buffer(CommandBuffer *buffer, uint32_t vertexBuffer, uint32_t stream, uint32_t offset);
+CCALL void command_buffer_set_index_buffer(CommandBuffer *buffer, uint32_t indexBuffer);
+// Copies count floats into the stream, always recorded. Uploads larger than
+// COMMAND_UNIFORM_MAX_FLOATS are split into several commands with increasing offsets.
+CCALL void command_buffer_uniform(CommandBuffer *buffer, uint32_t id, const float *data, uint32_t count);
+CCALL void command_buffer_draw(CommandBuffer *buffer, const CommandDraw *draw);
+
+/**
+ * Backend, one function per command type. Payload points into the stream and is only valid during
+ * the call, size is its length in bytes. A null function skips its commands.
+ */
+typedef void (*CommandFunc)(void *userData, const void *payload, int size);
+
+struct CommandBackend {
+	CommandFunc commands[COMMAND_TYPES];
+	void *userData;
+};
+
+// Replays the commands of buffer, in order.
+CCALL void command_buffer_replay(const CommandBuffer *buffer, const CommandBackend *backend);
+
+/**
+ * Layer recording. A draw item is one mesh instance as renderForward sees it: the material state,
+ * the mesh buffers and primitive, and its model matrix. A layer is its sorted draw items and the
+ * camera it is drawn with. Skinning is not recorded: draw items carry no bone data, so skinned
+ * mesh instances can not be drawn from a recorded layer.
+ */
+struct CommandMaterialState {
+	uint32_t shader;
+	CommandBlend blend;
+	CommandDepth depth;
+	uint32_t cull;
+	// material uniforms, uploaded when the material changes
+	const uint32_t *uniformIds;
+	const float *const *uniformData;
+	const uint32_t *uniformCounts;
+	int numUniforms;
+};
+
+struct CommandDrawItem {
+	const CommandMaterialState *material;
+	uint32_t vertexBuffer;
+	uint32_t indexBuffer;
+	CommandDraw primitive;
+	const float *modelMatrix;  // 16 floats, ignored for instanced draws
+	uint32_t instanceBuffer;   // stream 1 when primitive.numInstances > 1
+	uint32_t instanceOffset;
+};
+
+struct CommandLayer {
+	const CommandDrawItem *items;
+	int numItems;
+	CommandViewport viewport;
+	const float *viewProjection;  // 16 floats
+};
+
+struct CommandUniformIds {
+	uint32_t viewProjection;  // matrix_viewProjection
+	uint32_t model;           // matrix_model
+};
+
+struct CommandRecorderStats {
+	int layers;
+	int commands;
+	int draws;
+	int bytes;
+	int skipped;
+};
+
+struct CommandRecorder {
+	CommandUniformIds uniforms;
+	std::vector<CommandBuffer *> buffers;  // one per layer, reused
+	int numLayers;
+	CommandRecorderStats stats;
+};
+
+CCALL CommandRecorder *command_recorder_create(const CommandUniformIds *uniforms);
+CCALL void command_recorder_destroy(CommandRecorder *recorder);
+// Records every layer into its own buffer, layers in parallel. Returns the number of commands.
+CCALL int command_recorder_record(CommandRecorder *recorder, const CommandLayer *layers, int numLayers);
+CCALL CommandBuffer *command_recorder_get_buffer(CommandRecorder *recorder, int layer);
+// Replays the buffers of the last record in layer order, on the calling thread.
+CCALL void command_recorder_replay(CommandRecorder *recorder, const CommandBackend *backend);
+CCALL CommandRecorderStats *command_recorder_get_stats(CommandRecorder *recorder);
+
+struct CommandNullStats {
+	int commands[COMMAND_TYPES];
+	int instances;        // drawn by all draws
+	int uniformFloats;
+	uint64_t hash;        // FNV-1a of the type and payload of every replayed command
+};
+
+// Backend that records nothing but counts, for tests and benchmarks. stats must outlive the
+// backend's use and is reset by command_null_backend_init.
+CCALL void command_null_backend_init(CommandBackend *backend, CommandNullStats *stats);
+
+#endif
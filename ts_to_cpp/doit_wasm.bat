@@ -1,2 +1,2 @@
-cmd /c "emcc standalone.c -o pc_wasm.js -s WASM=1 -s TOTAL_MEMORY=33554432 -O2"
+cmd /c "emcc standalone.c frustum_culler.cpp thread_pool.cpp occlusion_culler.cpp ray_batch.cpp transform_store.cpp anim_sampler.cpp anim_crowd.cpp anim_blend.cpp anim_compressed.cpp skin_palette.cpp skin_vertices.cpp morph_accumulator.cpp radix_sort.cpp light_clusters.cpp shadow_casters.cpp dynamic_batcher.cpp static_mesh_split.cpp auto_instancing.cpp command_buffer.cpp -o pc_wasm.js -s WASM=1 -s TOTAL_MEMORY=33554432 -s USE_PTHREADS=1 -msimd128 -O2"
 pause
\ No newline at end of file
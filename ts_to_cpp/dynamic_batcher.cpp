@@ -0,0 +1,346 @@
+#include "dynamic_batcher.h"
+#include "native_math.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+using namespace pc::simd;
+
+static inline void boundsReset(float *bounds) {
+	bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+	bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+}
+
+static inline void storeVec3(float *v, float4 a) {
+	float tmp[4];
+	store(tmp, a);
+	v[0] = tmp[0];
+	v[1] = tmp[1];
+	v[2] = tmp[2];
+}
+
+static inline float4 normalize3(float4 v) {
+	float tmp[4];
+	store(tmp, v * v);
+	float length = tmp[0] + tmp[1] + tmp[2];
+	return length > 0.0f ? v * set1(1.0f / sqrtf(length)) : v;
+}
+
+CCALL DynamicBatcher *dynamic_batcher_create(TransformStore *store) {
+	DynamicBatcher *batcher = new DynamicBatcher();
+	batcher->store = store;
+	memset(&batcher->stats, 0, sizeof(batcher->stats));
+	return batcher;
+}
+
+CCALL void dynamic_batcher_destroy(DynamicBatcher *batcher) {
+	delete batcher;
+}
+
+static bool sameFormat(const DynamicBatchFormat &a, const DynamicBatchFormat &b) {
+	return a.vertexSize == b.vertexSize && a.offsetPosition == b.offsetPosition &&
+		a.offsetNormal == b.offsetNormal && a.offsetTangent == b.offsetTangent;
+}
+
+// a batch of the key and format with room for numVertices more, a reused empty one or a new one
+static int findBatch(DynamicBatcher *batcher, uint64_t key, const DynamicBatchFormat &format, int numVertices) {
+	int empty = -1;
+	for (int b = 0; b < (int) batcher->batches.size(); b++) {
+		DynamicBatch &batch = batcher->batches[b];
+		if (batch.instances.empty() && !batch.layoutDirty) {
+			if (empty < 0)
+				empty = b;
+			continue;
+		}
+		if (batch.key == key && sameFormat(batch.format, format) && batch.numVertices + numVertices <= DYNAMIC_BATCH_MAX_VERTICES)
+			return b;
+	}
+
+	if (empty < 0) {
+		empty = (int) batcher->batches.size();
+		batcher->batches.push_back(DynamicBatch());
+	}
+
+	DynamicBatch &batch = batcher->batches[empty];
+	batch.key = key;
+	batch.format = format;
+	batch.instances.clear();
+	batch.vertices.clear();
+	batch.indices.clear();
+	batch.numVertices = 0;
+	batch.layoutDirty = false;
+	batch.indicesDirty = true;
+	batch.dirtyFirst = 0;
+	batch.dirtyEnd = 0;
+	boundsReset(batch.aabb);
+	return empty;
+}
+
+static void appendIndices(DynamicBatch &batch, const DynamicBatchInstance &instance) {
+	for (int i = 0; i < instance.numIndices; i++)
+		batch.indices.push_back((uint16_t) (instance.indices[i] + instance.firstVertex));
+	batch.indicesDirty = true;
+}
+
+CCALL int dynamic_batcher_add(DynamicBatcher *batcher, uint64_t key, const DynamicBatchFormat *format, int transformHandle, const float *vertices, int numVertices, const uint16_t *indices, int numIndices) {
+	if (numVertices > DYNAMIC_BATCH_MAX_VERTICES)
+		return -1;
+
+	int id;
+	if (!batcher->freeInstances.empty()) {
+		id = batcher->freeInstances.back();
+		batcher->freeInstances.pop_back();
+	} else {
+		id = (int) batcher->instances.size();
+		batcher->instances.push_back(DynamicBatchInstance());
+	}
+
+	int b = findBatch(batcher, key, *format, numVertices);
+	DynamicBatch &batch = batcher->batches[b];
+
+	DynamicBatchInstance &instance = batcher->instances[id];
+	instance.key = key;
+	instance.format = *format;
+	instance.transformHandle = transformHandle;
+	instance.vertices = vertices;
+	instance.numVertices = numVertices;
+	instance.indices = indices;
+	instance.numIndices = numIndices;
+	instance.batch = b;
+	instance.firstVertex = batch.numVertices;
+	instance.dirty = true;
+	instance.moved = false;
+	boundsReset(instance.aabb);
+
+	batch.instances.push_back(id);
+	batch.numVertices += numVertices;
+	batch.vertices.resize(batch.numVertices * format->vertexSize);
+	appendIndices(batch, instance);
+	return id;
+}
+
+CCALL void dynamic_batcher_remove(DynamicBatcher *batcher, int id) {
+	DynamicBatchInstance &instance = batcher->instances[id];
+	if (instance.batch < 0)
+		return;
+
+	DynamicBatch &batch = batcher->batches[instance.batch];
+	batch.instances.erase(std::find(batch.instances.begin(), batch.instances.end(), id));
+	batch.layoutDirty = true;
+
+	instance.batch = -1;
+	instance.vertices = nullptr;
+	instance.indices = nullptr;
+	batcher->freeInstances.push_back(id);
+}
+
+CCALL void dynamic_batcher_invalidate(DynamicBatcher *batcher, int id) {
+	batcher->instances[id].dirty = true;
+}
+
+CCALL int dynamic_batcher_get_batch_of(DynamicBatcher *batcher, int id) {
+	return batcher->instances[id].batch;
+}
+
+static inline void extendDirty(DynamicBatch &batch, int first, int end) {
+	if (batch.dirtyFirst >= batch.dirtyEnd) {
+		batch.dirtyFirst = first;
+		batch.dirtyEnd = end;
+	} else {
+		batch.dirtyFirst = first < batch.dirtyFirst ? first : batch.dirtyFirst;
+		batch.dirtyEnd = end > batch.dirtyEnd ? end : batch.dirtyEnd;
+	}
+}
+
+static void updateBounds(const DynamicBatcher *batcher, DynamicBatch &batch) {
+	boundsReset(batch.aabb);
+	for (int i = 0; i < (int) batch.instances.size(); i++) {
+		const float *aabb = batcher->instances[batch.instances[i]].aabb;
+		for (int k = 0; k < 3; k++) {
+			batch.aabb[k] = aabb[k] < batch.aabb[k] ? aabb[k] : batch.aabb[k];
+			batch.aabb[k + 3] = aabb[k + 3] > batch.aabb[k + 3] ? aabb[k + 3] : batch.aabb[k + 3];
+		}
+	}
+}
+
+// Moves the instances left in a batch to the front, keeping their transformed vertices, and
+// rebuilds the indices.
+static void repack(DynamicBatcher *batcher, DynamicBatch &batch) {
+	int vertexSize = batch.format.vertexSize;
+	int next = 0;
+	int firstMoved = -1;
+
+	batch.indices.clear();
+	for (int i = 0; i < (int) batch.instances.size(); i++) {
+		DynamicBatchInstance &instance = batcher->instances[batch.instances[i]];
+		if (instance.firstVertex != next) {
+			// instances keep their order, so data only moves towards the front
+			memmove(&batch.vertices[next * vertexSize], &batch.vertices[instance.firstVertex * vertexSize], sizeof(float) * instance.numVertices * vertexSize);
+			instance.firstVertex = next;
+			if (firstMoved < 0)
+				firstMoved = next;
+		}
+		next += instance.numVertices;
+		appendIndices(batch, instance);
+	}
+
+	batch.numVertices = next;
+	batch.vertices.resize(next * vertexSize);
+	if (firstMoved >= 0)
+		extendDirty(batch, firstMoved, next);
+	if (batch.dirtyEnd > next)
+		batch.dirtyEnd = next;
+	batch.indicesDirty = true;
+	batch.layoutDirty = false;
+
+	updateBounds(batcher, batch);
+}
+
+static void transformInstance(const float *world, DynamicBatchInstance &instance, float *out) {
+	const DynamicBatchFormat &format = instance.format;
+	int vertexSize = format.vertexSize;
+
+	float4 c0 = load(world), c1 = load(world + 4), c2 = load(world + 8), c3 = load(world + 12);
+
+	// normals go through the inverse transpose, which keeps them perpendicular under non uniform scale
+	float inverse[16];
+	pc::native::mat4Invert(inverse, world);
+	float4 n0 = set(inverse[0], inverse[4], inverse[8], 0.0f);
+	float4 n1 = set(inverse[1], inverse[5], inverse[9], 0.0f);
+	float4 n2 = set(inverse[2], inverse[6], inverse[10], 0.0f);
+
+	float4 lo = set1(FLT_MAX), hi = set1(-FLT_MAX);
+	const float *src = instance.vertices;
+	for (int v = 0; v < instance.numVertices; v++, src += vertexSize, out += vertexSize) {
+		memcpy(out, src, sizeof(float) * vertexSize);
+
+		const float *p = src + format.offsetPosition;
+		float4 position = c0 * set1(p[0]) + c1 * set1(p[1]) + c2 * set1(p[2]) + c3;
+		storeVec3(out + format.offsetPosition, position);
+		lo = min(lo, position);
+		hi = max(hi, position);
+
+		if (format.offsetNormal >= 0) {
+			const float *n = src + format.offsetNormal;
+			storeVec3(out + format.offsetNormal, normalize3(n0 * set1(n[0]) + n1 * set1(n[1]) + n2 * set1(n[2])));
+		}
+		if (format.offsetTangent >= 0) {
+			// w, the bitangent sign, is copied with the rest of the vertex
+			const float *t = src + format.offsetTangent;
+			storeVec3(out + format.offsetTangent, normalize3(c0 * set1(t[0]) + c1 * set1(t[1]) + c2 * set1(t[2])));
+		}
+	}
+
+	float tmp[4];
+	store(tmp, lo);
+	instance.aabb[0] = tmp[0];
+	instance.aabb[1] = tmp[1];
+	instance.aabb[2] = tmp[2];
+	store(tmp, hi);
+	instance.aabb[3] = tmp[0];
+	instance.aabb[4] = tmp[1];
+	instance.aabb[5] = tmp[2];
+}
+
+static void transformInstances(void *userData, int begin, int end) {
+	DynamicBatcher *batcher = (DynamicBatcher *) userData;
+	const TransformStore *store = batcher->store;
+	const float *world = &store->worldTransform[0];
+	const int32_t *handleSlot = &store->handleSlot[0];
+
+	for (int i = begin; i < end; i++) {
+		DynamicBatchInstance &instance = batcher->instances[batcher->work[i]];
+		DynamicBatch &batch = batcher->batches[instance.batch];
+		float *out = &batch.vertices[instance.firstVertex * instance.format.vertexSize];
+		transformInstance(world + handleSlot[instance.transformHandle] * 16, instance, out);
+	}
+}
+
+CCALL void dynamic_batcher_update(DynamicBatcher *batcher) {
+	DynamicBatcherStats &stats = batcher->stats;
+	stats.batchesRepacked = 0;
+
+	for (int b = 0; b < (int) batcher->batches.size(); b++) {
+		if (batcher->batches[b].layoutDirty) {
+			repack(batcher, batcher->batches[b]);
+			stats.batchesRepacked++;
+		}
+	}
+
+	// changed is 2 for the slots transform_store_update wrote this sweep
+	const TransformStore *store = batcher->store;
+	const int32_t *handleSlot = store->handleSlot.empty() ? nullptr : &store->handleSlot[0];
+	const uint8_t *changed = store->changed.empty() ? nullptr : &store->changed[0];
+
+	batcher->work.clear();
+	int instances = 0;
+	for (int i = 0; i < (int) batcher->instances.size(); i++) {
+		DynamicBatchInstance &instance = batcher->instances[i];
+		instance.moved = false;
+		if (instance.batch < 0)
+			continue;
+		instances++;
+		if (instance.dirty || (changed && changed[handleSlot[instance.transformHandle]] == 2)) {
+			instance.moved = true;
+			batcher->work.push_back(i);
+		}
+	}
+
+	int count = (int) batcher->work.size();
+	pc::parallel_for(count, DYNAMIC_BATCHER_GRAIN, transformInstances, batcher);
+
+	int vertices = 0;
+	for (int i = 0; i < count; i++) {
+		DynamicBatchInstance &instance = batcher->instances[batcher->work[i]];
+		DynamicBatch &batch = batcher->batches[instance.batch];
+		instance.dirty = false;
+		vertices += instance.numVertices;
+		extendDirty(batch, instance.firstVertex, instance.firstVertex + instance.numVertices);
+	}
+	int batches = 0, dirtyVertices = 0;
+	for (int b = 0; b < (int) batcher->batches.size(); b++) {
+		DynamicBatch &batch = batcher->batches[b];
+		if (batch.instances.empty())
+			continue;
+		batches++;
+		if (batch.dirtyEnd > batch.dirtyFirst)
+			dirtyVertices += batch.dirtyEnd - batch.dirtyFirst;
+
+		// the bounds of a batch change with the bounds of the instances that moved
+		bool anyMoved = false;
+		for (int i = 0; i < (int) batch.instances.size() && !anyMoved; i++)
+			anyMoved = batcher->instances[batch.instances[i]].moved;
+		if (anyMoved)
+			updateBounds(batcher, batch);
+	}
+
+	stats.batches = batches;
+	stats.instances = instances;
+	stats.instancesTransformed = count;
+	stats.verticesTransformed = vertices;
+	stats.dirtyVertices = dirtyVertices;
+}
+
+CCALL void dynamic_batcher_clear_dirty(DynamicBatcher *batcher) {
+	for (int b = 0; b < (int) batcher->batches.size(); b++) {
+		DynamicBatch &batch = batcher->batches[b];
+		batch.dirtyFirst = batch.dirtyEnd = 0;
+		batch.indicesDirty = false;
+	}
+}
+
+CCALL int dynamic_batcher_get_num_batches(DynamicBatcher *batcher) {
+	return (int) batcher->batches.size();
+}
+
+CCALL DynamicBatch *dynamic_batcher_get_batch(DynamicBatcher *batcher, int batch) {
+	return &batcher->batches[batch];
+}
+
+CCALL DynamicBatcherStats *dynamic_batcher_get_stats(DynamicBatcher *batcher) {
+	return &batcher->stats;
+}
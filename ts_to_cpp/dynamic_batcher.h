@@ -0,0 +1,120 @@
+#ifndef DYNAMIC_BATCHER_H
+#define DYNAMIC_BATCHER_H
+
+#include "include_ccall.h"
+#include "transform_store.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Dynamic batching of small moving mesh instances.
+ *
+ * Instances that share a batch key (their material and shader, as for pc.SORTKEY_FORWARD) and a
+ * vertex format are packed into batches: one vertex array with the vertices of every instance in
+ * world space, and one index array, drawn with a single draw call. prepareStaticMeshes does the
+ * same for static geometry once at load; these batches follow the node of every instance through
+ * a TransformStore.
+ *
+ * dynamic_batcher_update, called after transform_store_update, only transforms the vertices of
+ * instances whose node moved this sweep or that were just added, split between the threads of the
+ * pool. Positions go through the world matrix, normals through its inverse transpose and tangents
+ * through its upper 3x3, both renormalized, with float4 math. Every other vertex attribute is
+ * copied as is.
+ *
+ * Adding an instance appends it to a batch of its key with room left. Removing one only repacks
+ * the batch it was in, on the next update. Every batch tracks the range of vertices written since
+ * dynamic_batcher_clear_dirty and whether its indices changed, so that only that part of its
+ * vertex buffer needs to be uploaded.
+ */
+
+// 16 bit indices
+#define DYNAMIC_BATCH_MAX_VERTICES 65535
+
+// instances per job
+#define DYNAMIC_BATCHER_GRAIN 16
+
+// Vertex layout, in floats. Normal and tangent offsets are -1 when the format has none.
+struct DynamicBatchFormat {
+	int vertexSize;
+	int offsetPosition;
+	int offsetNormal;
+	int offsetTangent;
+};
+
+struct DynamicBatchInstance {
+	uint64_t key;
+	DynamicBatchFormat format;
+	int transformHandle;
+	// source mesh in local space, not copied
+	const float *vertices;
+	int numVertices;
+	const uint16_t *indices;
+	int numIndices;
+
+	int batch;       // -1 when the slot is free
+	int firstVertex; // within the batch
+	bool dirty;      // needs transforming even if the node did not move
+	bool moved;      // transformed by the update in progress
+	float aabb[6];   // world space min xyz, max xyz
+};
+
+struct DynamicBatch {
+	uint64_t key;
+	DynamicBatchFormat format;
+	std::vector<int> instances;
+	std::vector<float> vertices;   // vertexSize floats per vertex
+	std::vector<uint16_t> indices;
+	int numVertices;
+
+	bool layoutDirty;   // an instance left, repack on the next update
+	bool indicesDirty;  // indices changed since dynamic_batcher_clear_dirty
+	int dirtyFirst;     // vertices written since dynamic_batcher_clear_dirty, [dirtyFirst, dirtyEnd)
+	int dirtyEnd;
+	float aabb[6];      // world space bounds of the batch
+};
+
+struct DynamicBatcherStats {
+	int batches;               // batches with at least one instance
+	int instances;
+	int instancesTransformed;  // by the last update
+	int verticesTransformed;
+	int batchesRepacked;
+	int dirtyVertices;         // vertices to upload after the last update
+};
+
+struct DynamicBatcher {
+	TransformStore *store;
+	std::vector<DynamicBatchInstance> instances;
+	std::vector<int> freeInstances;
+	std::vector<DynamicBatch> batches;
+	// instances to transform by the update in progress
+	std::vector<int> work;
+	DynamicBatcherStats stats;
+};
+
+CCALL DynamicBatcher *dynamic_batcher_create(TransformStore *store);
+CCALL void dynamic_batcher_destroy(DynamicBatcher *batcher);
+
+// Adds an instance and returns its id, or -1 when the mesh has more than
+// DYNAMIC_BATCH_MAX_VERTICES vertices. Vertices and indices are read at every update of the
+// instance and must stay valid until it is removed.
+CCALL int dynamic_batcher_add(DynamicBatcher *batcher, uint64_t key, const DynamicBatchFormat *format, int transformHandle, const float *vertices, int numVertices, const uint16_t *indices, int numIndices);
+CCALL void dynamic_batcher_remove(DynamicBatcher *batcher, int instance);
+// Transforms the instance on the next update even if its node did not move, e.g. after its source
+// vertices changed.
+CCALL void dynamic_batcher_invalidate(DynamicBatcher *batcher, int instance);
+CCALL int dynamic_batcher_get_batch_of(DynamicBatcher *batcher, int instance);
+
+// Repacks batches instances left and transforms moved and new instances.
+CCALL void dynamic_batcher_update(DynamicBatcher *batcher);
+// Resets the dirty vertex ranges and index flags, call it once the batches were uploaded.
+CCALL void dynamic_batcher_clear_dirty(DynamicBatcher *batcher);
+
+// Batches keep their index while they exist; empty batches (numVertices 0) are reused.
+CCALL int dynamic_batcher_get_num_batches(DynamicBatcher *batcher);
+CCALL DynamicBatch *dynamic_batcher_get_batch(DynamicBatcher *batcher, int batch);
+
+CCALL DynamicBatcherStats *dynamic_batcher_get_stats(DynamicBatcher *batcher);
+
+#endif
@@ -0,0 +1,114 @@
+#include "frustum_culler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+CCALL FrustumCuller *frustum_culler_create() {
+	FrustumCuller *culler = (FrustumCuller *) calloc(1, sizeof(FrustumCuller));
+	return culler;
+}
+
+CCALL void frustum_culler_destroy(FrustumCuller *culler) {
+	free(culler);
+}
+
+static void setPlane(float *plane, float a, float b, float c, float d) {
+	float t = sqrtf(a * a + b * b + c * c);
+	plane[0] = a / t;
+	plane[1] = b / t;
+	plane[2] = c / t;
+	plane[3] = d / t;
+}
+
+CCALL void frustum_culler_update(FrustumCuller *culler, const float *vpm) {
+	// RIGHT, LEFT, BOTTOM, TOP, FAR, NEAR - keep in sync with pc.Frustum#update
+	setPlane(culler->planes[0], vpm[3] - vpm[0], vpm[7] - vpm[4], vpm[11] - vpm[8], vpm[15] - vpm[12]);
+	setPlane(culler->planes[1], vpm[3] + vpm[0], vpm[7] + vpm[4], vpm[11] + vpm[8], vpm[15] + vpm[12]);
+	setPlane(culler->planes[2], vpm[3] + vpm[1], vpm[7] + vpm[5], vpm[11] + vpm[9], vpm[15] + vpm[13]);
+	setPlane(culler->planes[3], vpm[3] - vpm[1], vpm[7] - vpm[5], vpm[11] - vpm[9], vpm[15] - vpm[13]);
+	setPlane(culler->planes[4], vpm[3] - vpm[2], vpm[7] - vpm[6], vpm[11] - vpm[10], vpm[15] - vpm[14]);
+	setPlane(culler->planes[5], vpm[3] + vpm[2], vpm[7] + vpm[6], vpm[11] + vpm[10], vpm[15] + vpm[14]);
+}
+
+CCALL void frustum_culler_set_planes(FrustumCuller *culler, const float *planes) {
+	memcpy(culler->planes, planes, sizeof(culler->planes));
+}
+
+static inline float planeDistance(const float *plane, float x, float y, float z) {
+	return plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+}
+
+CCALL int frustum_culler_contains_sphere(FrustumCuller *culler, float x, float y, float z, float radius, uint8_t *state, int planeMask, int *outMask) {
+	FrustumCullerStats &stats = culler->stats;
+	uint8_t s = *state;
+	int mask = 0;
+	float d;
+
+	stats.spheresTested++;
+
+	// try the plane that rejected this object last time first
+	if (s & FRUSTUM_CULLER_STATE_PLANE_VALID) {
+		int cached = s & FRUSTUM_CULLER_STATE_PLANE_MASK;
+		if (planeMask & (1 << cached)) {
+			stats.cacheProbes++;
+			stats.planeTests++;
+			d = planeDistance(culler->planes[cached], x, y, z);
+			if (d <= -radius) {
+				stats.cacheHits++;
+				stats.rejected++;
+				if (outMask) *outMask = 0;
+				return FRUSTUM_CULLER_OUTSIDE;
+			}
+			if (d <= radius)
+				mask |= 1 << cached;
+			planeMask &= ~(1 << cached);
+		}
+	}
+
+	for (int p = 0; p < 6; p++) {
+		if (!(planeMask & (1 << p)))
+			continue;
+		stats.planeTests++;
+		d = planeDistance(culler->planes[p], x, y, z);
+		if (d <= -radius) {
+			*state = (uint8_t) (FRUSTUM_CULLER_STATE_PLANE_VALID | p);
+			stats.rejected++;
+			if (outMask) *outMask = 0;
+			return FRUSTUM_CULLER_OUTSIDE;
+		}
+		if (d <= radius)
+			mask |= 1 << p;
+	}
+
+	// the cached plane is kept while the object is visible, it is still the best guess for the
+	// plane that will reject it once it leaves the frustum again
+	if (outMask) *outMask = mask;
+	return mask ? FRUSTUM_CULLER_INTERSECTS : FRUSTUM_CULLER_INSIDE;
+}
+
+CCALL int frustum_culler_cull_spheres(FrustumCuller *culler, const float *x, const float *y, const float *z, const float *radius, uint8_t *states, uint8_t *results, int count) {
+	int visible = 0;
+	for (int i = 0; i < count; i++) {
+		int result = frustum_culler_contains_sphere(culler, x[i], y[i], z[i], radius[i], &states[i], FRUSTUM_CULLER_ALL_PLANES, NULL);
+		results[i] = (uint8_t) result;
+		if (result != FRUSTUM_CULLER_OUTSIDE)
+			visible++;
+	}
+	return visible;
+}
+
+CCALL void frustum_culler_reset_stats(FrustumCuller *culler) {
+	memset(&culler->stats, 0, sizeof(culler->stats));
+}
+
+CCALL const FrustumCullerStats *frustum_culler_get_stats(FrustumCuller *culler) {
+	return &culler->stats;
+}
+
+CCALL float frustum_culler_get_hit_rate(FrustumCuller *culler) {
+	const FrustumCullerStats &stats = culler->stats;
+	if (stats.cacheProbes == 0)
+		return 0.0f;
+	return (float) stats.cacheHits / (float) stats.cacheProbes;
+}
@@ -0,0 +1,65 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+
+/**
+ * Native counterpart of pc.Frustum#containsSphere, meant for culling large sets of spheres.
+ *
+ * Every object owns one byte of culling state which survives between frames:
+ *
+ *   bits 0-2  index of the plane that rejected the object last time
+ *   bit  3    set when that plane index is valid
+ *
+ * The cached plane is tested first, so an object that stays outside the frustum usually costs a
+ * single plane test. The result is identical to testing the planes in order.
+ */
+
+#define FRUSTUM_CULLER_OUTSIDE 0
+#define FRUSTUM_CULLER_INTERSECTS 1
+#define FRUSTUM_CULLER_INSIDE 2
+
+#define FRUSTUM_CULLER_STATE_PLANE_MASK 0x07
+#define FRUSTUM_CULLER_STATE_PLANE_VALID 0x08
+
+#define FRUSTUM_CULLER_ALL_PLANES 0x3f
+
+struct FrustumCullerStats {
+	uint32_t spheresTested;
+	uint32_t planeTests;
+	uint32_t cacheProbes;    // tests that started with a cached rejecting plane
+	uint32_t cacheHits;      // ... and were rejected by that plane alone
+	uint32_t rejected;
+};
+
+struct FrustumCuller {
+	float planes[6][4];
+	FrustumCullerStats stats;
+};
+
+CCALL FrustumCuller *frustum_culler_create();
+CCALL void frustum_culler_destroy(FrustumCuller *culler);
+
+// Extracts and normalizes the six planes from a column-major view-projection matrix (pc.Mat4#data),
+// in the same order as pc.Frustum: right, left, bottom, top, far, near.
+CCALL void frustum_culler_update(FrustumCuller *culler, const float *viewProj);
+// Copies 24 floats laid out as pc.Frustum#planes, for callers that already have the planes.
+CCALL void frustum_culler_set_planes(FrustumCuller *culler, const float *planes);
+
+// Single sphere test. planeMask selects the planes to test; a hierarchical caller passes the
+// planes its parent intersected and receives the planes this sphere still intersects in *outMask.
+// Children of a parent that is fully inside get a planeMask of 0 and are not tested at all.
+CCALL int frustum_culler_contains_sphere(FrustumCuller *culler, float x, float y, float z, float radius, uint8_t *state, int planeMask, int *outMask);
+
+// Tests count spheres stored as SoA arrays, writing one result per sphere. Returns the number
+// of spheres that are not outside the frustum.
+CCALL int frustum_culler_cull_spheres(FrustumCuller *culler, const float *x, const float *y, const float *z, const float *radius, uint8_t *states, uint8_t *results, int count);
+
+CCALL void frustum_culler_reset_stats(FrustumCuller *culler);
+CCALL const FrustumCullerStats *frustum_culler_get_stats(FrustumCuller *culler);
+// Fraction of probes rejected by the cached plane alone, 0 when nothing was probed.
+CCALL float frustum_culler_get_hit_rate(FrustumCuller *culler);
+
+#endif
@@ -0,0 +1,354 @@
+#include "light_clusters.h"
+#include "native_math.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <math.h>
+#include <string.h>
+
+#define LIGHT_CLUSTERS_GRAIN 64
+
+using namespace pc::native;
+
+CCALL LightClusters *light_clusters_create(int tilesX, int tilesY, int slices) {
+	LightClusters *clusters = new LightClusters();
+	clusters->tilesX = tilesX;
+	clusters->tilesY = tilesY;
+	clusters->slices = slices;
+	clusters->numClusters = tilesX * tilesY * slices;
+	mat4SetIdentity(clusters->view);
+	mat4SetIdentity(clusters->projection);
+	clusters->nearClip = 0.1f;
+	clusters->farClip = 1000.0f;
+	clusters->sliceScale = 0.0f;
+	clusters->sliceDepths.resize(slices + 1);
+	clusters->clusterBounds.resize(clusters->numClusters * 6);
+	clusters->offsets.assign(clusters->numClusters + 1, 0);
+	memset(&clusters->stats, 0, sizeof(clusters->stats));
+	return clusters;
+}
+
+CCALL void light_clusters_destroy(LightClusters *clusters) {
+	delete clusters;
+}
+
+// view space point to normalized device coordinates
+static inline void projectPoint(const float *m, float x, float y, float z, float *ndc) {
+	float w = m[3] * x + m[7] * y + m[11] * z + m[15];
+	ndc[0] = (m[0] * x + m[4] * y + m[8] * z + m[12]) / w;
+	ndc[1] = (m[1] * x + m[5] * y + m[9] * z + m[13]) / w;
+}
+
+static inline void unprojectPoint(const float *inverse, float x, float y, float z, float *p) {
+	float w = inverse[3] * x + inverse[7] * y + inverse[11] * z + inverse[15];
+	p[0] = (inverse[0] * x + inverse[4] * y + inverse[8] * z + inverse[12]) / w;
+	p[1] = (inverse[1] * x + inverse[5] * y + inverse[9] * z + inverse[13]) / w;
+	p[2] = (inverse[2] * x + inverse[6] * y + inverse[10] * z + inverse[14]) / w;
+}
+
+static inline int clampInt(int v, int lo, int hi) {
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static inline int sliceOf(const LightClusters *clusters, float depth) {
+	if (depth <= clusters->nearClip)
+		return 0;
+	return clampInt((int) floorf(logf(depth / clusters->nearClip) * clusters->sliceScale), 0, clusters->slices - 1);
+}
+
+static inline int tileOf(float ndc, int tiles) {
+	return clampInt((int) floorf((ndc * 0.5f + 0.5f) * (float) tiles), 0, tiles - 1);
+}
+
+static inline bool sphereIntersectsBox(const float *sphere, const float *box) {
+	float d = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		float v = sphere[i];
+		if (v < box[i])
+			d += (box[i] - v) * (box[i] - v);
+		else if (v > box[i + 3])
+			d += (v - box[i + 3]) * (v - box[i + 3]);
+	}
+	return d <= sphere[3] * sphere[3];
+}
+
+// tiles covered by the view space box [x0, x1] x [y0, y1] between view depths z0 and z1
+static void tileRange(const LightClusters *clusters, float x0, float x1, float y0, float y1, float z0, float z1, int *range) {
+	float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+	for (int i = 0; i < 8; i++) {
+		float ndc[2];
+		projectPoint(clusters->projection, (i & 1) ? x1 : x0, (i & 2) ? y1 : y0, (i & 4) ? -z1 : -z0, ndc);
+		minX = ndc[0] < minX ? ndc[0] : minX;
+		maxX = ndc[0] > maxX ? ndc[0] : maxX;
+		minY = ndc[1] < minY ? ndc[1] : minY;
+		maxY = ndc[1] > maxY ? ndc[1] : maxY;
+	}
+	range[0] = tileOf(minX, clusters->tilesX);
+	range[1] = tileOf(maxX, clusters->tilesX);
+	range[2] = tileOf(minY, clusters->tilesY);
+	range[3] = tileOf(maxY, clusters->tilesY);
+	// entirely off screen
+	if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+		range[1] = range[0] - 1;
+}
+
+CCALL void light_clusters_set_camera(LightClusters *clusters, const float *view, const float *projection, float nearClip, float farClip) {
+	memcpy(clusters->view, view, sizeof(clusters->view));
+	memcpy(clusters->projection, projection, sizeof(clusters->projection));
+	clusters->nearClip = nearClip;
+	clusters->farClip = farClip;
+	clusters->sliceScale = (float) clusters->slices / logf(farClip / nearClip);
+
+	int slices = clusters->slices;
+	for (int s = 0; s <= slices; s++)
+		clusters->sliceDepths[s] = nearClip * powf(farClip / nearClip, (float) s / (float) slices);
+	clusters->sliceDepths[slices] = farClip;
+
+	float inverse[16];
+	mat4Invert(inverse, projection);
+
+	// view rays through the tile corners, as the points on the near and far clip planes
+	int tilesX = clusters->tilesX, tilesY = clusters->tilesY;
+	std::vector<float> rays((tilesX + 1) * (tilesY + 1) * 6);
+	for (int y = 0; y <= tilesY; y++) {
+		for (int x = 0; x <= tilesX; x++) {
+			float *ray = &rays[(y * (tilesX + 1) + x) * 6];
+			float ndcX = (float) x * 2.0f / (float) tilesX - 1.0f;
+			float ndcY = (float) y * 2.0f / (float) tilesY - 1.0f;
+			unprojectPoint(inverse, ndcX, ndcY, -1.0f, ray);
+			unprojectPoint(inverse, ndcX, ndcY, 1.0f, ray + 3);
+		}
+	}
+
+	for (int s = 0; s < slices; s++) {
+		for (int y = 0; y < tilesY; y++) {
+			for (int x = 0; x < tilesX; x++) {
+				float *bounds = &clusters->clusterBounds[((s * tilesY + y) * tilesX + x) * 6];
+				bounds[0] = bounds[1] = bounds[2] = 3.4e38f;
+				bounds[3] = bounds[4] = bounds[5] = -3.4e38f;
+
+				// the corners of the tile at both depths of the slice
+				for (int c = 0; c < 8; c++) {
+					const float *ray = &rays[((y + ((c >> 1) & 1)) * (tilesX + 1) + x + (c & 1)) * 6];
+					float depth = clusters->sliceDepths[s + ((c >> 2) & 1)];
+					float t = (-depth - ray[2]) / (ray[5] - ray[2]);
+					for (int i = 0; i < 3; i++) {
+						float v = ray[i] + t * (ray[i + 3] - ray[i]);
+						bounds[i] = v < bounds[i] ? v : bounds[i];
+						bounds[i + 3] = v > bounds[i + 3] ? v : bounds[i + 3];
+					}
+				}
+			}
+		}
+	}
+}
+
+CCALL void light_clusters_assign(LightClusters *clusters, const LightClusterLight *lights, int count) {
+	if (count > LIGHT_CLUSTERS_MAX_LIGHTS)
+		count = LIGHT_CLUSTERS_MAX_LIGHTS;
+
+	clusters->lights.assign(lights, lights + count);
+	clusters->viewSpheres.resize(count * 4);
+	clusters->pairLights.clear();
+	clusters->pairClusters.clear();
+
+	int tilesX = clusters->tilesX, tilesY = clusters->tilesY;
+	float nearClip = clusters->nearClip, farClip = clusters->farClip;
+	int visibleLights = 0;
+
+	for (int i = 0; i < count; i++) {
+		float *sphere = &clusters->viewSpheres[i * 4];
+		mat4TransformPoint(clusters->view, lights[i].sphere, sphere);
+		float radius = sphere[3] = lights[i].sphere[3];
+
+		float depth = -sphere[2];
+		if (depth + radius < nearClip || depth - radius > farClip)
+			continue;
+
+		float minDepth = depth - radius > nearClip ? depth - radius : nearClip;
+		float maxDepth = depth + radius < farClip ? depth + radius : farClip;
+		int firstSlice = sliceOf(clusters, minDepth);
+		int lastSlice = sliceOf(clusters, maxDepth);
+		bool visible = false;
+
+		for (int s = firstSlice; s <= lastSlice; s++) {
+			// the part of the sphere's box within the slice
+			float z0 = minDepth > clusters->sliceDepths[s] ? minDepth : clusters->sliceDepths[s];
+			float z1 = maxDepth < clusters->sliceDepths[s + 1] ? maxDepth : clusters->sliceDepths[s + 1];
+			int range[4];
+			tileRange(clusters, sphere[0] - radius, sphere[0] + radius, sphere[1] - radius, sphere[1] + radius, z0, z1, range);
+
+			for (int y = range[2]; y <= range[3]; y++) {
+				for (int x = range[0]; x <= range[1]; x++) {
+					int cluster = (s * tilesY + y) * tilesX + x;
+					if (!sphereIntersectsBox(sphere, &clusters->clusterBounds[cluster * 6]))
+						continue;
+					clusters->pairLights.push_back((uint16_t) i);
+					clusters->pairClusters.push_back((uint32_t) cluster);
+					visible = true;
+				}
+			}
+		}
+		if (visible)
+			visibleLights++;
+	}
+
+	// group the overlaps by cluster, lights stay in index order within a cluster
+	std::vector<uint32_t> &offsets = clusters->offsets;
+	int numClusters = clusters->numClusters;
+	int numPairs = (int) clusters->pairLights.size();
+	offsets.assign(numClusters + 1, 0);
+	for (int p = 0; p < numPairs; p++)
+		offsets[clusters->pairClusters[p] + 1]++;
+
+	int occupied = 0, longest = 0;
+	for (int c = 0; c < numClusters; c++) {
+		int n = offsets[c + 1];
+		occupied += n > 0;
+		longest = n > longest ? n : longest;
+		offsets[c + 1] += offsets[c];
+	}
+
+	clusters->indices.resize(numPairs);
+	std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+	for (int p = 0; p < numPairs; p++)
+		clusters->indices[cursor[clusters->pairClusters[p]]++] = clusters->pairLights[p];
+
+	LightClustersStats &stats = clusters->stats;
+	stats.lights = count;
+	stats.visibleLights = visibleLights;
+	stats.clusterLights = numPairs;
+	stats.occupiedClusters = occupied;
+	stats.maxClusterLights = longest;
+}
+
+CCALL const uint32_t *light_clusters_get_offsets(LightClusters *clusters) {
+	return clusters->offsets.data();
+}
+
+CCALL const uint16_t *light_clusters_get_indices(LightClusters *clusters) {
+	return clusters->indices.data();
+}
+
+CCALL int light_clusters_get_cluster(LightClusters *clusters, int tileX, int tileY, int slice) {
+	return (slice * clusters->tilesY + tileY) * clusters->tilesX + tileX;
+}
+
+struct InstanceLightsJob {
+	const LightClusters *clusters;
+	const float *aabbs;
+	const uint32_t *masks;
+	int maxLights;
+	uint16_t *lightIndices;
+	int *lightCounts;
+	std::atomic<int> dropped;
+};
+
+static inline bool sphereIntersectsAabb(const float *sphere, const float *aabb) {
+	float d = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		float v = fabsf(sphere[i] - aabb[i]) - aabb[i + 3];
+		if (v > 0.0f)
+			d += v * v;
+	}
+	return d <= sphere[3] * sphere[3];
+}
+
+static void findInstanceLights(void *userData, int begin, int end) {
+	InstanceLightsJob *job = (InstanceLightsJob *) userData;
+	const LightClusters *clusters = job->clusters;
+	const float *view = clusters->view;
+	int tilesX = clusters->tilesX, tilesY = clusters->tilesY;
+	float nearClip = clusters->nearClip, farClip = clusters->farClip;
+	int dropped = 0;
+
+	// lights seen in the clusters of the current instance
+	std::vector<uint32_t> seen((clusters->lights.size() + 31) / 32);
+
+	for (int i = begin; i < end; i++) {
+		const float *aabb = job->aabbs + i * 6;
+		uint16_t *out = job->lightIndices + i * job->maxLights;
+		job->lightCounts[i] = 0;
+
+		// view space box around the world space box
+		float center[3], half[3];
+		mat4TransformPoint(view, aabb, center);
+		for (int r = 0; r < 3; r++)
+			half[r] = fabsf(view[r]) * aabb[3] + fabsf(view[4 + r]) * aabb[4] + fabsf(view[8 + r]) * aabb[5];
+
+		float minDepth = -center[2] - half[2];
+		float maxDepth = -center[2] + half[2];
+		if (maxDepth < nearClip || minDepth > farClip)
+			continue;
+
+		int firstSlice = sliceOf(clusters, minDepth);
+		int lastSlice = sliceOf(clusters, maxDepth);
+		int range[4] = { 0, tilesX - 1, 0, tilesY - 1 };
+		// a box crossing the near plane does not project to a bounded rectangle
+		if (minDepth > nearClip)
+			tileRange(clusters, center[0] - half[0], center[0] + half[0], center[1] - half[1], center[1] + half[1], minDepth, maxDepth < farClip ? maxDepth : farClip, range);
+
+		memset(seen.data(), 0, seen.size() * sizeof(uint32_t));
+		bool any = false;
+		for (int s = firstSlice; s <= lastSlice; s++) {
+			for (int y = range[2]; y <= range[3]; y++) {
+				for (int x = range[0]; x <= range[1]; x++) {
+					int cluster = (s * tilesY + y) * tilesX + x;
+					for (uint32_t k = clusters->offsets[cluster]; k < clusters->offsets[cluster + 1]; k++) {
+						uint16_t light = clusters->indices[k];
+						seen[light >> 5] |= 1u << (light & 31);
+						any = true;
+					}
+				}
+			}
+		}
+		if (!any)
+			continue;
+
+		uint32_t mask = job->masks ? job->masks[i] : 0xffffffffu;
+		int n = 0;
+		for (int w = 0; w < (int) seen.size(); w++) {
+			uint32_t bits = seen[w];
+			for (int b = 0; bits; b++, bits >>= 1) {
+				if (!(bits & 1))
+					continue;
+				const LightClusterLight &light = clusters->lights[w * 32 + b];
+				if (!(light.mask & mask) || !sphereIntersectsAabb(light.sphere, aabb))
+					continue;
+				if (n < job->maxLights)
+					out[n++] = (uint16_t) (w * 32 + b);
+				else
+					dropped++;
+			}
+		}
+		job->lightCounts[i] = n;
+	}
+
+	job->dropped += dropped;
+}
+
+CCALL int light_clusters_get_instance_lights(LightClusters *clusters, const float *aabbs, const uint32_t *masks, int count, int maxLights, uint16_t *lightIndices, int *lightCounts) {
+	InstanceLightsJob job;
+	job.clusters = clusters;
+	job.aabbs = aabbs;
+	job.masks = masks;
+	job.maxLights = maxLights;
+	job.lightIndices = lightIndices;
+	job.lightCounts = lightCounts;
+	job.dropped = 0;
+
+	pc::parallel_for(count, LIGHT_CLUSTERS_GRAIN, findInstanceLights, &job);
+
+	int total = 0;
+	for (int i = 0; i < count; i++)
+		total += lightCounts[i];
+
+	clusters->stats.instances = count;
+	clusters->stats.instanceLights = total;
+	clusters->stats.droppedLights = job.dropped;
+	return total;
+}
+
+CCALL LightClustersStats *light_clusters_get_stats(LightClusters *clusters) {
+	return &clusters->stats;
+}
@@ -0,0 +1,99 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Clustered assignment of point and spot lights.
+ *
+ * The view frustum of a camera is split into a grid of clusters (froxels): tilesX by tilesY tiles
+ * in screen space, and slices in view depth that grow exponentially from the near to the far clip,
+ * so clusters keep roughly the same proportions at every distance. Every light is binned into the
+ * clusters its bounding sphere overlaps (see pc.Light#getBoundingSphere, spot lights use the sphere
+ * around their cone like pc.ForwardRenderer#cullLights does), which produces one compact list of
+ * light indices per cluster.
+ *
+ * The clusters also answer which lights touch a mesh instance: the lists of the clusters covered
+ * by its aabb are merged and every light in them is tested against the aabb. A renderer can then
+ * dispatch only those lights to the draw call instead of every light of the layer.
+ *
+ * Indices refer to the lights passed to light_clusters_assign, and lists are in ascending index
+ * order, so passing lights sorted by importance makes a capped list keep the most important ones.
+ */
+
+// light indices are stored in 16 bits
+#define LIGHT_CLUSTERS_MAX_LIGHTS 65535
+
+struct LightClusterLight {
+	float sphere[4]; // world space bounding sphere, center and radius
+	uint32_t mask;   // pc.Light#mask, tested against the mask of mesh instances
+};
+
+struct LightClustersStats {
+	int lights;
+	int visibleLights;      // lights that overlap at least one cluster
+	int clusterLights;      // entries of all cluster lists
+	int occupiedClusters;
+	int maxClusterLights;   // longest cluster list
+	int instances;
+	int instanceLights;     // lights reported for all instances
+	int droppedLights;      // lights that did not fit the per instance limit
+};
+
+struct LightClusters {
+	int tilesX;
+	int tilesY;
+	int slices;
+	int numClusters;
+
+	float view[16];
+	float projection[16];
+	float nearClip;
+	float farClip;
+	float sliceScale; // slices / log(far / near)
+
+	std::vector<float> sliceDepths;   // slices + 1 view depths
+	std::vector<float> clusterBounds; // view space aabb per cluster, min xyz, max xyz
+
+	std::vector<LightClusterLight> lights;
+	std::vector<float> viewSpheres; // 4 per light
+	std::vector<uint32_t> offsets;  // numClusters + 1, the list of cluster i is [offsets[i], offsets[i + 1])
+	std::vector<uint16_t> indices;
+
+	// light and cluster of every overlap found, before they are grouped by cluster
+	std::vector<uint16_t> pairLights;
+	std::vector<uint32_t> pairClusters;
+
+	LightClustersStats stats;
+};
+
+CCALL LightClusters *light_clusters_create(int tilesX, int tilesY, int slices);
+CCALL void light_clusters_destroy(LightClusters *clusters);
+
+// view and projection are column-major (pc.Mat4#data), e.g. pc.Camera#getViewMatrix and
+// pc.Camera#getProjectionMatrix. Rebuilds the cluster bounds, call it before assigning lights
+// whenever the camera moved or its projection changed.
+CCALL void light_clusters_set_camera(LightClusters *clusters, const float *view, const float *projection, float nearClip, float farClip);
+
+// Bins count lights (at most LIGHT_CLUSTERS_MAX_LIGHTS) into the clusters.
+CCALL void light_clusters_assign(LightClusters *clusters, const LightClusterLight *lights, int count);
+
+// The compact lists: light indices of cluster i are indices[offsets[i]] to indices[offsets[i + 1] - 1].
+// Clusters are numbered (slice * tilesY + tileY) * tilesX + tileX, tile 0, 0 is at the bottom left.
+CCALL const uint32_t *light_clusters_get_offsets(LightClusters *clusters);
+CCALL const uint16_t *light_clusters_get_indices(LightClusters *clusters);
+CCALL int light_clusters_get_cluster(LightClusters *clusters, int tileX, int tileY, int slice);
+
+// Finds the lights of count mesh instances. aabbs holds a world space center and half extents per
+// instance (pc.BoundingBox#center, pc.BoundingBox#halfExtents), masks one pc.MeshInstance#mask per
+// instance. Up to maxLights light indices per instance are written to lightIndices at instance *
+// maxLights, their number to lightCounts. Returns the number of lights written. Instances are split
+// between the threads of the pool.
+CCALL int light_clusters_get_instance_lights(LightClusters *clusters, const float *aabbs, const uint32_t *masks, int count, int maxLights, uint16_t *lightIndices, int *lightCounts);
+
+CCALL LightClustersStats *light_clusters_get_stats(LightClusters *clusters);
+
+#endif
@@ -0,0 +1,355 @@
+#include "morph_accumulator.h"
+#include "simd_float4.h"
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+using namespace pc::simd;
+
+static inline void boundsReset(float *bounds) {
+	bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+	bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+}
+
+static inline void boundsAddPoint(float *bounds, const float *p) {
+	for (int i = 0; i < 3; i++) {
+		bounds[i] = p[i] < bounds[i] ? p[i] : bounds[i];
+		bounds[i + 3] = p[i] > bounds[i + 3] ? p[i] : bounds[i + 3];
+	}
+}
+
+static inline void boundsAdd(float *bounds, const float *other) {
+	for (int i = 0; i < 3; i++) {
+		bounds[i] = other[i] < bounds[i] ? other[i] : bounds[i];
+		bounds[i + 3] = other[i + 3] > bounds[i + 3] ? other[i + 3] : bounds[i + 3];
+	}
+}
+
+// bounds of the positions of [first, end) in vertices
+static void boundsAddVertices(float *bounds, const MorphAccumulator *accumulator, const float *vertices, int first, int end) {
+	const float *p = vertices + first * accumulator->vertexSize + accumulator->offsetPosition;
+	for (int v = first; v < end; v++, p += accumulator->vertexSize)
+		boundsAddPoint(bounds, p);
+}
+
+CCALL MorphAccumulator *morph_accumulator_create(const float *base, float *output, int numVertices, int vertexSize, int offsetPosition, int offsetNormal, int offsetTangent) {
+	MorphAccumulator *accumulator = new MorphAccumulator();
+	accumulator->base = base;
+	accumulator->output = output;
+	accumulator->numVertices = numVertices;
+	accumulator->vertexSize = vertexSize;
+	accumulator->offsetPosition = offsetPosition;
+	accumulator->offsetNormal = offsetNormal;
+	accumulator->offsetTangent = offsetTangent;
+	accumulator->weightsChanged = false;
+	accumulator->activeFirst = accumulator->activeEnd = 0;
+	accumulator->dirtyFirst = accumulator->dirtyEnd = 0;
+	memset(&accumulator->stats, 0, sizeof(accumulator->stats));
+
+	int numBlocks = (numVertices + MORPH_BOUNDS_BLOCK - 1) / MORPH_BOUNDS_BLOCK;
+	accumulator->blockBounds.resize(numBlocks * 6);
+	boundsReset(accumulator->baseBounds);
+	for (int b = 0; b < numBlocks; b++) {
+		float *block = &accumulator->blockBounds[b * 6];
+		boundsReset(block);
+		boundsAddVertices(block, accumulator, base, b * MORPH_BOUNDS_BLOCK, std::min(numVertices, (b + 1) * MORPH_BOUNDS_BLOCK));
+		boundsAdd(accumulator->baseBounds, block);
+	}
+	accumulator->boundsMode = MORPH_BOUNDS_CONSERVATIVE;
+	accumulator->boundsDirty = true;
+	return accumulator;
+}
+
+CCALL void morph_accumulator_destroy(MorphAccumulator *accumulator) {
+	delete accumulator;
+}
+
+struct ByVertex {
+	const int *indices;
+
+	bool operator()(int a, int b) const {
+		return indices[a] < indices[b];
+	}
+};
+
+static inline bool isZero(const float *v, int count) {
+	for (int i = 0; i < count; i++) {
+		if (v[i] != 0.0f)
+			return false;
+	}
+	return true;
+}
+
+static inline void appendPadded(std::vector<float> &dst, const float *v, int count) {
+	dst.insert(dst.end(), v, v + count);
+	if (count == 3)
+		dst.push_back(0.0f);
+}
+
+CCALL int morph_accumulator_add_target(MorphAccumulator *accumulator, int numDeltas, const int *indices, const float *positions, const float *normals, const float *tangents) {
+	int index = (int) accumulator->targets.size();
+	accumulator->targets.push_back(MorphTargetData());
+	MorphTargetData &target = accumulator->targets.back();
+	target.weight = 0.0f;
+
+	if (!normals || accumulator->offsetNormal < 0)
+		normals = NULL;
+	if (!normals || accumulator->offsetTangent < 0)
+		tangents = NULL;
+
+	std::vector<int> order(numDeltas);
+	for (int i = 0; i < numDeltas; i++)
+		order[i] = i;
+	ByVertex byVertex;
+	byVertex.indices = indices;
+	std::sort(order.begin(), order.end(), byVertex);
+
+	for (int i = 0; i < 4; i++)
+		target.deltaMin[i] = target.deltaMax[i] = 0.0f;
+
+	int numKept = 0;
+	for (int i = 0; i < numDeltas; i++) {
+		int j = order[i];
+		if (isZero(positions + j * 3, 3) && (!normals || isZero(normals + j * 3, 3)) && (!tangents || isZero(tangents + j * 4, 4)))
+			continue;
+
+		int vertex = indices[j];
+		MorphRun *run = target.runs.empty() ? NULL : &target.runs.back();
+		if (run && run->firstVertex + run->count == vertex) {
+			run->count++;
+		} else {
+			MorphRun next;
+			next.firstVertex = vertex;
+			next.count = 1;
+			next.firstDelta = numKept;
+			target.runs.push_back(next);
+		}
+
+		for (int c = 0; c < 3; c++) {
+			float d = positions[j * 3 + c];
+			target.deltaMin[c] = d < target.deltaMin[c] ? d : target.deltaMin[c];
+			target.deltaMax[c] = d > target.deltaMax[c] ? d : target.deltaMax[c];
+		}
+
+		appendPadded(target.positions, positions + j * 3, 3);
+		if (normals)
+			appendPadded(target.normals, normals + j * 3, 3);
+		if (tangents)
+			appendPadded(target.tangents, tangents + j * 4, 4);
+		numKept++;
+	}
+
+	target.numDeltas = numKept;
+	if (target.runs.empty()) {
+		target.firstVertex = target.endVertex = 0;
+	} else {
+		const MorphRun &last = target.runs.back();
+		target.firstVertex = target.runs[0].firstVertex;
+		target.endVertex = last.firstVertex + last.count;
+	}
+	return index;
+}
+
+CCALL void morph_accumulator_set_weight(MorphAccumulator *accumulator, int target, float weight) {
+	if (accumulator->targets[target].weight != weight) {
+		accumulator->targets[target].weight = weight;
+		accumulator->weightsChanged = true;
+		accumulator->boundsDirty = true;
+	}
+}
+
+CCALL float morph_accumulator_get_weight(MorphAccumulator *accumulator, int target) {
+	return accumulator->targets[target].weight;
+}
+
+// out[0..2] += delta * weight, with a float4 when the 4th float still belongs to the vertex
+static inline void addVec3(float *out, const float *delta, float4 weight, bool wide) {
+	if (wide) {
+		store(out, load(out) + load(delta) * weight);
+	} else {
+		float tmp[4];
+		store(tmp, load(delta) * weight);
+		out[0] += tmp[0];
+		out[1] += tmp[1];
+		out[2] += tmp[2];
+	}
+}
+
+static void accumulateTarget(MorphAccumulator *accumulator, const MorphTargetData &target) {
+	float *output = accumulator->output;
+	int vertexSize = accumulator->vertexSize;
+	int offsetPosition = accumulator->offsetPosition;
+	int offsetNormal = accumulator->offsetNormal;
+	int offsetTangent = accumulator->offsetTangent;
+	bool widePosition = offsetPosition + 4 <= vertexSize;
+	bool wideNormal = offsetNormal + 4 <= vertexSize;
+	bool hasNormals = !target.normals.empty();
+	bool hasTangents = !target.tangents.empty();
+	float4 weight = set1(target.weight);
+
+	for (size_t r = 0; r < target.runs.size(); r++) {
+		const MorphRun &run = target.runs[r];
+		for (int i = 0; i < run.count; i++) {
+			float *vertex = output + (run.firstVertex + i) * vertexSize;
+			int delta = (run.firstDelta + i) * 4;
+
+			addVec3(vertex + offsetPosition, &target.positions[delta], weight, widePosition);
+			if (hasNormals)
+				addVec3(vertex + offsetNormal, &target.normals[delta], weight, wideNormal);
+			if (hasTangents) {
+				float *tangent = vertex + offsetTangent;
+				store(tangent, load(tangent) + load(&target.tangents[delta]) * weight);
+				tangent[3] = tangent[3] > 0.0f ? 1.0f : -1.0f;
+			}
+		}
+	}
+}
+
+CCALL int morph_accumulator_update(MorphAccumulator *accumulator) {
+	accumulator->stats.dirtyVertices = 0;
+	if (!accumulator->weightsChanged)
+		return 0;
+	accumulator->weightsChanged = false;
+
+	// range of the active targets
+	int activeFirst = accumulator->numVertices;
+	int activeEnd = 0;
+	int activeTargets = 0;
+	int vertices = 0;
+	for (size_t i = 0; i < accumulator->targets.size(); i++) {
+		const MorphTargetData &target = accumulator->targets[i];
+		if (target.weight == 0.0f || target.numDeltas == 0)
+			continue;
+		activeFirst = std::min(activeFirst, target.firstVertex);
+		activeEnd = std::max(activeEnd, target.endVertex);
+		activeTargets++;
+		vertices += target.numDeltas;
+	}
+	if (activeFirst >= activeEnd)
+		activeFirst = activeEnd = 0;
+
+	// restore what the last update and this one touch
+	int first = activeFirst;
+	int end = activeEnd;
+	if (accumulator->activeFirst < accumulator->activeEnd) {
+		first = first < end ? std::min(first, accumulator->activeFirst) : accumulator->activeFirst;
+		end = std::max(end, accumulator->activeEnd);
+	}
+	if (first < end) {
+		int vertexSize = accumulator->vertexSize;
+		memcpy(accumulator->output + first * vertexSize, accumulator->base + first * vertexSize, sizeof(float) * (end - first) * vertexSize);
+	}
+
+	for (size_t i = 0; i < accumulator->targets.size(); i++) {
+		const MorphTargetData &target = accumulator->targets[i];
+		if (target.weight != 0.0f && target.numDeltas > 0)
+			accumulateTarget(accumulator, target);
+	}
+
+	accumulator->activeFirst = activeFirst;
+	accumulator->activeEnd = activeEnd;
+	if (first < end) {
+		if (accumulator->dirtyFirst < accumulator->dirtyEnd) {
+			accumulator->dirtyFirst = std::min(accumulator->dirtyFirst, first);
+			accumulator->dirtyEnd = std::max(accumulator->dirtyEnd, end);
+		} else {
+			accumulator->dirtyFirst = first;
+			accumulator->dirtyEnd = end;
+		}
+	}
+
+	accumulator->stats.activeTargets = activeTargets;
+	accumulator->stats.vertices = vertices;
+	accumulator->stats.dirtyVertices = end - first;
+	return end - first;
+}
+
+CCALL int morph_accumulator_get_dirty_first(MorphAccumulator *accumulator) {
+	return accumulator->dirtyFirst;
+}
+
+CCALL int morph_accumulator_get_dirty_count(MorphAccumulator *accumulator) {
+	return accumulator->dirtyEnd - accumulator->dirtyFirst;
+}
+
+CCALL void morph_accumulator_clear_dirty(MorphAccumulator *accumulator) {
+	accumulator->dirtyFirst = accumulator->dirtyEnd = 0;
+}
+
+CCALL void morph_accumulator_set_bounds_mode(MorphAccumulator *accumulator, int mode) {
+	if (accumulator->boundsMode != mode) {
+		accumulator->boundsMode = mode;
+		accumulator->boundsDirty = true;
+	}
+}
+
+// Base bounds moved by every active target: a positive weight scales the delta extents as they
+// are, a negative one swaps them.
+static void conservativeBounds(MorphAccumulator *accumulator) {
+	float4 lo = set(accumulator->baseBounds[0], accumulator->baseBounds[1], accumulator->baseBounds[2], 0.0f);
+	float4 hi = set(accumulator->baseBounds[3], accumulator->baseBounds[4], accumulator->baseBounds[5], 0.0f);
+	for (size_t i = 0; i < accumulator->targets.size(); i++) {
+		const MorphTargetData &target = accumulator->targets[i];
+		if (target.weight == 0.0f || target.numDeltas == 0)
+			continue;
+
+		float4 weight = set1(target.weight);
+		float4 deltaMin = load(target.deltaMin) * weight;
+		float4 deltaMax = load(target.deltaMax) * weight;
+		lo = lo + min(deltaMin, deltaMax);
+		hi = hi + max(deltaMin, deltaMax);
+	}
+
+	float tmp[4];
+	store(tmp, lo);
+	memcpy(accumulator->bounds, tmp, sizeof(float) * 3);
+	store(tmp, hi);
+	memcpy(accumulator->bounds + 3, tmp, sizeof(float) * 3);
+}
+
+// Morphed positions in the active range, base blocks outside of it.
+static void exactBounds(MorphAccumulator *accumulator) {
+	morph_accumulator_update(accumulator);
+
+	float *bounds = accumulator->bounds;
+	int first = accumulator->activeFirst;
+	int end = accumulator->activeEnd;
+	if (first >= end) {
+		memcpy(bounds, accumulator->baseBounds, sizeof(float) * 6);
+		accumulator->stats.boundsVertices = 0;
+		return;
+	}
+
+	boundsReset(bounds);
+	int firstBlock = first / MORPH_BOUNDS_BLOCK;
+	int endBlock = (end + MORPH_BOUNDS_BLOCK - 1) / MORPH_BOUNDS_BLOCK;
+	for (int b = 0; b < firstBlock; b++)
+		boundsAdd(bounds, &accumulator->blockBounds[b * 6]);
+	for (int b = endBlock; b < (int) accumulator->blockBounds.size() / 6; b++)
+		boundsAdd(bounds, &accumulator->blockBounds[b * 6]);
+
+	// the partial blocks at both ends of the range
+	int blockStart = firstBlock * MORPH_BOUNDS_BLOCK;
+	int blockEnd = std::min(accumulator->numVertices, endBlock * MORPH_BOUNDS_BLOCK);
+	boundsAddVertices(bounds, accumulator, accumulator->base, blockStart, first);
+	boundsAddVertices(bounds, accumulator, accumulator->base, end, blockEnd);
+
+	boundsAddVertices(bounds, accumulator, accumulator->output, first, end);
+	accumulator->stats.boundsVertices = blockEnd - blockStart;
+}
+
+CCALL const float *morph_accumulator_get_bounds(MorphAccumulator *accumulator) {
+	if (accumulator->boundsDirty) {
+		if (accumulator->boundsMode == MORPH_BOUNDS_EXACT)
+			exactBounds(accumulator);
+		else
+			conservativeBounds(accumulator);
+		accumulator->boundsDirty = false;
+	}
+	return accumulator->bounds;
+}
+
+CCALL MorphAccumulatorStats *morph_accumulator_get_stats(MorphAccumulator *accumulator) {
+	return &accumulator->stats;
+}
@@ -0,0 +1,118 @@
+#ifndef MORPH_ACCUMULATOR_H
+#define MORPH_ACCUMULATOR_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Native pc.MorphInstance#update.
+ *
+ * Morph targets are stored sparse: vertices whose deltas are all zero are dropped and the rest is
+ * grouped into runs of consecutive vertex indices, with position, normal and tangent deltas padded
+ * to 4 floats so that they are added with one float4 operation each. Only targets with a non-zero
+ * weight are accumulated.
+ *
+ * Every target knows the range of vertices it touches. An update restores the base vertices only
+ * over the range touched by the previous and the current set of active targets, and that range is
+ * added to the dirty range, the part of the vertex buffer that needs uploading.
+ *
+ * Bounds of the morphed positions come in two modes. The conservative bounds move the bounds of
+ * the base mesh by the weighted extents of the position deltas of every active target, which costs
+ * O(active targets) and needs no vertices. The exact bounds apply the weights first and then only
+ * scan the vertices in the range of the active targets: the rest of the mesh is covered by bounds
+ * of blocks of base vertices computed once.
+ */
+
+#define MORPH_BOUNDS_CONSERVATIVE 0
+#define MORPH_BOUNDS_EXACT 1
+
+// vertices per block of precomputed base bounds
+#define MORPH_BOUNDS_BLOCK 64
+
+struct MorphRun {
+	int32_t firstVertex;
+	int32_t count;
+	int32_t firstDelta; // index of the deltas of firstVertex in the target's arrays
+};
+
+struct MorphTargetData {
+	std::vector<MorphRun> runs;
+	std::vector<float> positions; // 4 per delta, the last one 0
+	std::vector<float> normals;   // 4 per delta, the last one 0, empty without normals
+	std::vector<float> tangents;  // 4 per delta, empty without normals or tangents
+	int numDeltas;
+	int firstVertex; // range of vertices touched, [firstVertex, endVertex)
+	int endVertex;
+	// extents of the position deltas, including the zero delta of untouched vertices
+	float deltaMin[4];
+	float deltaMax[4];
+	float weight;
+};
+
+struct MorphAccumulatorStats {
+	int activeTargets; // targets with a non-zero weight in the last update
+	int vertices;      // vertex deltas added by the last update
+	int dirtyVertices; // vertices written by the last update
+	int boundsVertices; // vertices scanned by the last exact bounds update
+};
+
+struct MorphAccumulator {
+	const float *base;
+	float *output;
+	int numVertices;
+	int vertexSize; // in floats
+	int offsetPosition;
+	int offsetNormal;  // -1 without normals
+	int offsetTangent; // -1 without tangents
+
+	std::vector<MorphTargetData> targets;
+	bool weightsChanged;
+
+	// vertices the active targets touched in the last update, restored from base on the next one
+	int activeFirst;
+	int activeEnd;
+	// vertices written since the last morph_accumulator_clear_dirty
+	int dirtyFirst;
+	int dirtyEnd;
+
+	// min xyz and max xyz of the base positions, then per MORPH_BOUNDS_BLOCK vertices
+	float baseBounds[6];
+	std::vector<float> blockBounds;
+	int boundsMode;
+	bool boundsDirty;
+	float bounds[6];
+
+	MorphAccumulatorStats stats;
+};
+
+// base and output are interleaved vertex buffers of numVertices * vertexSize floats, offsets are in
+// floats as well. output should start as a copy of base. Neither is copied, both must outlive the
+// accumulator.
+CCALL MorphAccumulator *morph_accumulator_create(const float *base, float *output, int numVertices, int vertexSize, int offsetPosition, int offsetNormal, int offsetTangent);
+CCALL void morph_accumulator_destroy(MorphAccumulator *accumulator);
+
+// Adds a target like pc.MorphTarget: numDeltas vertex indices with 3 position, 3 normal and 4
+// tangent deltas each. normals and tangents may be null, tangents are ignored without normals.
+// Returns the target index.
+CCALL int morph_accumulator_add_target(MorphAccumulator *accumulator, int numDeltas, const int *indices, const float *positions, const float *normals, const float *tangents);
+CCALL void morph_accumulator_set_weight(MorphAccumulator *accumulator, int target, float weight);
+CCALL float morph_accumulator_get_weight(MorphAccumulator *accumulator, int target);
+
+// Applies the weights to output when they changed since the last update. Returns the number of
+// vertices written.
+CCALL int morph_accumulator_update(MorphAccumulator *accumulator);
+// Range of vertices written since the dirty range was last cleared.
+CCALL int morph_accumulator_get_dirty_first(MorphAccumulator *accumulator);
+CCALL int morph_accumulator_get_dirty_count(MorphAccumulator *accumulator);
+CCALL void morph_accumulator_clear_dirty(MorphAccumulator *accumulator);
+
+// MORPH_BOUNDS_CONSERVATIVE (the default) or MORPH_BOUNDS_EXACT.
+CCALL void morph_accumulator_set_bounds_mode(MorphAccumulator *accumulator, int mode);
+// Bounds of the morphed positions for the current weights, min xyz then max xyz. Exact bounds
+// update output first, see morph_accumulator_update.
+CCALL const float *morph_accumulator_get_bounds(MorphAccumulator *accumulator);
+CCALL MorphAccumulatorStats *morph_accumulator_get_stats(MorphAccumulator *accumulator);
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef NATIVE_MATH_H
+#define NATIVE_MATH_H
+
+#include <math.h>
+
+/**
+ * Plain float-array math used by the native kernels.
+ *
+ * These mirror the src/math classes operation by operation (pc.Mat4#setTRS, pc.Mat4#mul2,
+ * pc.Quat#mul2, pc.Quat#slerp, ...) so results match the script engine. Matrices use the
+ * column-major pc.Mat4#data layout, vectors are xyz and quaternions xyzw.
+ */
+
+namespace pc {
+namespace native {
+
+	static inline void mat4SetIdentity(float *m) {
+		for (int i = 0; i < 16; i++)
+			m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	}
+
+	// pc.Mat4#mul2, r may not alias a or b
+	static inline void mat4Mul(float *r, const float *a, const float *b) {
+		for (int c = 0; c < 16; c += 4) {
+			float b0 = b[c], b1 = b[c + 1], b2 = b[c + 2], b3 = b[c + 3];
+			r[c]     = a[0] * b0 + a[4] * b1 + a[8] * b2 + a[12] * b3;
+			r[c + 1] = a[1] * b0 + a[5] * b1 + a[9] * b2 + a[13] * b3;
+			r[c + 2] = a[2] * b0 + a[6] * b1 + a[10] * b2 + a[14] * b3;
+			r[c + 3] = a[3] * b0 + a[7] * b1 + a[11] * b2 + a[15] * b3;
+		}
+	}
+
+	// pc.Mat4#mul2 for affine matrices (last row 0, 0, 0, 1), which is every graph node transform
+	static inline void mat4MulAffine(float *r, const float *a, const float *b) {
+		for (int c = 0; c < 16; c += 4) {
+			float b0 = b[c], b1 = b[c + 1], b2 = b[c + 2];
+			float w = (c == 12) ? 1.0f : 0.0f;
+			r[c]     = a[0] * b0 + a[4] * b1 + a[8] * b2 + a[12] * w;
+			r[c + 1] = a[1] * b0 + a[5] * b1 + a[9] * b2 + a[13] * w;
+			r[c + 2] = a[2] * b0 + a[6] * b1 + a[10] * b2 + a[14] * w;
+			r[c + 3] = w;
+		}
+	}
+
+	// pc.Mat4#invert, r may alias m
+	static inline void mat4Invert(float *r, const float *m) {
+		float a00 = m[0], a01 = m[1], a02 = m[2], a03 = m[3];
+		float a10 = m[4], a11 = m[5], a12 = m[6], a13 = m[7];
+		float a20 = m[8], a21 = m[9], a22 = m[10], a23 = m[11];
+		float a30 = m[12], a31 = m[13], a32 = m[14], a33 = m[15];
+
+		float b00 = a00 * a11 - a01 * a10;
+		float b01 = a00 * a12 - a02 * a10;
+		float b02 = a00 * a13 - a03 * a10;
+		float b03 = a01 * a12 - a02 * a11;
+		float b04 = a01 * a13 - a03 * a11;
+		float b05 = a02 * a13 - a03 * a12;
+		float b06 = a20 * a31 - a21 * a30;
+		float b07 = a20 * a32 - a22 * a30;
+		float b08 = a20 * a33 - a23 * a30;
+		float b09 = a21 * a32 - a22 * a31;
+		float b10 = a21 * a33 - a23 * a31;
+		float b11 = a22 * a33 - a23 * a32;
+
+		float det = (b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06);
+		if (det == 0) {
+			mat4SetIdentity(r);
+			return;
+		}
+
+		float invDet = 1 / det;
+		r[0] = (a11 * b11 - a12 * b10 + a13 * b09) * invDet;
+		r[1] = (-a01 * b11 + a02 * b10 - a03 * b09) * invDet;
+		r[2] = (a31 * b05 - a32 * b04 + a33 * b03) * invDet;
+		r[3] = (-a21 * b05 + a22 * b04 - a23 * b03) * invDet;
+		r[4] = (-a10 * b11 + a12 * b08 - a13 * b07) * invDet;
+		r[5] = (a00 * b11 - a02 * b08 + a03 * b07) * invDet;
+		r[6] = (-a30 * b05 + a32 * b02 - a33 * b01) * invDet;
+		r[7] = (a20 * b05 - a22 * b02 + a23 * b01) * invDet;
+		r[8] = (a10 * b10 - a11 * b08 + a13 * b06) * invDet;
+		r[9] = (-a00 * b10 + a01 * b08 - a03 * b06) * invDet;
+		r[10] = (a30 * b04 - a31 * b02 + a33 * b00) * invDet;
+		r[11] = (-a20 * b04 + a21 * b02 - a23 * b00) * invDet;
+		r[12] = (-a10 * b09 + a11 * b07 - a12 * b06) * invDet;
+		r[13] = (a00 * b09 - a01 * b07 + a02 * b06) * invDet;
+		r[14] = (-a30 * b03 + a31 * b01 - a32 * b00) * invDet;
+		r[15] = (a20 * b03 - a21 * b01 + a22 * b00) * invDet;
+	}
+
+	// pc.Mat4#setTRS
+	static inline void mat4SetTRS(float *m, const float *t, const float *q, const float *s) {
+		float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+		float xx = q[0] * x2, xy = q[0] * y2, xz = q[0] * z2;
+		float yy = q[1] * y2, yz = q[1] * z2, zz = q[2] * z2;
+		float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+
+		m[0] = (1 - (yy + zz)) * s[0];
+		m[1] = (xy + wz) * s[0];
+		m[2] = (xz - wy) * s[0];
+		m[3] = 0;
+
+		m[4] = (xy - wz) * s[1];
+		m[5] = (1 - (xx + zz)) * s[1];
+		m[6] = (yz + wx) * s[1];
+		m[7] = 0;
+
+		m[8] = (xz + wy) * s[2];
+		m[9] = (yz - wx) * s[2];
+		m[10] = (1 - (xx + yy)) * s[2];
+		m[11] = 0;
+
+		m[12] = t[0];
+		m[13] = t[1];
+		m[14] = t[2];
+		m[15] = 1;
+	}
+
+	// pc.Mat4#getScale
+	static inline void mat4GetScale(const float *m, float *s) {
+		s[0] = sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+		s[1] = sqrtf(m[4] * m[4] + m[5] * m[5] + m[6] * m[6]);
+		s[2] = sqrtf(m[8] * m[8] + m[9] * m[9] + m[10] * m[10]);
+	}
+
+	// pc.Mat4#transformPoint
+	static inline void mat4TransformPoint(const float *m, const float *p, float *r) {
+		float x = p[0], y = p[1], z = p[2];
+		r[0] = x * m[0] + y * m[4] + z * m[8] + m[12];
+		r[1] = x * m[1] + y * m[5] + z * m[9] + m[13];
+		r[2] = x * m[2] + y * m[6] + z * m[10] + m[14];
+	}
+
+	// pc.Vec3#lerp, r may alias a or b
+	static inline void vec3Lerp(float *r, const float *a, const float *b, float alpha) {
+		r[0] = a[0] + alpha * (b[0] - a[0]);
+		r[1] = a[1] + alpha * (b[1] - a[1]);
+		r[2] = a[2] + alpha * (b[2] - a[2]);
+	}
+
+	// pc.Quat#mul2, r may alias a or b
+	static inline void quatMul(float *r, const float *a, const float *b) {
+		float ax = a[0], ay = a[1], az = a[2], aw = a[3];
+		float bx = b[0], by = b[1], bz = b[2], bw = b[3];
+		r[0] = aw * bx + ax * bw + ay * bz - az * by;
+		r[1] = aw * by + ay * bw + az * bx - ax * bz;
+		r[2] = aw * bz + az * bw + ax * by - ay * bx;
+		r[3] = aw * bw - ax * bx - ay * by - az * bz;
+	}
+
+	// pc.Quat#setFromMat4
+	static inline void quatSetFromMat4(float *q, const float *m) {
+		float m00 = m[0], m01 = m[1], m02 = m[2];
+		float m10 = m[4], m11 = m[5], m12 = m[6];
+		float m20 = m[8], m21 = m[9], m22 = m[10];
+
+		// remove the scale from the matrix
+		float lx = 1 / sqrtf(m00 * m00 + m01 * m01 + m02 * m02);
+		float ly = 1 / sqrtf(m10 * m10 + m11 * m11 + m12 * m12);
+		float lz = 1 / sqrtf(m20 * m20 + m21 * m21 + m22 * m22);
+		m00 *= lx; m01 *= lx; m02 *= lx;
+		m10 *= ly; m11 *= ly; m12 *= ly;
+		m20 *= lz; m21 *= lz; m22 *= lz;
+
+		float tr = m00 + m11 + m22;
+		float s;
+		if (tr >= 0) {
+			s = sqrtf(tr + 1);
+			q[3] = s * 0.5f;
+			s = 0.5f / s;
+			q[0] = (m12 - m21) * s;
+			q[1] = (m20 - m02) * s;
+			q[2] = (m01 - m10) * s;
+		} else if (m00 > m11 && m00 > m22) {
+			s = sqrtf((m00 - (m11 + m22)) + 1);
+			q[0] = s * 0.5f;
+			s = 0.5f / s;
+			q[3] = (m12 - m21) * s;
+			q[1] = (m01 + m10) * s;
+			q[2] = (m02 + m20) * s;
+		} else if (m00 <= m11 && m11 > m22) {
+			s = sqrtf((m11 - (m22 + m00)) + 1);
+			q[1] = s * 0.5f;
+			s = 0.5f / s;
+			q[3] = (m20 - m02) * s;
+			q[2] = (m12 + m21) * s;
+			q[0] = (m10 + m01) * s;
+		} else {
+			s = sqrtf((m22 - (m00 + m11)) + 1);
+			q[2] = s * 0.5f;
+			s = 0.5f / s;
+			q[3] = (m01 - m10) * s;
+			q[0] = (m20 + m02) * s;
+			q[1] = (m21 + m12) * s;
+		}
+	}
+
+	// pc.Quat#slerp, r may alias a or b
+	static inline void quatSlerp(float *r, const float *a, const float *b, float alpha) {
+		float lx = a[0], ly = a[1], lz = a[2], lw = a[3];
+		float rx = b[0], ry = b[1], rz = b[2], rw = b[3];
+
+		float cosHalfTheta = lw * rw + lx * rx + ly * ry + lz * rz;
+		if (cosHalfTheta < 0) {
+			rw = -rw;
+			rx = -rx;
+			ry = -ry;
+			rz = -rz;
+			cosHalfTheta = -cosHalfTheta;
+		}
+
+		// lhs == rhs or lhs == -rhs
+		if (fabsf(cosHalfTheta) >= 1) {
+			r[0] = lx;
+			r[1] = ly;
+			r[2] = lz;
+			r[3] = lw;
+			return;
+		}
+
+		float halfTheta = acosf(cosHalfTheta);
+		float sinHalfTheta = sqrtf(1 - cosHalfTheta * cosHalfTheta);
+
+		// 180 degrees apart, the result is not fully defined
+		if (fabsf(sinHalfTheta) < 0.001f) {
+			r[0] = lx * 0.5f + rx * 0.5f;
+			r[1] = ly * 0.5f + ry * 0.5f;
+			r[2] = lz * 0.5f + rz * 0.5f;
+			r[3] = lw * 0.5f + rw * 0.5f;
+			return;
+		}
+
+		float ratioA = sinf((1 - alpha) * halfTheta) / sinHalfTheta;
+		float ratioB = sinf(alpha * halfTheta) / sinHalfTheta;
+		r[0] = lx * ratioA + rx * ratioB;
+		r[1] = ly * ratioA + ry * ratioB;
+		r[2] = lz * ratioA + rz * ratioB;
+		r[3] = lw * ratioA + rw * ratioB;
+	}
+
+	// pc.Quat#normalize
+	static inline void quatNormalize(float *q) {
+		float len = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		if (len == 0) {
+			q[0] = q[1] = q[2] = 0;
+			q[3] = 1;
+		} else {
+			len = 1 / len;
+			q[0] *= len;
+			q[1] *= len;
+			q[2] *= len;
+			q[3] *= len;
+		}
+	}
+
+}
+}
+
+#endif
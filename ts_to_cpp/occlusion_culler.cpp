@@ -0,0 +1,432 @@
+#include "occlusion_culler.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+using namespace pc::simd;
+
+struct RasterTriangle {
+	// edge functions, edge k is opposite vertex k and is positive inside the triangle
+	float edgeA[3], edgeB[3], edgeC[3];
+	// plane equation of 1/w over the screen
+	float depthA, depthB, depthC;
+	int minX, minY, maxX, maxY;
+};
+
+struct DepthLevel {
+	int width;
+	int height;
+	std::vector<float> depth;
+};
+
+struct OcclusionCuller {
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	float viewProj[16];
+	std::vector<DepthLevel> levels;
+	std::vector<RasterTriangle> triangles;
+	std::vector< std::vector<uint32_t> > bins;
+	OcclusionCullerStats stats;
+};
+
+// r = a * b, all column-major
+static void mul4(float *r, const float *a, const float *b) {
+	for (int c = 0; c < 4; c++) {
+		for (int row = 0; row < 4; row++) {
+			r[c * 4 + row] = a[row] * b[c * 4] + a[4 + row] * b[c * 4 + 1] + a[8 + row] * b[c * 4 + 2] + a[12 + row] * b[c * 4 + 3];
+		}
+	}
+}
+
+static inline void transformPoint(float *clip, const float *m, float x, float y, float z) {
+	clip[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+	clip[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+	clip[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+	clip[3] = m[3] * x + m[7] * y + m[11] * z + m[15];
+}
+
+CCALL OcclusionCuller *occlusion_culler_create(int width, int height) {
+	OcclusionCuller *culler = new OcclusionCuller();
+
+	culler->tilesX = (width + OCCLUSION_CULLER_TILE_WIDTH - 1) / OCCLUSION_CULLER_TILE_WIDTH;
+	culler->tilesY = (height + OCCLUSION_CULLER_TILE_HEIGHT - 1) / OCCLUSION_CULLER_TILE_HEIGHT;
+	if (culler->tilesX < 1) culler->tilesX = 1;
+	if (culler->tilesY < 1) culler->tilesY = 1;
+	culler->width = culler->tilesX * OCCLUSION_CULLER_TILE_WIDTH;
+	culler->height = culler->tilesY * OCCLUSION_CULLER_TILE_HEIGHT;
+	culler->bins.resize(culler->tilesX * culler->tilesY);
+
+	int w = culler->width;
+	int h = culler->height;
+	for (;;) {
+		DepthLevel level;
+		level.width = w;
+		level.height = h;
+		level.depth.assign(w * h, 0.0f);
+		culler->levels.push_back(level);
+		if (w == 1 && h == 1)
+			break;
+		w = w > 1 ? (w + 1) / 2 : 1;
+		h = h > 1 ? (h + 1) / 2 : 1;
+	}
+
+	memset(&culler->stats, 0, sizeof(culler->stats));
+	for (int i = 0; i < 16; i++)
+		culler->viewProj[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+
+	return culler;
+}
+
+CCALL void occlusion_culler_destroy(OcclusionCuller *culler) {
+	delete culler;
+}
+
+CCALL void occlusion_culler_begin_frame(OcclusionCuller *culler, const float *viewProj) {
+	memcpy(culler->viewProj, viewProj, sizeof(culler->viewProj));
+	culler->triangles.clear();
+	for (size_t i = 0; i < culler->bins.size(); i++)
+		culler->bins[i].clear();
+	memset(&culler->stats, 0, sizeof(culler->stats));
+}
+
+// Sets up a triangle that is entirely in front of the near plane and bins it into tiles.
+static void setupTriangle(OcclusionCuller *culler, const float *c0, const float *c1, const float *c2) {
+	const float *clip[3] = { c0, c1, c2 };
+	float x[3], y[3], iw[3];
+	float width = (float) culler->width;
+	float height = (float) culler->height;
+
+	for (int i = 0; i < 3; i++) {
+		iw[i] = 1.0f / clip[i][3];
+		x[i] = (clip[i][0] * iw[i] * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - clip[i][1] * iw[i] * 0.5f) * height;
+	}
+
+	RasterTriangle tri;
+	for (int k = 0; k < 3; k++) {
+		int a = (k + 1) % 3;
+		int b = (k + 2) % 3;
+		tri.edgeA[k] = y[a] - y[b];
+		tri.edgeB[k] = x[b] - x[a];
+		tri.edgeC[k] = x[a] * y[b] - x[b] * y[a];
+	}
+
+	float area = tri.edgeA[0] * x[0] + tri.edgeB[0] * y[0] + tri.edgeC[0];
+	if (fabsf(area) < 1e-6f)
+		return;
+
+	// occluders are rasterized regardless of winding
+	float invArea = 1.0f / area;
+	for (int k = 0; k < 3; k++) {
+		tri.edgeA[k] *= invArea;
+		tri.edgeB[k] *= invArea;
+		tri.edgeC[k] *= invArea;
+	}
+
+	// the normalized edge functions are the barycentric coordinates
+	tri.depthA = tri.edgeA[0] * iw[0] + tri.edgeA[1] * iw[1] + tri.edgeA[2] * iw[2];
+	tri.depthB = tri.edgeB[0] * iw[0] + tri.edgeB[1] * iw[1] + tri.edgeB[2] * iw[2];
+	tri.depthC = tri.edgeC[0] * iw[0] + tri.edgeC[1] * iw[1] + tri.edgeC[2] * iw[2];
+
+	float minX = fminf(x[0], fminf(x[1], x[2]));
+	float maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+	float minY = fminf(y[0], fminf(y[1], y[2]));
+	float maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+	if (maxX <= 0.0f || maxY <= 0.0f || minX >= width || minY >= height)
+		return;
+
+	tri.minX = minX < 0.0f ? 0 : (int) minX;
+	tri.minY = minY < 0.0f ? 0 : (int) minY;
+	tri.maxX = maxX > width ? culler->width : (int) ceilf(maxX);
+	tri.maxY = maxY > height ? culler->height : (int) ceilf(maxY);
+	if (tri.minX >= tri.maxX || tri.minY >= tri.maxY)
+		return;
+
+	uint32_t index = (uint32_t) culler->triangles.size();
+	culler->triangles.push_back(tri);
+	culler->stats.rasterizedTriangles++;
+
+	int tx0 = tri.minX / OCCLUSION_CULLER_TILE_WIDTH;
+	int tx1 = (tri.maxX - 1) / OCCLUSION_CULLER_TILE_WIDTH;
+	int ty0 = tri.minY / OCCLUSION_CULLER_TILE_HEIGHT;
+	int ty1 = (tri.maxY - 1) / OCCLUSION_CULLER_TILE_HEIGHT;
+	for (int ty = ty0; ty <= ty1; ty++)
+		for (int tx = tx0; tx <= tx1; tx++)
+			culler->bins[ty * culler->tilesX + tx].push_back(index);
+}
+
+static void lerpClip(float *r, const float *a, const float *b, float t) {
+	for (int i = 0; i < 4; i++)
+		r[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+CCALL void occlusion_culler_add_occluder(OcclusionCuller *culler, const float *positions, int numVertices, const uint16_t *indices, int numIndices, const float *world) {
+	float matrix[16];
+	if (world)
+		mul4(matrix, culler->viewProj, world);
+	else
+		memcpy(matrix, culler->viewProj, sizeof(matrix));
+
+	std::vector<float> clip(numVertices * 4);
+	for (int i = 0; i < numVertices; i++)
+		transformPoint(&clip[i * 4], matrix, positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+
+	for (int i = 0; i + 2 < numIndices; i += 3) {
+		const float *v[3] = { &clip[indices[i] * 4], &clip[indices[i + 1] * 4], &clip[indices[i + 2] * 4] };
+		culler->stats.occluderTriangles++;
+
+		// clip against the near plane, z + w >= 0
+		float d[3];
+		int inside = 0;
+		for (int k = 0; k < 3; k++) {
+			d[k] = v[k][2] + v[k][3];
+			if (d[k] >= 0.0f) inside++;
+		}
+
+		if (inside == 3) {
+			setupTriangle(culler, v[0], v[1], v[2]);
+			continue;
+		}
+		if (inside == 0)
+			continue;
+
+		float poly[4][4];
+		int count = 0;
+		for (int k = 0; k < 3; k++) {
+			int n = (k + 1) % 3;
+			if (d[k] >= 0.0f)
+				memcpy(poly[count++], v[k], sizeof(float) * 4);
+			if ((d[k] >= 0.0f) != (d[n] >= 0.0f))
+				lerpClip(poly[count++], v[k], v[n], d[k] / (d[k] - d[n]));
+		}
+		for (int k = 1; k + 1 < count; k++)
+			setupTriangle(culler, poly[0], poly[k], poly[k + 1]);
+	}
+}
+
+static void rasterizeTiles(void *userData, int begin, int end) {
+	OcclusionCuller *culler = (OcclusionCuller *) userData;
+	float *depth = &culler->levels[0].depth[0];
+	int width = culler->width;
+
+	const float4 laneOffsets = set(0.5f, 1.5f, 2.5f, 3.5f);
+	const float4 zero4 = zero();
+
+	for (int tile = begin; tile < end; tile++) {
+		int tileX0 = (tile % culler->tilesX) * OCCLUSION_CULLER_TILE_WIDTH;
+		int tileY0 = (tile / culler->tilesX) * OCCLUSION_CULLER_TILE_HEIGHT;
+		int tileX1 = tileX0 + OCCLUSION_CULLER_TILE_WIDTH;
+		int tileY1 = tileY0 + OCCLUSION_CULLER_TILE_HEIGHT;
+
+		const std::vector<uint32_t> &bin = culler->bins[tile];
+		for (size_t t = 0; t < bin.size(); t++) {
+			const RasterTriangle &tri = culler->triangles[bin[t]];
+
+			// tiles are a multiple of 4 wide, so aligning down keeps the quad inside the tile
+			int x0 = (tri.minX > tileX0 ? tri.minX : tileX0) & ~3;
+			int x1 = tri.maxX < tileX1 ? tri.maxX : tileX1;
+			int y0 = tri.minY > tileY0 ? tri.minY : tileY0;
+			int y1 = tri.maxY < tileY1 ? tri.maxY : tileY1;
+
+			float4 a0 = set1(tri.edgeA[0]), a1 = set1(tri.edgeA[1]), a2 = set1(tri.edgeA[2]);
+			float4 za = set1(tri.depthA);
+
+			for (int y = y0; y < y1; y++) {
+				float fy = (float) y + 0.5f;
+				float4 r0 = set1(tri.edgeB[0] * fy + tri.edgeC[0]);
+				float4 r1 = set1(tri.edgeB[1] * fy + tri.edgeC[1]);
+				float4 r2 = set1(tri.edgeB[2] * fy + tri.edgeC[2]);
+				float4 rz = set1(tri.depthB * fy + tri.depthC);
+				float *row = depth + y * width;
+
+				for (int x = x0; x < x1; x += 4) {
+					float4 fx = set1((float) x) + laneOffsets;
+					float4 inside = cmpge(a0 * fx + r0, zero4) & cmpge(a1 * fx + r1, zero4) & cmpge(a2 * fx + r2, zero4);
+					if (!movemask(inside))
+						continue;
+
+					float4 old = load(row + x);
+					float4 z = za * fx + rz;
+					store(row + x, select(inside, max(old, z), old));
+				}
+			}
+		}
+	}
+}
+
+struct DownsampleJob {
+	const DepthLevel *src;
+	DepthLevel *dst;
+};
+
+static void downsampleRows(void *userData, int begin, int end) {
+	DownsampleJob *job = (DownsampleJob *) userData;
+	const DepthLevel &src = *job->src;
+	DepthLevel &dst = *job->dst;
+
+	for (int y = begin; y < end; y++) {
+		int sy0 = y * 2;
+		int sy1 = sy0 + 1 < src.height ? sy0 + 1 : sy0;
+		for (int x = 0; x < dst.width; x++) {
+			int sx0 = x * 2;
+			int sx1 = sx0 + 1 < src.width ? sx0 + 1 : sx0;
+			// keep the farthest occluder depth so that tests against this level stay conservative
+			float d = src.depth[sy0 * src.width + sx0];
+			d = fminf(d, src.depth[sy0 * src.width + sx1]);
+			d = fminf(d, src.depth[sy1 * src.width + sx0]);
+			d = fminf(d, src.depth[sy1 * src.width + sx1]);
+			dst.depth[y * dst.width + x] = d;
+		}
+	}
+}
+
+CCALL void occlusion_culler_rasterize(OcclusionCuller *culler) {
+	std::vector<float> &depth = culler->levels[0].depth;
+	memset(&depth[0], 0, depth.size() * sizeof(float));
+
+	pc::parallel_for((int) culler->bins.size(), 1, rasterizeTiles, culler);
+
+	for (size_t i = 1; i < culler->levels.size(); i++) {
+		DownsampleJob job;
+		job.src = &culler->levels[i - 1];
+		job.dst = &culler->levels[i];
+		pc::parallel_for(job.dst->height, 8, downsampleRows, &job);
+	}
+}
+
+// The box test without the stats, which test_aabbs updates once for all its jobs.
+static int testAabb(const OcclusionCuller *culler, float cx, float cy, float cz, float hx, float hy, float hz) {
+	const float *m = culler->viewProj;
+	float width = (float) culler->width;
+	float height = (float) culler->height;
+	float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+	float nearest = 0.0f;
+
+	for (int i = 0; i < 8; i++) {
+		float clip[4];
+		transformPoint(clip, m, (i & 1) ? cx + hx : cx - hx, (i & 2) ? cy + hy : cy - hy, (i & 4) ? cz + hz : cz - hz);
+
+		// crossing the near plane, assume visible
+		if (clip[2] + clip[3] < 0.0f || clip[3] <= 1e-6f)
+			return 1;
+
+		float iw = 1.0f / clip[3];
+		float sx = (clip[0] * iw * 0.5f + 0.5f) * width;
+		float sy = (0.5f - clip[1] * iw * 0.5f) * height;
+		minX = fminf(minX, sx);
+		maxX = fmaxf(maxX, sx);
+		minY = fminf(minY, sy);
+		maxY = fmaxf(maxY, sy);
+		nearest = fmaxf(nearest, iw);
+	}
+
+	int x0 = minX < 0.0f ? 0 : (int) minX;
+	int y0 = minY < 0.0f ? 0 : (int) minY;
+	int x1 = maxX > width ? culler->width : (int) ceilf(maxX);
+	int y1 = maxY > height ? culler->height : (int) ceilf(maxY);
+
+	// off screen, leave it to the frustum culler
+	if (x0 >= x1 || y0 >= y1)
+		return 1;
+
+	// pick the level where the rectangle spans at most 4x4 texels
+	x1--;
+	y1--;
+	int level = 0;
+	int numLevels = (int) culler->levels.size();
+	while (level + 1 < numLevels && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+		level++;
+
+	const DepthLevel &dl = culler->levels[level];
+	for (int y = y0 >> level; y <= (y1 >> level); y++) {
+		const float *row = &dl.depth[y * dl.width];
+		for (int x = x0 >> level; x <= (x1 >> level); x++) {
+			if (row[x] <= nearest)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+CCALL int occlusion_culler_test_aabb(OcclusionCuller *culler, float cx, float cy, float cz, float hx, float hy, float hz) {
+	int visible = testAabb(culler, cx, cy, cz, hx, hy, hz);
+	culler->stats.occludeesTested++;
+	if (!visible)
+		culler->stats.occludeesCulled++;
+	return visible;
+}
+
+struct TestJob {
+	OcclusionCuller *culler;
+	const float *centers;
+	const float *halfExtents;
+	uint8_t *visible;
+};
+
+static void testBoxes(void *userData, int begin, int end) {
+	TestJob *job = (TestJob *) userData;
+	for (int i = begin; i < end; i++) {
+		const float *c = job->centers + i * 3;
+		const float *h = job->halfExtents + i * 3;
+		job->visible[i] = (uint8_t) testAabb(job->culler, c[0], c[1], c[2], h[0], h[1], h[2]);
+	}
+}
+
+CCALL int occlusion_culler_test_aabbs(OcclusionCuller *culler, const float *centers, const float *halfExtents, uint8_t *visible, int count) {
+	TestJob job;
+	job.culler = culler;
+	job.centers = centers;
+	job.halfExtents = halfExtents;
+	job.visible = visible;
+	pc::parallel_for(count, 64, testBoxes, &job);
+
+	int numVisible = 0;
+	for (int i = 0; i < count; i++)
+		numVisible += visible[i];
+
+	culler->stats.occludeesTested += count;
+	culler->stats.occludeesCulled += count - numVisible;
+	return numVisible;
+}
+
+CCALL int occlusion_culler_get_width(OcclusionCuller *culler, int level) {
+	return culler->levels[level].width;
+}
+
+CCALL int occlusion_culler_get_height(OcclusionCuller *culler, int level) {
+	return culler->levels[level].height;
+}
+
+CCALL int occlusion_culler_get_num_levels(OcclusionCuller *culler) {
+	return (int) culler->levels.size();
+}
+
+CCALL int occlusion_culler_get_depth_image(OcclusionCuller *culler, int level, uint8_t *rgba) {
+	const DepthLevel &dl = culler->levels[level];
+	int count = dl.width * dl.height;
+
+	float nearest = 0.0f;
+	for (int i = 0; i < count; i++)
+		nearest = fmaxf(nearest, dl.depth[i]);
+	float scale = nearest > 0.0f ? 255.0f / nearest : 0.0f;
+
+	for (int i = 0; i < count; i++) {
+		uint8_t v = (uint8_t) (dl.depth[i] * scale);
+		rgba[i * 4] = v;
+		rgba[i * 4 + 1] = v;
+		rgba[i * 4 + 2] = v;
+		rgba[i * 4 + 3] = 255;
+	}
+
+	return count * 4;
+}
+
+CCALL const OcclusionCullerStats *occlusion_culler_get_stats(OcclusionCuller *culler) {
+	return &culler->stats;
+}
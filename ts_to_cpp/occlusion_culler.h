@@ -0,0 +1,70 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+
+/**
+ * Software occlusion culling for the forward renderer.
+ *
+ * Low-poly occluder meshes are rasterized into a small depth buffer using the camera view-projection
+ * matrix (pc.Mat4#data layout). The buffer stores 1/w, so larger values are nearer and a cleared
+ * pixel (0) is infinitely far away. Rasterization is split into screen tiles which are processed in
+ * parallel on the thread pool, 4 pixels at a time.
+ *
+ * After rasterization a hierarchical mip chain keeps the farthest depth of every 2x2 block, and
+ * occludee AABBs are tested against the level where their screen rectangle covers a few texels.
+ *
+ * Per frame usage:
+ *   occlusion_culler_begin_frame(culler, viewProj);
+ *   occlusion_culler_add_occluder(...);       // any number of times
+ *   occlusion_culler_rasterize(culler);
+ *   occlusion_culler_test_aabbs(...);         // any number of times
+ *
+ * Nothing calls the culler yet. pc.ForwardRenderer#cull has no native bridge, so the culler is not
+ * a stage before the draw calls are submitted. It can only be driven directly, as in the sequence
+ * above.
+ */
+
+#define OCCLUSION_CULLER_TILE_WIDTH 32
+#define OCCLUSION_CULLER_TILE_HEIGHT 16
+
+struct OcclusionCullerStats {
+	uint32_t occluderTriangles;   // triangles submitted
+	uint32_t rasterizedTriangles; // triangles that survived clipping and were binned
+	uint32_t occludeesTested;
+	uint32_t occludeesCulled;
+};
+
+struct OcclusionCuller;
+
+// width and height are rounded up to whole tiles
+CCALL OcclusionCuller *occlusion_culler_create(int width, int height);
+CCALL void occlusion_culler_destroy(OcclusionCuller *culler);
+
+CCALL void occlusion_culler_begin_frame(OcclusionCuller *culler, const float *viewProj);
+
+// positions are xyz triplets, indices form a triangle list, world is an optional column-major matrix
+CCALL void occlusion_culler_add_occluder(OcclusionCuller *culler, const float *positions, int numVertices, const uint16_t *indices, int numIndices, const float *world);
+
+CCALL void occlusion_culler_rasterize(OcclusionCuller *culler);
+
+// Returns 1 if the box may be visible, 0 if it is hidden behind occluders. Boxes crossing the near
+// plane are always reported visible.
+CCALL int occlusion_culler_test_aabb(OcclusionCuller *culler, float cx, float cy, float cz, float hx, float hy, float hz);
+// Tests count boxes given as center/halfExtents triplets (pc.BoundingBox layout), writing 1/0 per box.
+// Returns the number of visible boxes.
+CCALL int occlusion_culler_test_aabbs(OcclusionCuller *culler, const float *centers, const float *halfExtents, uint8_t *visible, int count);
+
+CCALL int occlusion_culler_get_width(OcclusionCuller *culler, int level);
+CCALL int occlusion_culler_get_height(OcclusionCuller *culler, int level);
+CCALL int occlusion_culler_get_num_levels(OcclusionCuller *culler);
+
+// Debug view of a depth level as RGBA8, top row first, nearer is brighter. rgba must hold
+// width * height * 4 bytes of that level. Returns the number of bytes written.
+CCALL int occlusion_culler_get_depth_image(OcclusionCuller *culler, int level, uint8_t *rgba);
+
+CCALL const OcclusionCullerStats *occlusion_culler_get_stats(OcclusionCuller *culler);
+
+#endif
@@ -0,0 +1,107 @@
+#include "radix_sort.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+// Returns false when more than maxMoves pairs were moved. The pairs are then left partly sorted,
+// with equal keys still in input order, for the radix sort to finish.
+static bool insertionSort(uint64_t *keys, uint32_t *values, int count, int maxMoves) {
+	int moves = 0;
+	for (int i = 1; i < count; i++) {
+		uint64_t key = keys[i];
+		uint32_t value = values[i];
+		int j = i - 1;
+		while (j >= 0 && keys[j] > key) {
+			keys[j + 1] = keys[j];
+			values[j + 1] = values[j];
+			j--;
+		}
+		keys[j + 1] = key;
+		values[j + 1] = value;
+
+		moves += i - 1 - j;
+		if (moves > maxMoves)
+			return false;
+	}
+	return true;
+}
+
+CCALL void radix_sort_pairs(uint64_t *keys, uint32_t *values, int count, uint64_t *tempKeys, uint32_t *tempValues, RadixSortStats *stats) {
+	if (stats)
+		stats->sorts++;
+	if (count < 2)
+		return;
+
+	// histograms of every pass, and the number of keys smaller than the one before them
+	uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS];
+	memset(histograms, 0, sizeof(histograms));
+	int descents = 0;
+	uint64_t previous = keys[0];
+	for (int i = 0; i < count; i++) {
+		uint64_t key = keys[i];
+		if (key < previous)
+			descents++;
+		previous = key;
+		for (int pass = 0; pass < RADIX_PASSES; pass++)
+			histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+	}
+
+	if (descents == 0) {
+		if (stats)
+			stats->presorted++;
+		return;
+	}
+	if (count <= RADIX_SORT_MAX_INSERTION_COUNT || descents <= RADIX_SORT_MAX_DESCENTS) {
+		int maxMoves = count <= RADIX_SORT_MAX_INSERTION_COUNT ? count * count : count * RADIX_SORT_MAX_INSERTION_MOVES;
+		if (insertionSort(keys, values, count, maxMoves)) {
+			if (stats)
+				stats->insertion++;
+			return;
+		}
+	}
+
+	uint64_t *srcKeys = keys, *dstKeys = tempKeys;
+	uint32_t *srcValues = values, *dstValues = tempValues;
+	for (int pass = 0; pass < RADIX_PASSES; pass++) {
+		uint32_t *histogram = histograms[pass];
+		int shift = pass * RADIX_BITS;
+
+		// every key has the same digit, the pass would not move anything
+		if (histogram[(srcKeys[0] >> shift) & (RADIX_BUCKETS - 1)] == (uint32_t)count) {
+			if (stats)
+				stats->skippedPasses++;
+			continue;
+		}
+
+		// bucket counts to start offsets
+		uint32_t offset = 0;
+		for (int b = 0; b < RADIX_BUCKETS; b++) {
+			uint32_t n = histogram[b];
+			histogram[b] = offset;
+			offset += n;
+		}
+
+		for (int i = 0; i < count; i++) {
+			uint64_t key = srcKeys[i];
+			uint32_t slot = histogram[(key >> shift) & (RADIX_BUCKETS - 1)]++;
+			dstKeys[slot] = key;
+			dstValues[slot] = srcValues[i];
+		}
+
+		uint64_t *swapKeys = srcKeys;
+		srcKeys = dstKeys;
+		dstKeys = swapKeys;
+		uint32_t *swapValues = srcValues;
+		srcValues = dstValues;
+		dstValues = swapValues;
+		if (stats)
+			stats->passes++;
+	}
+
+	// an odd number of passes leaves the result in the temporary arrays
+	if (srcKeys != keys) {
+		memcpy(keys, srcKeys, sizeof(uint64_t) * count);
+		memcpy(values, srcValues, sizeof(uint32_t) * count);
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * LSD radix sort of (key, value) pairs with 64 bit keys, used to order draw calls.
+ *
+ * Every draw call gets one key that packs everything the comparators of pc.Layer#_sortVisible and
+ * pc.ForwardRenderer#depthSortCompare look at, so sorting never calls back into the draw calls. The
+ * value is the index of the draw call in the unsorted list.
+ *
+ * The sort makes 8 passes of 8 bits. The histograms of all passes are built in a single read of
+ * the keys, and passes where every key has the same digit (e.g. the mesh id bits of a back to
+ * front sort) are skipped. The sort is stable, so pairs with equal keys keep their input order.
+ *
+ * Keys that are already sorted, or nearly so, are common from frame to frame when the input is
+ * last frame's order. These are detected while building the histograms and finished with an
+ * insertion sort instead.
+ */
+
+// Key layout of the built in sort modes, most significant bits first:
+//
+//   SORTMODE_MATERIALMESH  32 bits inverted forward key (layer, blend, command, material id),
+//                          32 bits inverted mesh id
+//   SORTMODE_BACK2FRONT    32 bits inverted depth, 32 bits zero
+//   SORTMODE_FRONT2BACK    32 bits depth, 32 bits zero
+//   SORTMODE_MANUAL        32 bits draw order, 32 bits zero
+//   shadow casters         32 bits inverted depth key (skinning, opacity channel),
+//                          32 bits inverted mesh id
+//
+// Inverting a field reverses its order, the comparators sort forward keys and mesh ids descending.
+
+// Insertion sort is used for at most this many pairs, or when at most this many keys are smaller
+// than the key before them.
+#define RADIX_SORT_MAX_INSERTION_COUNT 64
+#define RADIX_SORT_MAX_DESCENTS 16
+
+// A few descents can still need many moves (e.g. a block of keys that moved to the other end of
+// the input), so the insertion sort of more pairs gives up on the radix sort after this many moves
+// per pair.
+#define RADIX_SORT_MAX_INSERTION_MOVES 8
+
+// Maps a float to an unsigned integer with the same order, -0 sorts before +0.
+static inline uint32_t radix_sort_float_key(float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static inline uint64_t radix_sort_make_key(uint32_t high, uint32_t low) {
+	return ((uint64_t)high << 32) | low;
+}
+
+struct RadixSortStats {
+	int sorts;
+	int presorted;  // inputs that were already in order
+	int insertion;  // inputs finished with an insertion sort
+	int passes;     // radix passes made
+	int skippedPasses;
+};
+
+// Sorts count pairs ascending by key. tempKeys and tempValues hold count entries each, the result
+// is in keys and values. stats may be null, otherwise the sort adds to it.
+CCALL void radix_sort_pairs(uint64_t *keys, uint32_t *values, int count, uint64_t *tempKeys, uint32_t *tempValues, RadixSortStats *stats);
+
+#endif
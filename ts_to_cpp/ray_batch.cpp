@@ -0,0 +1,160 @@
+#include "ray_batch.h"
+#include "simd_float4.h"
+
+#include <math.h>
+
+using namespace pc::simd;
+
+// Loads lanes j..j+3 of one SoA component. The tail of a batch repeats its last item, only the
+// valid lanes are written back.
+static inline float4 gather(const float *component, int j, int lanes) {
+	if (lanes == 4)
+		return load(component + j);
+	float tmp[4];
+	for (int i = 0; i < 4; i++)
+		tmp[i] = component[j + (i < lanes ? i : lanes - 1)];
+	return load(tmp);
+}
+
+// Either one item broadcast to every lane, or four consecutive items of a batch.
+struct Lanes {
+	const float *data;
+	int count;
+	bool broadcast;
+
+	float4 get(int component, int j, int lanes) const {
+		if (broadcast)
+			return set1(data[component]);
+		return gather(data + component * count, j, lanes);
+	}
+};
+
+static int writeResults(float4 hit, float4 distance, int j, int lanes, uint8_t *hits, float *distances) {
+	float tmp[4];
+	store(tmp, select(hit, distance, set1(INFINITY)));
+	int mask = movemask(hit);
+	int numHits = 0;
+	for (int i = 0; i < lanes; i++) {
+		uint8_t h = (uint8_t) ((mask >> i) & 1);
+		hits[j + i] = h;
+		distances[j + i] = tmp[i];
+		numHits += h;
+	}
+	return numHits;
+}
+
+static int raysVsSpheres(const Lanes &rays, const Lanes &spheres, int count, uint8_t *hits, float *distances) {
+	const float4 zero4 = zero();
+	int numHits = 0;
+
+	for (int j = 0; j < count; j += 4) {
+		int lanes = count - j < 4 ? count - j : 4;
+
+		float4 mx = rays.get(0, j, lanes) - spheres.get(0, j, lanes);
+		float4 my = rays.get(1, j, lanes) - spheres.get(1, j, lanes);
+		float4 mz = rays.get(2, j, lanes) - spheres.get(2, j, lanes);
+		float4 dx = rays.get(3, j, lanes);
+		float4 dy = rays.get(4, j, lanes);
+		float4 dz = rays.get(5, j, lanes);
+		float4 r = spheres.get(3, j, lanes);
+
+		float4 b = mx * dx + my * dy + mz * dz;
+		float4 c = mx * mx + my * my + mz * mz - r * r;
+		float4 discr = b * b - c;
+
+		// a miss when the origin is outside and pointing away, or the ray passes the sphere
+		float4 miss = (cmpgt(c, zero4) & cmpgt(b, zero4)) | cmplt(discr, zero4);
+		float4 hit = cmpeq(miss, zero4);
+
+		// nearest intersection, clamped to zero when the ray starts inside the sphere
+		float4 t = max(zero4 - b - sqrt(max(discr, zero4)), zero4);
+
+		numHits += writeResults(hit, t, j, lanes, hits, distances);
+	}
+
+	return numHits;
+}
+
+static inline float4 nonZero(float4 d) {
+	// avoid 0 * inf in the slab test, a tiny direction behaves like a parallel one
+	return select(cmpeq(d, zero()), set1(1e-30f), d);
+}
+
+static int raysVsBoxes(const Lanes &rays, const Lanes &boxes, int count, uint8_t *hits, float *distances) {
+	const float4 zero4 = zero();
+	int numHits = 0;
+
+	for (int j = 0; j < count; j += 4) {
+		int lanes = count - j < 4 ? count - j : 4;
+
+		float4 m[12];
+		for (int k = 0; k < 12; k++)
+			m[k] = boxes.get(k, j, lanes);
+
+		float4 ox = rays.get(0, j, lanes);
+		float4 oy = rays.get(1, j, lanes);
+		float4 oz = rays.get(2, j, lanes);
+		float4 dx = rays.get(3, j, lanes);
+		float4 dy = rays.get(4, j, lanes);
+		float4 dz = rays.get(5, j, lanes);
+
+		// ray into box space, same as pc.OrientedBox#intersectsRay but without the shared scratch ray
+		float4 o[3], d[3];
+		o[0] = m[0] * ox + m[3] * oy + m[6] * oz + m[9];
+		o[1] = m[1] * ox + m[4] * oy + m[7] * oz + m[10];
+		o[2] = m[2] * ox + m[5] * oy + m[8] * oz + m[11];
+		d[0] = nonZero(m[0] * dx + m[3] * dy + m[6] * dz);
+		d[1] = nonZero(m[1] * dx + m[4] * dy + m[7] * dz);
+		d[2] = nonZero(m[2] * dx + m[5] * dy + m[8] * dz);
+
+		float4 tNear = set1(-INFINITY);
+		float4 tFar = set1(INFINITY);
+		for (int axis = 0; axis < 3; axis++) {
+			float4 h = boxes.get(12 + axis, j, lanes);
+			float4 inv = set1(1.0f) / d[axis];
+			float4 t1 = (zero4 - h - o[axis]) * inv;
+			float4 t2 = (h - o[axis]) * inv;
+			tNear = max(tNear, min(t1, t2));
+			tFar = min(tFar, max(t1, t2));
+		}
+
+		float4 t = max(tNear, zero4);
+		float4 hit = cmpge(tFar, t);
+
+		numHits += writeResults(hit, t, j, lanes, hits, distances);
+	}
+
+	return numHits;
+}
+
+static Lanes single(const float *data) {
+	Lanes l;
+	l.data = data;
+	l.count = 1;
+	l.broadcast = true;
+	return l;
+}
+
+static Lanes batch(const float *data, int count) {
+	Lanes l;
+	l.data = data;
+	l.count = count;
+	l.broadcast = false;
+	return l;
+}
+
+CCALL int ray_batch_ray_vs_spheres(const float *ray, const float *spheres, int count, uint8_t *hits, float *distances) {
+	return raysVsSpheres(single(ray), batch(spheres, count), count, hits, distances);
+}
+
+CCALL int ray_batch_ray_vs_boxes(const float *ray, const float *boxes, int count, uint8_t *hits, float *distances) {
+	return raysVsBoxes(single(ray), batch(boxes, count), count, hits, distances);
+}
+
+CCALL int ray_batch_rays_vs_sphere(const float *rays, int count, const float *sphere, uint8_t *hits, float *distances) {
+	return raysVsSpheres(batch(rays, count), single(sphere), count, hits, distances);
+}
+
+CCALL int ray_batch_rays_vs_box(const float *rays, int count, const float *box, uint8_t *hits, float *distances) {
+	return raysVsBoxes(batch(rays, count), single(box), count, hits, distances);
+}
@@ -0,0 +1,33 @@
+#ifndef RAY_BATCH_H
+#define RAY_BATCH_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+
+/**
+ * Batch ray intersection kernels, the native counterpart of pc.BoundingSphere#intersectsRay and
+ * pc.OrientedBox#intersectsRay for large numbers of shapes or rays.
+ *
+ * All inputs are SoA: component k of item j lives at data[k * count + j].
+ *
+ *   rays     6 components: origin x, y, z, direction x, y, z (direction must be normalized)
+ *   spheres  4 components: center x, y, z, radius
+ *   boxes   15 components: the first 12 are the model transform (the inverse of the world
+ *            transform, unit scale) as pc.Mat4#data indices 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+ *            followed by half extents x, y, z
+ *
+ * A single ray or shape uses the same layout with count 1. For every item hits receives 1 or 0 and
+ * distances the distance along the ray to the first intersection, 0 when the origin is inside and
+ * INFINITY on a miss. The functions return the number of hits.
+ *
+ * The kernels keep no state between calls, so they can run on several threads at once.
+ */
+
+CCALL int ray_batch_ray_vs_spheres(const float *ray, const float *spheres, int count, uint8_t *hits, float *distances);
+CCALL int ray_batch_ray_vs_boxes(const float *ray, const float *boxes, int count, uint8_t *hits, float *distances);
+
+CCALL int ray_batch_rays_vs_sphere(const float *rays, int count, const float *sphere, uint8_t *hits, float *distances);
+CCALL int ray_batch_rays_vs_box(const float *rays, int count, const float *box, uint8_t *hits, float *distances);
+
+#endif
@@ -0,0 +1,200 @@
+#include "shadow_casters.h"
+#include "native_math.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+#include <float.h>
+#include <math.h>
+#include <mutex>
+#include <string.h>
+
+#define SHADOW_CASTERS_GRAIN 256
+
+using namespace pc::simd;
+
+static inline void boundsReset(float *bounds) {
+	bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+	bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+}
+
+CCALL ShadowCasterCuller *shadow_casters_create() {
+	ShadowCasterCuller *culler = new ShadowCasterCuller();
+	culler->numViews = 0;
+	culler->offsets.assign(1, 0);
+	memset(&culler->stats, 0, sizeof(culler->stats));
+	return culler;
+}
+
+CCALL void shadow_casters_destroy(ShadowCasterCuller *culler) {
+	delete culler;
+}
+
+CCALL void shadow_casters_set_num_views(ShadowCasterCuller *culler, int numViews) {
+	culler->numViews = numViews < SHADOW_CASTERS_MAX_VIEWS ? numViews : SHADOW_CASTERS_MAX_VIEWS;
+}
+
+static void setPlane(ShadowCasterView &view, int p, float a, float b, float c, float d) {
+	float t = sqrtf(a * a + b * b + c * c);
+	view.nx[p] = a / t;
+	view.ny[p] = b / t;
+	view.nz[p] = c / t;
+	view.d[p] = d / t;
+}
+
+CCALL void shadow_casters_set_view(ShadowCasterCuller *culler, int index, const float *vpm, const float *lightView, int planeMask) {
+	ShadowCasterView &view = culler->views[index];
+
+	// RIGHT, LEFT, BOTTOM, TOP, FAR, NEAR - keep in sync with pc.Frustum#update
+	setPlane(view, 0, vpm[3] - vpm[0], vpm[7] - vpm[4], vpm[11] - vpm[8], vpm[15] - vpm[12]);
+	setPlane(view, 1, vpm[3] + vpm[0], vpm[7] + vpm[4], vpm[11] + vpm[8], vpm[15] + vpm[12]);
+	setPlane(view, 2, vpm[3] + vpm[1], vpm[7] + vpm[5], vpm[11] + vpm[9], vpm[15] + vpm[13]);
+	setPlane(view, 3, vpm[3] - vpm[1], vpm[7] - vpm[5], vpm[11] - vpm[9], vpm[15] - vpm[13]);
+	setPlane(view, 4, vpm[3] - vpm[2], vpm[7] - vpm[6], vpm[11] - vpm[10], vpm[15] - vpm[14]);
+	setPlane(view, 5, vpm[3] + vpm[2], vpm[7] + vpm[6], vpm[11] + vpm[10], vpm[15] + vpm[14]);
+
+	for (int p = 0; p < 8; p++) {
+		// a plane with no normal and a positive distance contains everything
+		if (p >= 6 || !(planeMask & (1 << p))) {
+			view.nx[p] = view.ny[p] = view.nz[p] = 0.0f;
+			view.d[p] = 1.0f;
+		}
+		view.ax[p] = fabsf(view.nx[p]);
+		view.ay[p] = fabsf(view.ny[p]);
+		view.az[p] = fabsf(view.nz[p]);
+	}
+
+	memcpy(view.lightView, lightView, sizeof(view.lightView));
+	boundsReset(view.bounds);
+}
+
+// four planes at once: a box is outside a plane when its center lies further behind it than the
+// projection of its half extents on the normal
+static inline int outsidePlanes(const ShadowCasterView &view, int first, float4 cx, float4 cy, float4 cz, float4 hx, float4 hy, float4 hz) {
+	float4 distance = load(view.nx + first) * cx + load(view.ny + first) * cy + load(view.nz + first) * cz + load(view.d + first);
+	float4 radius = load(view.ax + first) * hx + load(view.ay + first) * hy + load(view.az + first) * hz;
+	return movemask(cmplt(distance + radius, zero()));
+}
+
+// light space box of a world space box, added to bounds
+static inline void addLightSpaceBox(float *bounds, const float *m, const float *aabb) {
+	float center[3];
+	pc::native::mat4TransformPoint(m, aabb, center);
+	for (int r = 0; r < 3; r++) {
+		float half = fabsf(m[r]) * aabb[3] + fabsf(m[4 + r]) * aabb[4] + fabsf(m[8 + r]) * aabb[5];
+		float lo = center[r] - half, hi = center[r] + half;
+		bounds[r] = lo < bounds[r] ? lo : bounds[r];
+		bounds[r + 3] = hi > bounds[r + 3] ? hi : bounds[r + 3];
+	}
+}
+
+struct CullJob {
+	ShadowCasterCuller *culler;
+	const float *aabbs;
+	const uint8_t *cull;
+	std::mutex lock;
+};
+
+static void cullCasters(void *userData, int begin, int end) {
+	CullJob *job = (CullJob *) userData;
+	ShadowCasterCuller *culler = job->culler;
+	int numViews = culler->numViews;
+	uint32_t allViews = numViews == 32 ? 0xffffffffu : ((1u << numViews) - 1);
+
+	float bounds[SHADOW_CASTERS_MAX_VIEWS][6];
+	for (int v = 0; v < numViews; v++)
+		boundsReset(bounds[v]);
+
+	for (int i = begin; i < end; i++) {
+		const float *aabb = job->aabbs + i * 6;
+		uint32_t visibility = 0;
+
+		if (job->cull && !job->cull[i]) {
+			visibility = allViews;
+		} else {
+			float4 cx = set1(aabb[0]), cy = set1(aabb[1]), cz = set1(aabb[2]);
+			float4 hx = set1(aabb[3]), hy = set1(aabb[4]), hz = set1(aabb[5]);
+			for (int v = 0; v < numViews; v++) {
+				const ShadowCasterView &view = culler->views[v];
+				if (outsidePlanes(view, 0, cx, cy, cz, hx, hy, hz) || outsidePlanes(view, 4, cx, cy, cz, hx, hy, hz))
+					continue;
+				visibility |= 1u << v;
+			}
+		}
+
+		culler->visibility[i] = visibility;
+		for (int v = 0; v < numViews; v++) {
+			if (visibility & (1u << v))
+				addLightSpaceBox(bounds[v], culler->views[v].lightView, aabb);
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(job->lock);
+	for (int v = 0; v < numViews; v++) {
+		float *viewBounds = culler->views[v].bounds;
+		for (int k = 0; k < 3; k++) {
+			viewBounds[k] = bounds[v][k] < viewBounds[k] ? bounds[v][k] : viewBounds[k];
+			viewBounds[k + 3] = bounds[v][k + 3] > viewBounds[k + 3] ? bounds[v][k + 3] : viewBounds[k + 3];
+		}
+	}
+}
+
+CCALL int shadow_casters_cull(ShadowCasterCuller *culler, const float *aabbs, const uint8_t *cull, int count) {
+	int numViews = culler->numViews;
+	for (int v = 0; v < numViews; v++)
+		boundsReset(culler->views[v].bounds);
+	culler->visibility.resize(count);
+
+	CullJob job;
+	job.culler = culler;
+	job.aabbs = aabbs;
+	job.cull = cull;
+	pc::parallel_for(count, SHADOW_CASTERS_GRAIN, cullCasters, &job);
+
+	// lists per view, casters stay in index order
+	std::vector<uint32_t> &offsets = culler->offsets;
+	offsets.assign(numViews + 1, 0);
+	int visible = 0;
+	for (int i = 0; i < count; i++) {
+		uint32_t visibility = culler->visibility[i];
+		visible += visibility != 0;
+		for (int v = 0; visibility; v++, visibility >>= 1)
+			offsets[v + 1] += visibility & 1;
+	}
+	for (int v = 0; v < numViews; v++)
+		offsets[v + 1] += offsets[v];
+
+	int entries = offsets[numViews];
+	culler->indices.resize(entries);
+	uint32_t cursor[SHADOW_CASTERS_MAX_VIEWS];
+	memcpy(cursor, offsets.data(), sizeof(uint32_t) * numViews);
+	for (int i = 0; i < count; i++) {
+		uint32_t visibility = culler->visibility[i];
+		for (int v = 0; visibility; v++, visibility >>= 1) {
+			if (visibility & 1)
+				culler->indices[cursor[v]++] = (uint32_t) i;
+		}
+	}
+
+	culler->stats.casters = count;
+	culler->stats.views = numViews;
+	culler->stats.visible = visible;
+	culler->stats.entries = entries;
+	return entries;
+}
+
+CCALL const uint32_t *shadow_casters_get_list(ShadowCasterCuller *culler, int view, int *count) {
+	*count = (int) (culler->offsets[view + 1] - culler->offsets[view]);
+	return culler->indices.data() + culler->offsets[view];
+}
+
+CCALL const float *shadow_casters_get_bounds(ShadowCasterCuller *culler, int view) {
+	return culler->views[view].bounds;
+}
+
+CCALL const uint32_t *shadow_casters_get_visibility(ShadowCasterCuller *culler) {
+	return culler->visibility.data();
+}
+
+CCALL ShadowCasterStats *shadow_casters_get_stats(ShadowCasterCuller *culler) {
+	return &culler->stats;
+}
@@ -0,0 +1,81 @@
+#ifndef SHADOW_CASTERS_H
+#define SHADOW_CASTERS_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Shadow caster culling for all shadow views of a frame at once.
+ *
+ * pc.ForwardRenderer#cullDirectionalShadowmap and #cullLocalShadowmap walk every caster once per
+ * cascade or cube face. Here the caster aabbs are read once and each is tested against the frusta
+ * of every view: all cascades of all directional lights, spot lights and the six faces of point
+ * lights. The planes of a view are tested four at a time. The result is one list of caster indices
+ * per view, and for every view the bounds of its casters in the view's light space, built from the
+ * transformed caster boxes rather than from one world space box around all of them, which gives a
+ * tighter near and far range for directional cascades.
+ *
+ * Casters are split between the threads of the pool.
+ */
+
+// views are tracked in a 32 bit mask per caster
+#define SHADOW_CASTERS_MAX_VIEWS 32
+
+// Planes in the order of pc.Frustum and frustum_culler_update: right, left, bottom, top, far, near.
+#define SHADOW_CASTERS_ALL_PLANES 0x3f
+// Directional lights keep casters between the light and the cascade, so they skip the near plane.
+#define SHADOW_CASTERS_NO_NEAR_PLANE 0x1f
+
+struct ShadowCasterView {
+	// planes 0-3 and 4-7 in SoA form, for four planes per test; unused planes never reject
+	float nx[8], ny[8], nz[8], d[8];
+	float ax[8], ay[8], az[8]; // absolute normals
+	float lightView[16];
+	float bounds[6];           // light space min xyz, max xyz of the casters, min > max when empty
+};
+
+struct ShadowCasterStats {
+	int casters;
+	int views;
+	int visible;  // casters visible in at least one view
+	int entries;  // entries of all view lists
+};
+
+struct ShadowCasterCuller {
+	int numViews;
+	ShadowCasterView views[SHADOW_CASTERS_MAX_VIEWS];
+
+	std::vector<uint32_t> visibility; // mask of the views each caster is visible in
+	std::vector<uint32_t> offsets;    // numViews + 1, the list of view i is [offsets[i], offsets[i + 1])
+	std::vector<uint32_t> indices;
+
+	ShadowCasterStats stats;
+};
+
+CCALL ShadowCasterCuller *shadow_casters_create();
+CCALL void shadow_casters_destroy(ShadowCasterCuller *culler);
+
+// Sets the number of views, at most SHADOW_CASTERS_MAX_VIEWS.
+CCALL void shadow_casters_set_num_views(ShadowCasterCuller *culler, int numViews);
+// viewProj is the view-projection matrix of the shadow camera, lightView its view matrix, both
+// column-major (pc.Mat4#data). planeMask selects the planes that can reject casters.
+CCALL void shadow_casters_set_view(ShadowCasterCuller *culler, int view, const float *viewProj, const float *lightView, int planeMask);
+
+// Culls count casters. aabbs holds a world space center and half extents per caster
+// (pc.BoundingBox#center, pc.BoundingBox#halfExtents). cull may be null, otherwise a caster whose
+// entry is 0 is visible in every view, like a pc.MeshInstance with cull set to false. Returns the
+// number of entries of all view lists.
+CCALL int shadow_casters_cull(ShadowCasterCuller *culler, const float *aabbs, const uint8_t *cull, int count);
+
+// Caster indices visible in a view, in ascending order, their number in *count.
+CCALL const uint32_t *shadow_casters_get_list(ShadowCasterCuller *culler, int view, int *count);
+// Light space bounds of the casters of a view, min xyz and max xyz.
+CCALL const float *shadow_casters_get_bounds(ShadowCasterCuller *culler, int view);
+// One mask of views per caster.
+CCALL const uint32_t *shadow_casters_get_visibility(ShadowCasterCuller *culler);
+
+CCALL ShadowCasterStats *shadow_casters_get_stats(ShadowCasterCuller *culler);
+
+#endif
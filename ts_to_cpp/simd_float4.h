@@ -0,0 +1,180 @@
+#ifndef SIMD_FLOAT4_H
+#define SIMD_FLOAT4_H
+
+/**
+ * Minimal 4-wide float vector used by the native kernels.
+ *
+ * SSE is used on x86 builds and wasm simd128 intrinsics on wasm builds made with -msimd128.
+ * Everything else falls back to plain scalar code with identical results.
+ */
+
+#if defined(__wasm_simd128__)
+	#define PC_SIMD_WASM 1
+	#define PC_SIMD_SSE 0
+	#include <wasm_simd128.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define PC_SIMD_WASM 0
+	#define PC_SIMD_SSE 1
+	#include <xmmintrin.h>
+#else
+	#define PC_SIMD_WASM 0
+	#define PC_SIMD_SSE 0
+	#include <math.h>
+#endif
+
+namespace pc {
+namespace simd {
+
+#if PC_SIMD_WASM
+
+	struct float4 {
+		v128_t v;
+	};
+
+	static inline float4 load(const float *p) { float4 r; r.v = wasm_v128_load(p); return r; }
+	static inline void store(float *p, float4 a) { wasm_v128_store(p, a.v); }
+	static inline float4 set1(float s) { float4 r; r.v = wasm_f32x4_splat(s); return r; }
+	static inline float4 set(float x, float y, float z, float w) { float4 r; r.v = wasm_f32x4_make(x, y, z, w); return r; }
+	static inline float4 zero() { float4 r; r.v = wasm_f32x4_splat(0.0f); return r; }
+
+	static inline float4 operator+(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_add(a.v, b.v); return r; }
+	static inline float4 operator-(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_sub(a.v, b.v); return r; }
+	static inline float4 operator*(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_mul(a.v, b.v); return r; }
+	static inline float4 operator/(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_div(a.v, b.v); return r; }
+	// pmin and pmax pick like the scalar code (b < a ? b : a), unlike the NaN propagating min and max
+	static inline float4 min(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_pmin(a.v, b.v); return r; }
+	static inline float4 max(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_pmax(a.v, b.v); return r; }
+	static inline float4 sqrt(float4 a) { float4 r; r.v = wasm_f32x4_sqrt(a.v); return r; }
+
+	// comparisons return all-bits masks per lane
+	static inline float4 cmpeq(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_eq(a.v, b.v); return r; }
+	static inline float4 cmpge(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_ge(a.v, b.v); return r; }
+	static inline float4 cmpgt(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_gt(a.v, b.v); return r; }
+	static inline float4 cmple(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_le(a.v, b.v); return r; }
+	static inline float4 cmplt(float4 a, float4 b) { float4 r; r.v = wasm_f32x4_lt(a.v, b.v); return r; }
+	static inline float4 operator&(float4 a, float4 b) { float4 r; r.v = wasm_v128_and(a.v, b.v); return r; }
+	static inline float4 operator|(float4 a, float4 b) { float4 r; r.v = wasm_v128_or(a.v, b.v); return r; }
+
+	// mask ? a : b
+	static inline float4 select(float4 mask, float4 a, float4 b) { float4 r; r.v = wasm_v128_bitselect(a.v, b.v, mask.v); return r; }
+
+	// one bit per lane, lane 0 in bit 0
+	static inline int movemask(float4 mask) { return (int) wasm_i32x4_bitmask(mask.v); }
+
+	// rows to columns, e.g. 4 quaternions to their x, y, z and w
+	static inline void transpose(float4 &a, float4 &b, float4 &c, float4 &d) {
+		v128_t t0 = wasm_i32x4_shuffle(a.v, b.v, 0, 4, 1, 5);
+		v128_t t1 = wasm_i32x4_shuffle(c.v, d.v, 0, 4, 1, 5);
+		v128_t t2 = wasm_i32x4_shuffle(a.v, b.v, 2, 6, 3, 7);
+		v128_t t3 = wasm_i32x4_shuffle(c.v, d.v, 2, 6, 3, 7);
+		a.v = wasm_i32x4_shuffle(t0, t1, 0, 1, 4, 5);
+		b.v = wasm_i32x4_shuffle(t0, t1, 2, 3, 6, 7);
+		c.v = wasm_i32x4_shuffle(t2, t3, 0, 1, 4, 5);
+		d.v = wasm_i32x4_shuffle(t2, t3, 2, 3, 6, 7);
+	}
+
+#elif PC_SIMD_SSE
+
+	struct float4 {
+		__m128 v;
+	};
+
+	static inline float4 load(const float *p) { float4 r; r.v = _mm_loadu_ps(p); return r; }
+	static inline void store(float *p, float4 a) { _mm_storeu_ps(p, a.v); }
+	static inline float4 set1(float s) { float4 r; r.v = _mm_set1_ps(s); return r; }
+	static inline float4 set(float x, float y, float z, float w) { float4 r; r.v = _mm_setr_ps(x, y, z, w); return r; }
+	static inline float4 zero() { float4 r; r.v = _mm_setzero_ps(); return r; }
+
+	static inline float4 operator+(float4 a, float4 b) { float4 r; r.v = _mm_add_ps(a.v, b.v); return r; }
+	static inline float4 operator-(float4 a, float4 b) { float4 r; r.v = _mm_sub_ps(a.v, b.v); return r; }
+	static inline float4 operator*(float4 a, float4 b) { float4 r; r.v = _mm_mul_ps(a.v, b.v); return r; }
+	static inline float4 operator/(float4 a, float4 b) { float4 r; r.v = _mm_div_ps(a.v, b.v); return r; }
+	static inline float4 min(float4 a, float4 b) { float4 r; r.v = _mm_min_ps(a.v, b.v); return r; }
+	static inline float4 max(float4 a, float4 b) { float4 r; r.v = _mm_max_ps(a.v, b.v); return r; }
+	static inline float4 sqrt(float4 a) { float4 r; r.v = _mm_sqrt_ps(a.v); return r; }
+
+	// comparisons return all-bits masks per lane
+	static inline float4 cmpeq(float4 a, float4 b) { float4 r; r.v = _mm_cmpeq_ps(a.v, b.v); return r; }
+	static inline float4 cmpge(float4 a, float4 b) { float4 r; r.v = _mm_cmpge_ps(a.v, b.v); return r; }
+	static inline float4 cmpgt(float4 a, float4 b) { float4 r; r.v = _mm_cmpgt_ps(a.v, b.v); return r; }
+	static inline float4 cmple(float4 a, float4 b) { float4 r; r.v = _mm_cmple_ps(a.v, b.v); return r; }
+	static inline float4 cmplt(float4 a, float4 b) { float4 r; r.v = _mm_cmplt_ps(a.v, b.v); return r; }
+	static inline float4 operator&(float4 a, float4 b) { float4 r; r.v = _mm_and_ps(a.v, b.v); return r; }
+	static inline float4 operator|(float4 a, float4 b) { float4 r; r.v = _mm_or_ps(a.v, b.v); return r; }
+
+	// mask ? a : b
+	static inline float4 select(float4 mask, float4 a, float4 b) {
+		float4 r;
+		r.v = _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+		return r;
+	}
+
+	// one bit per lane, lane 0 in bit 0
+	static inline int movemask(float4 mask) { return _mm_movemask_ps(mask.v); }
+
+	// rows to columns, e.g. 4 quaternions to their x, y, z and w
+	static inline void transpose(float4 &a, float4 &b, float4 &c, float4 &d) { _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v); }
+
+#else
+
+	struct float4 {
+		float v[4];
+	};
+
+	#define PC_SIMD_LANES(expr) float4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r
+
+	static inline float bitsToFloat(unsigned int bits) { union { unsigned int u; float f; } c; c.u = bits; return c.f; }
+	static inline unsigned int floatToBits(float f) { union { unsigned int u; float f; } c; c.f = f; return c.u; }
+	static inline float maskLane(bool b) { return bitsToFloat(b ? 0xffffffffu : 0u); }
+
+	static inline float4 load(const float *p) { PC_SIMD_LANES(p[i]); }
+	static inline void store(float *p, float4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+	static inline float4 set1(float s) { PC_SIMD_LANES(s); }
+	static inline float4 set(float x, float y, float z, float w) { float4 r; r.v[0] = x; r.v[1] = y; r.v[2] = z; r.v[3] = w; return r; }
+	static inline float4 zero() { PC_SIMD_LANES(0.0f); }
+
+	static inline float4 operator+(float4 a, float4 b) { PC_SIMD_LANES(a.v[i] + b.v[i]); }
+	static inline float4 operator-(float4 a, float4 b) { PC_SIMD_LANES(a.v[i] - b.v[i]); }
+	static inline float4 operator*(float4 a, float4 b) { PC_SIMD_LANES(a.v[i] * b.v[i]); }
+	static inline float4 operator/(float4 a, float4 b) { PC_SIMD_LANES(a.v[i] / b.v[i]); }
+	static inline float4 min(float4 a, float4 b) { PC_SIMD_LANES(b.v[i] < a.v[i] ? b.v[i] : a.v[i]); }
+	static inline float4 max(float4 a, float4 b) { PC_SIMD_LANES(b.v[i] > a.v[i] ? b.v[i] : a.v[i]); }
+	static inline float4 sqrt(float4 a) { PC_SIMD_LANES(sqrtf(a.v[i])); }
+
+	static inline float4 cmpeq(float4 a, float4 b) { PC_SIMD_LANES(maskLane(a.v[i] == b.v[i])); }
+	static inline float4 cmpge(float4 a, float4 b) { PC_SIMD_LANES(maskLane(a.v[i] >= b.v[i])); }
+	static inline float4 cmpgt(float4 a, float4 b) { PC_SIMD_LANES(maskLane(a.v[i] > b.v[i])); }
+	static inline float4 cmple(float4 a, float4 b) { PC_SIMD_LANES(maskLane(a.v[i] <= b.v[i])); }
+	static inline float4 cmplt(float4 a, float4 b) { PC_SIMD_LANES(maskLane(a.v[i] < b.v[i])); }
+	static inline float4 operator&(float4 a, float4 b) { PC_SIMD_LANES(bitsToFloat(floatToBits(a.v[i]) & floatToBits(b.v[i]))); }
+	static inline float4 operator|(float4 a, float4 b) { PC_SIMD_LANES(bitsToFloat(floatToBits(a.v[i]) | floatToBits(b.v[i]))); }
+
+	static inline float4 select(float4 mask, float4 a, float4 b) { PC_SIMD_LANES(floatToBits(mask.v[i]) ? a.v[i] : b.v[i]); }
+
+	static inline int movemask(float4 mask) {
+		int m = 0;
+		for (int i = 0; i < 4; i++)
+			if (floatToBits(mask.v[i]) & 0x80000000u) m |= 1 << i;
+		return m;
+	}
+
+	// rows to columns, e.g. 4 quaternions to their x, y, z and w
+	static inline void transpose(float4 &a, float4 &b, float4 &c, float4 &d) {
+		float4 *rows[4] = { &a, &b, &c, &d };
+		for (int i = 0; i < 4; i++) {
+			for (int j = i + 1; j < 4; j++) {
+				float t = rows[i]->v[j];
+				rows[i]->v[j] = rows[j]->v[i];
+				rows[j]->v[i] = t;
+			}
+		}
+	}
+
+	#undef PC_SIMD_LANES
+
+#endif
+
+}
+}
+
+#endif
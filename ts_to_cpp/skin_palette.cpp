@@ -0,0 +1,173 @@
+#include "skin_palette.h"
+#include "native_math.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+using namespace pc::simd;
+
+CCALL SkinPaletteBuilder *skin_palette_builder_create(TransformStore *store) {
+	SkinPaletteBuilder *builder = new SkinPaletteBuilder();
+	builder->store = store;
+	builder->stats.instances = 0;
+	builder->stats.updated = 0;
+	builder->stats.bones = 0;
+	return builder;
+}
+
+CCALL void skin_palette_builder_destroy(SkinPaletteBuilder *builder) {
+	delete builder;
+}
+
+CCALL int skin_palette_add(SkinPaletteBuilder *builder, int rootHandle, int numBones, const int *boneHandles, const float *inverseBindPose, float *palette, int layout) {
+	int handle;
+	if (!builder->freeHandles.empty()) {
+		handle = builder->freeHandles.back();
+		builder->freeHandles.pop_back();
+	} else {
+		handle = (int) builder->instances.size();
+		builder->instances.push_back(SkinPaletteInstance());
+	}
+
+	SkinPaletteInstance &instance = builder->instances[handle];
+	instance.numBones = numBones;
+	instance.rootHandle = rootHandle;
+	instance.boneHandles.assign(boneHandles, boneHandles + numBones);
+	instance.inverseBindPose.assign(inverseBindPose, inverseBindPose + numBones * 16);
+	instance.palette = palette;
+	instance.layout = layout;
+	instance.dirty = true;
+	instance.updated = 0;
+	return handle;
+}
+
+CCALL void skin_palette_remove(SkinPaletteBuilder *builder, int handle) {
+	SkinPaletteInstance &instance = builder->instances[handle];
+	if (instance.numBones == 0)
+		return;
+
+	instance.numBones = 0;
+	instance.boneHandles.clear();
+	instance.inverseBindPose.clear();
+	instance.palette = NULL;
+	builder->freeHandles.push_back(handle);
+}
+
+CCALL void skin_palette_set_palette(SkinPaletteBuilder *builder, int handle, float *palette, int layout) {
+	SkinPaletteInstance &instance = builder->instances[handle];
+	instance.palette = palette;
+	instance.layout = layout;
+	instance.dirty = true;
+}
+
+// changed is 2 for the slots transform_store_update wrote this sweep
+static bool hasMoved(const TransformStore *store, const SkinPaletteInstance &instance) {
+	const int32_t *handleSlot = &store->handleSlot[0];
+	const uint8_t *changed = &store->changed[0];
+
+	if (instance.rootHandle >= 0 && changed[handleSlot[instance.rootHandle]] == 2)
+		return true;
+	for (int i = 0; i < instance.numBones; i++) {
+		if (changed[handleSlot[instance.boneHandles[i]]] == 2)
+			return true;
+	}
+	return false;
+}
+
+// r = a * b, with a given by its columns
+static inline void mulColumns(float4 *r, const float4 *a, const float *b) {
+	for (int c = 0; c < 4; c++) {
+		const float *col = b + c * 4;
+		r[c] = a[0] * set1(col[0]) + a[1] * set1(col[1]) + a[2] * set1(col[2]) + a[3] * set1(col[3]);
+	}
+}
+
+static void buildPalette(const TransformStore *transforms, SkinPaletteInstance &instance) {
+	const float *world = &transforms->worldTransform[0];
+	const int32_t *handleSlot = &transforms->handleSlot[0];
+
+	// world space -> root node space
+	float invRoot[16];
+	if (instance.rootHandle >= 0)
+		pc::native::mat4Invert(invRoot, world + handleSlot[instance.rootHandle] * 16);
+	else
+		pc::native::mat4SetIdentity(invRoot);
+
+	float4 invRootColumns[4];
+	for (int c = 0; c < 4; c++)
+		invRootColumns[c] = load(invRoot + c * 4);
+
+	const float *inverseBindPose = &instance.inverseBindPose[0];
+	float *palette = instance.palette;
+	for (int i = 0; i < instance.numBones; i++) {
+		float4 boneToRoot[4];
+		float4 m[4];
+		mulColumns(boneToRoot, invRootColumns, world + handleSlot[instance.boneHandles[i]] * 16);
+		// root node space -> bind space
+		mulColumns(m, boneToRoot, inverseBindPose + i * 16);
+
+		if (instance.layout == SKIN_PALETTE_3X4) {
+			float columns[16];
+			for (int c = 0; c < 4; c++)
+				store(columns + c * 4, m[c]);
+
+			float *rows = palette + i * 12;
+			for (int r = 0; r < 3; r++) {
+				rows[r * 4] = columns[r];
+				rows[r * 4 + 1] = columns[4 + r];
+				rows[r * 4 + 2] = columns[8 + r];
+				rows[r * 4 + 3] = columns[12 + r];
+			}
+		} else {
+			float *out = palette + i * 16;
+			for (int c = 0; c < 4; c++)
+				store(out + c * 4, m[c]);
+		}
+	}
+}
+
+static void buildInstances(void *userData, int begin, int end) {
+	SkinPaletteBuilder *builder = (SkinPaletteBuilder *) userData;
+	const TransformStore *store = builder->store;
+
+	for (int i = begin; i < end; i++) {
+		SkinPaletteInstance &instance = builder->instances[builder->active[i]];
+		if (!instance.palette || (!instance.dirty && !hasMoved(store, instance))) {
+			instance.updated = 0;
+			continue;
+		}
+
+		buildPalette(store, instance);
+		instance.dirty = false;
+		instance.updated = 1;
+	}
+}
+
+CCALL void skin_palette_build(SkinPaletteBuilder *builder) {
+	builder->active.clear();
+	for (int i = 0; i < (int) builder->instances.size(); i++) {
+		if (builder->instances[i].numBones > 0)
+			builder->active.push_back(i);
+	}
+
+	int count = (int) builder->active.size();
+	pc::parallel_for(count, SKIN_PALETTE_GRAIN, buildInstances, builder);
+
+	builder->stats.instances = count;
+	builder->stats.updated = 0;
+	builder->stats.bones = 0;
+	for (int i = 0; i < count; i++) {
+		const SkinPaletteInstance &instance = builder->instances[builder->active[i]];
+		if (instance.updated) {
+			builder->stats.updated++;
+			builder->stats.bones += instance.numBones;
+		}
+	}
+}
+
+CCALL int skin_palette_is_updated(SkinPaletteBuilder *builder, int handle) {
+	return builder->instances[handle].updated;
+}
+
+CCALL SkinPaletteStats *skin_palette_get_stats(SkinPaletteBuilder *builder) {
+	return &builder->stats;
+}
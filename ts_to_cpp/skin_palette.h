@@ -0,0 +1,72 @@
+#ifndef SKIN_PALETTE_H
+#define SKIN_PALETTE_H
+
+#include "include_ccall.h"
+#include "transform_store.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Native pc.SkinInstance#updateMatrices and #updateMatrixPalette.
+ *
+ * Every skinned instance names its bones and root node by TransformStore handle, so their world
+ * transforms are read from the store's contiguous arrays. The palette entry of bone i is
+ * inverse(root world) * bone world * inverse bind pose, computed with float4 columns and written
+ * straight into the instance's palette buffer, typically the locked memory of its bone texture.
+ *
+ * skin_palette_build is meant to run right after transform_store_update: an instance is only
+ * rebuilt when its root or one of its bones was updated by that sweep, or when it is new. The
+ * instances are split into jobs on the thread pool.
+ */
+
+// 16 floats per bone in the pc.Mat4#data layout, what the skinning shaders read today
+#define SKIN_PALETTE_4X4 0
+// 12 floats per bone: the first three rows, the fourth is always 0, 0, 0, 1
+#define SKIN_PALETTE_3X4 1
+
+// skinned instances per job
+#define SKIN_PALETTE_GRAIN 4
+
+struct SkinPaletteInstance {
+	int numBones; // 0 when the handle is free
+	int32_t rootHandle;
+	std::vector<int32_t> boneHandles;
+	std::vector<float> inverseBindPose; // 16 per bone
+	float *palette;
+	int layout;
+	bool dirty;      // rebuild on the next build whether the bones moved or not
+	uint8_t updated; // 1 when the last build wrote the palette
+};
+
+struct SkinPaletteStats {
+	int instances; // instances checked by the last build
+	int updated;   // instances whose palette was rebuilt
+	int bones;     // palette entries written
+};
+
+struct SkinPaletteBuilder {
+	TransformStore *store;
+	std::vector<SkinPaletteInstance> instances; // per handle
+	std::vector<int32_t> freeHandles;
+	std::vector<int32_t> active; // handles in use, rebuilt by every build
+	SkinPaletteStats stats;
+};
+
+CCALL SkinPaletteBuilder *skin_palette_builder_create(TransformStore *store);
+CCALL void skin_palette_builder_destroy(SkinPaletteBuilder *builder);
+
+// boneHandles has numBones TransformStore handles, inverseBindPose 16 floats per bone, both are
+// copied. palette receives 16 or 12 floats per bone depending on layout and must stay valid until
+// the instance is removed or given another palette. Returns the instance handle.
+CCALL int skin_palette_add(SkinPaletteBuilder *builder, int rootHandle, int numBones, const int *boneHandles, const float *inverseBindPose, float *palette, int layout);
+CCALL void skin_palette_remove(SkinPaletteBuilder *builder, int handle);
+CCALL void skin_palette_set_palette(SkinPaletteBuilder *builder, int handle, float *palette, int layout);
+
+// Rebuilds the palettes whose bones moved in the last transform_store_update.
+CCALL void skin_palette_build(SkinPaletteBuilder *builder);
+// 1 when the last build wrote the palette of the instance, which then needs uploading.
+CCALL int skin_palette_is_updated(SkinPaletteBuilder *builder, int handle);
+CCALL SkinPaletteStats *skin_palette_get_stats(SkinPaletteBuilder *builder);
+
+#endif
@@ -0,0 +1,200 @@
+#include "skin_vertices.h"
+#include "native_math.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+#include <math.h>
+#include <string.h>
+
+using namespace pc::simd;
+
+CCALL SkinMesh *skin_mesh_create(int numVertices) {
+	SkinMesh *mesh = new SkinMesh();
+	memset(mesh, 0, sizeof(SkinMesh));
+	mesh->numVertices = numVertices;
+	return mesh;
+}
+
+CCALL void skin_mesh_destroy(SkinMesh *mesh) {
+	delete mesh;
+}
+
+CCALL void skin_mesh_set_input(SkinMesh *mesh, int stream, const void *data, int stride) {
+	mesh->input[stream] = (const uint8_t *) data;
+	mesh->inputStride[stream] = stride;
+}
+
+CCALL void skin_mesh_set_output(SkinMesh *mesh, int stream, void *data, int stride) {
+	mesh->output[stream] = (uint8_t *) data;
+	mesh->outputStride[stream] = stride;
+}
+
+static inline const float *inputFloats(const SkinMesh *mesh, int stream, int vertex) {
+	return (const float *) (mesh->input[stream] + vertex * mesh->inputStride[stream]);
+}
+
+static inline float *outputFloats(const SkinMesh *mesh, int stream, int vertex) {
+	return (float *) (mesh->output[stream] + vertex * mesh->outputStride[stream]);
+}
+
+static inline void storeVec3(float *v, float4 a) {
+	float tmp[4];
+	store(tmp, a);
+	v[0] = tmp[0];
+	v[1] = tmp[1];
+	v[2] = tmp[2];
+}
+
+static inline float4 normalize3(float4 v) {
+	float tmp[4];
+	store(tmp, v * v);
+	float length = tmp[0] + tmp[1] + tmp[2];
+	return length > 0.0f ? v * set1(1.0f / sqrtf(length)) : v;
+}
+
+static void skinLinear(void *userData, int begin, int end) {
+	const SkinMesh *mesh = (const SkinMesh *) userData;
+	const float *palette = mesh->bones;
+	bool normals = mesh->input[SKIN_STREAM_NORMAL] && mesh->output[SKIN_STREAM_NORMAL];
+	bool tangents = mesh->input[SKIN_STREAM_TANGENT] && mesh->output[SKIN_STREAM_TANGENT];
+
+	for (int v = begin; v < end; v++) {
+		const float *weights = inputFloats(mesh, SKIN_STREAM_WEIGHT, v);
+		const uint8_t *indices = mesh->input[SKIN_STREAM_INDEX] + v * mesh->inputStride[SKIN_STREAM_INDEX];
+
+		// weighted sum of the bone matrices, the last row is not needed
+		float4 c0 = zero(), c1 = zero(), c2 = zero(), c3 = zero();
+		for (int i = 0; i < 4; i++) {
+			float weight = weights[i];
+			if (weight == 0.0f)
+				continue;
+			const float *m = palette + indices[i] * 16;
+			float4 w = set1(weight);
+			c0 = c0 + load(m) * w;
+			c1 = c1 + load(m + 4) * w;
+			c2 = c2 + load(m + 8) * w;
+			c3 = c3 + load(m + 12) * w;
+		}
+
+		const float *p = inputFloats(mesh, SKIN_STREAM_POSITION, v);
+		storeVec3(outputFloats(mesh, SKIN_STREAM_POSITION, v), c0 * set1(p[0]) + c1 * set1(p[1]) + c2 * set1(p[2]) + c3);
+
+		if (normals) {
+			const float *n = inputFloats(mesh, SKIN_STREAM_NORMAL, v);
+			storeVec3(outputFloats(mesh, SKIN_STREAM_NORMAL, v), normalize3(c0 * set1(n[0]) + c1 * set1(n[1]) + c2 * set1(n[2])));
+		}
+
+		if (tangents) {
+			const float *t = inputFloats(mesh, SKIN_STREAM_TANGENT, v);
+			float *out = outputFloats(mesh, SKIN_STREAM_TANGENT, v);
+			storeVec3(out, normalize3(c0 * set1(t[0]) + c1 * set1(t[1]) + c2 * set1(t[2])));
+			out[3] = t[3];
+		}
+	}
+}
+
+// v rotated by the unit quaternion q
+static inline void quatRotate(float *r, const float *q, const float *v) {
+	// t = 2 * cross(q.xyz, v), r = v + q.w * t + cross(q.xyz, t)
+	float tx = 2.0f * (q[1] * v[2] - q[2] * v[1]);
+	float ty = 2.0f * (q[2] * v[0] - q[0] * v[2]);
+	float tz = 2.0f * (q[0] * v[1] - q[1] * v[0]);
+	r[0] = v[0] + q[3] * tx + (q[1] * tz - q[2] * ty);
+	r[1] = v[1] + q[3] * ty + (q[2] * tx - q[0] * tz);
+	r[2] = v[2] + q[3] * tz + (q[0] * ty - q[1] * tx);
+}
+
+static inline float dot4(float4 a, float4 b) {
+	float tmp[4];
+	store(tmp, a * b);
+	return (tmp[0] + tmp[1]) + (tmp[2] + tmp[3]);
+}
+
+static void skinDualQuat(void *userData, int begin, int end) {
+	const SkinMesh *mesh = (const SkinMesh *) userData;
+	const float *dualQuats = mesh->bones;
+	bool normals = mesh->input[SKIN_STREAM_NORMAL] && mesh->output[SKIN_STREAM_NORMAL];
+	bool tangents = mesh->input[SKIN_STREAM_TANGENT] && mesh->output[SKIN_STREAM_TANGENT];
+
+	for (int v = begin; v < end; v++) {
+		const float *weights = inputFloats(mesh, SKIN_STREAM_WEIGHT, v);
+		const uint8_t *indices = mesh->input[SKIN_STREAM_INDEX] + v * mesh->inputStride[SKIN_STREAM_INDEX];
+
+		float4 real = zero(), dual = zero(), first = zero();
+		bool hasFirst = false;
+		for (int i = 0; i < 4; i++) {
+			float weight = weights[i];
+			if (weight == 0.0f)
+				continue;
+			const float *dq = dualQuats + indices[i] * 8;
+			float4 r = load(dq);
+
+			// blend in the hemisphere of the first bone, q and -q are the same rotation
+			if (!hasFirst) {
+				first = r;
+				hasFirst = true;
+			} else if (dot4(first, r) < 0.0f) {
+				weight = -weight;
+			}
+
+			float4 w = set1(weight);
+			real = real + r * w;
+			dual = dual + load(dq + 4) * w;
+		}
+
+		float length = sqrtf(dot4(real, real));
+		float4 invLength = set1(length > 0.0f ? 1.0f / length : 0.0f);
+		float q[4], d[4];
+		store(q, real * invLength);
+		store(d, dual * invLength);
+
+		// translation = 2 * dual * conjugate(real)
+		float tx = 2.0f * (q[3] * d[0] - d[3] * q[0] + q[1] * d[2] - q[2] * d[1]);
+		float ty = 2.0f * (q[3] * d[1] - d[3] * q[1] + q[2] * d[0] - q[0] * d[2]);
+		float tz = 2.0f * (q[3] * d[2] - d[3] * q[2] + q[0] * d[1] - q[1] * d[0]);
+
+		float *out = outputFloats(mesh, SKIN_STREAM_POSITION, v);
+		quatRotate(out, q, inputFloats(mesh, SKIN_STREAM_POSITION, v));
+		out[0] += tx;
+		out[1] += ty;
+		out[2] += tz;
+
+		if (normals)
+			quatRotate(outputFloats(mesh, SKIN_STREAM_NORMAL, v), q, inputFloats(mesh, SKIN_STREAM_NORMAL, v));
+
+		if (tangents) {
+			const float *t = inputFloats(mesh, SKIN_STREAM_TANGENT, v);
+			float *outTangent = outputFloats(mesh, SKIN_STREAM_TANGENT, v);
+			quatRotate(outTangent, q, t);
+			outTangent[3] = t[3];
+		}
+	}
+}
+
+CCALL void skin_mesh_skin_linear(SkinMesh *mesh, const float *palette) {
+	mesh->bones = palette;
+	pc::parallel_for(mesh->numVertices, SKIN_VERTICES_GRAIN, skinLinear, mesh);
+	mesh->bones = NULL;
+}
+
+CCALL void skin_mesh_skin_dual_quat(SkinMesh *mesh, const float *dualQuats) {
+	mesh->bones = dualQuats;
+	pc::parallel_for(mesh->numVertices, SKIN_VERTICES_GRAIN, skinDualQuat, mesh);
+	mesh->bones = NULL;
+}
+
+CCALL void skin_palette_to_dual_quats(const float *palette, int numBones, float *dualQuats) {
+	for (int i = 0; i < numBones; i++) {
+		const float *m = palette + i * 16;
+		float *q = dualQuats + i * 8;
+		float *d = q + 4;
+		pc::native::quatSetFromMat4(q, m);
+
+		// dual = 0.5 * translation * real
+		float tx = m[12], ty = m[13], tz = m[14];
+		d[0] = 0.5f * (tx * q[3] + ty * q[2] - tz * q[1]);
+		d[1] = 0.5f * (ty * q[3] + tz * q[0] - tx * q[2]);
+		d[2] = 0.5f * (tz * q[3] + tx * q[1] - ty * q[0]);
+		d[3] = -0.5f * (tx * q[0] + ty * q[1] + tz * q[2]);
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef SKIN_VERTICES_H
+#define SKIN_VERTICES_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+
+/**
+ * CPU vertex skinning, for devices that skin without bone textures or when skinned vertices are
+ * needed on the CPU (picking, physics, bounds).
+ *
+ * A SkinMesh points at the vertex streams of a mesh: positions, normals and tangents as floats,
+ * bone weights as 4 floats and bone indices as 4 bytes per vertex (pc.SEMANTIC_BLENDWEIGHT and
+ * pc.SEMANTIC_BLENDINDICES), each with its own stride so that they can point into one interleaved
+ * vertex buffer. Skinned positions, normals and tangents go to output streams set up the same way.
+ * Normals and tangents are optional, tangent w is copied.
+ *
+ * skin_mesh_skin_linear does 4 bone linear blend skinning with the matrix palette of
+ * skin_palette_build (SKIN_PALETTE_4X4). skin_mesh_skin_dual_quat blends dual quaternions
+ * instead, which keeps the volume of twisting joints at the cost of ignoring bone scale, see
+ * skin_palette_to_dual_quats. Both split the vertices into chunks on the thread pool.
+ */
+
+#define SKIN_STREAM_POSITION 0
+#define SKIN_STREAM_NORMAL 1
+#define SKIN_STREAM_TANGENT 2
+#define SKIN_STREAM_WEIGHT 3
+#define SKIN_STREAM_INDEX 4
+#define SKIN_STREAM_COUNT 5
+
+// vertices per job
+#define SKIN_VERTICES_GRAIN 1024
+
+struct SkinMesh {
+	int numVertices;
+	// per SKIN_STREAM_*, strides in bytes
+	const uint8_t *input[SKIN_STREAM_COUNT];
+	int inputStride[SKIN_STREAM_COUNT];
+	// position, normal and tangent only
+	uint8_t *output[SKIN_STREAM_TANGENT + 1];
+	int outputStride[SKIN_STREAM_TANGENT + 1];
+
+	// bone transforms of the skinning in progress
+	const float *bones;
+};
+
+CCALL SkinMesh *skin_mesh_create(int numVertices);
+CCALL void skin_mesh_destroy(SkinMesh *mesh);
+// The data is not copied and must stay valid while skinning. Pass null to drop a stream.
+CCALL void skin_mesh_set_input(SkinMesh *mesh, int stream, const void *data, int stride);
+CCALL void skin_mesh_set_output(SkinMesh *mesh, int stream, void *data, int stride);
+
+// palette holds a 4x4 matrix per bone.
+CCALL void skin_mesh_skin_linear(SkinMesh *mesh, const float *palette);
+// dualQuats holds 8 floats per bone: the rotation quaternion xyzw, then the dual part xyzw.
+CCALL void skin_mesh_skin_dual_quat(SkinMesh *mesh, const float *dualQuats);
+
+// Converts a 4x4 palette to dual quaternions. Scale is dropped, dual quaternions only hold
+// rotation and translation.
+CCALL void skin_palette_to_dual_quats(const float *palette, int numBones, float *dualQuats);
+
+#endif
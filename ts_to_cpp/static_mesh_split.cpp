@@ -0,0 +1,260 @@
+#include "static_mesh_split.h"
+#include "simd_float4.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+using namespace pc::simd;
+
+static inline void boundsReset(float *bounds) {
+	bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+	bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+}
+
+// FNV-1a
+static inline uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *) data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t hashRange(const StaticMeshSplitMesh &mesh) {
+	uint64_t hash = 14695981039346656037ull;
+	hash = hashBytes(hash, &mesh.key, sizeof(mesh.key));
+	hash = hashBytes(hash, &mesh.base, sizeof(mesh.base));
+	return hashBytes(hash, &mesh.count, sizeof(mesh.count));
+}
+
+static uint64_t hashMesh(const StaticMeshSplitMesh &mesh) {
+	uint64_t hash = hashRange(mesh);
+	hash = hashBytes(hash, &mesh.numLights, sizeof(mesh.numLights));
+	return hashBytes(hash, mesh.lightBounds, sizeof(float) * 6 * mesh.numLights);
+}
+
+static bool isResultOf(const StaticMeshSplitResult &result, const StaticMeshSplitMesh &mesh) {
+	return result.key == mesh.key && result.base == mesh.base && result.count == mesh.count &&
+		result.lightBounds.size() == (size_t) mesh.numLights * 6 &&
+		(mesh.numLights == 0 || memcmp(result.lightBounds.data(), mesh.lightBounds, sizeof(float) * 6 * mesh.numLights) == 0);
+}
+
+CCALL StaticMeshSplitter *static_mesh_split_create() {
+	StaticMeshSplitter *splitter = new StaticMeshSplitter();
+	splitter->run = 0;
+	memset(&splitter->stats, 0, sizeof(splitter->stats));
+	return splitter;
+}
+
+// Frees the results of an index range that the current run does not use.
+static void evictRange(StaticMeshSplitter *splitter, std::vector<StaticMeshSplitResult *> &range) {
+	size_t kept = 0;
+	for (size_t i = 0; i < range.size(); i++) {
+		StaticMeshSplitResult *result = range[i];
+		if (result->lastRun == splitter->run) {
+			range[kept++] = result;
+			continue;
+		}
+
+		std::vector<StaticMeshSplitResult *> &entry = splitter->cache[result->hash];
+		entry.erase(std::find(entry.begin(), entry.end(), result));
+		if (entry.empty())
+			splitter->cache.erase(result->hash);
+		delete result;
+	}
+	range.resize(kept);
+}
+
+CCALL void static_mesh_split_clear_cache(StaticMeshSplitter *splitter) {
+	for (auto &entry : splitter->cache) {
+		for (size_t i = 0; i < entry.second.size(); i++)
+			delete entry.second[i];
+	}
+	splitter->cache.clear();
+	splitter->ranges.clear();
+	splitter->results.clear();
+}
+
+CCALL void static_mesh_split_destroy(StaticMeshSplitter *splitter) {
+	static_mesh_split_clear_cache(splitter);
+	delete splitter;
+}
+
+static inline uint32_t readIndex(const StaticMeshSplitMesh &mesh, int i) {
+	return mesh.bytesPerIndex == 2 ? ((const uint16_t *) mesh.indices)[i] : ((const uint32_t *) mesh.indices)[i];
+}
+
+static void splitMesh(const StaticMeshSplitMesh &mesh, StaticMeshSplitResult &result) {
+	int numTris = mesh.count / 3;
+	result.groups.clear();
+	result.indices.resize(numTris * 3);
+
+	// light boxes in SoA form, padded with boxes that overlap nothing
+	int numLights = mesh.numLights < STATIC_MESH_SPLIT_MAX_LIGHTS ? mesh.numLights : STATIC_MESH_SPLIT_MAX_LIGHTS;
+	int numBlocks = (numLights + 3) / 4;
+	float lights[STATIC_MESH_SPLIT_MAX_LIGHTS / 4][6][4];
+	for (int l = 0; l < numBlocks * 4; l++) {
+		float *bounds = lights[l / 4][0] + (l & 3);
+		for (int k = 0; k < 6; k++)
+			bounds[k * 4] = l < numLights ? mesh.lightBounds[l * 6 + k] : (k < 3 ? FLT_MAX : -FLT_MAX);
+	}
+
+	// light mask of every triangle, from its box
+	std::vector<uint32_t> masks(numTris);
+	const float *positions = mesh.vertices + mesh.offsetPosition;
+	for (int t = 0; t < numTris; t++) {
+		const float *a = positions + readIndex(mesh, mesh.base + t * 3) * mesh.vertexSize;
+		const float *b = positions + readIndex(mesh, mesh.base + t * 3 + 1) * mesh.vertexSize;
+		const float *c = positions + readIndex(mesh, mesh.base + t * 3 + 2) * mesh.vertexSize;
+		float4 triMin = min(min(set(a[0], a[1], a[2], 0.0f), set(b[0], b[1], b[2], 0.0f)), set(c[0], c[1], c[2], 0.0f));
+		float4 triMax = max(max(set(a[0], a[1], a[2], 0.0f), set(b[0], b[1], b[2], 0.0f)), set(c[0], c[1], c[2], 0.0f));
+		float tmp[8];
+		store(tmp, triMin);
+		store(tmp + 4, triMax);
+
+		uint32_t mask = 0;
+		for (int block = 0; block < numBlocks; block++) {
+			float (*box)[4] = lights[block];
+			float4 outside = cmplt(load(box[3]), set1(tmp[0])) | cmplt(set1(tmp[4]), load(box[0])) |
+				cmplt(load(box[4]), set1(tmp[1])) | cmplt(set1(tmp[5]), load(box[1])) |
+				cmplt(load(box[5]), set1(tmp[2])) | cmplt(set1(tmp[6]), load(box[2]));
+			mask |= (uint32_t) (~movemask(outside) & 0xf) << (block * 4);
+		}
+		masks[t] = mask;
+	}
+
+	// one group per distinct mask, in ascending order like the keys of the index lists in
+	// prepareStaticMeshes
+	std::vector<uint32_t> distinct(masks);
+	std::sort(distinct.begin(), distinct.end());
+	distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+	result.groups.resize(distinct.size());
+	for (size_t g = 0; g < distinct.size(); g++) {
+		StaticMeshSplitGroup &group = result.groups[g];
+		group.lightMask = distinct[g];
+		group.firstIndex = 0;
+		group.numIndices = 0;
+		boundsReset(group.aabb);
+	}
+
+	std::vector<int> groupOf(numTris);
+	for (int t = 0; t < numTris; t++) {
+		groupOf[t] = (int) (std::lower_bound(distinct.begin(), distinct.end(), masks[t]) - distinct.begin());
+		result.groups[groupOf[t]].numIndices += 3;
+	}
+	for (size_t g = 1; g < result.groups.size(); g++)
+		result.groups[g].firstIndex = result.groups[g - 1].firstIndex + result.groups[g - 1].numIndices;
+
+	// triangles keep their order within a group
+	std::vector<int> cursor(result.groups.size());
+	for (size_t g = 0; g < result.groups.size(); g++)
+		cursor[g] = result.groups[g].firstIndex;
+	for (int t = 0; t < numTris; t++) {
+		StaticMeshSplitGroup &group = result.groups[groupOf[t]];
+		for (int v = 0; v < 3; v++) {
+			uint32_t index = readIndex(mesh, mesh.base + t * 3 + v);
+			result.indices[cursor[groupOf[t]]++] = index;
+
+			const float *p = positions + index * mesh.vertexSize;
+			for (int k = 0; k < 3; k++) {
+				group.aabb[k] = p[k] < group.aabb[k] ? p[k] : group.aabb[k];
+				group.aabb[k + 3] = p[k] > group.aabb[k + 3] ? p[k] : group.aabb[k + 3];
+			}
+		}
+	}
+}
+
+struct SplitJob {
+	const StaticMeshSplitMesh *meshes;
+	StaticMeshSplitResult **results;
+	std::vector<int> work;
+};
+
+static void splitMeshes(void *userData, int begin, int end) {
+	SplitJob *job = (SplitJob *) userData;
+	for (int w = begin; w < end; w++) {
+		int m = job->work[w];
+		splitMesh(job->meshes[m], *job->results[m]);
+	}
+}
+
+CCALL int static_mesh_split_run(StaticMeshSplitter *splitter, const StaticMeshSplitMesh *meshes, int count) {
+	splitter->results.resize(count);
+	splitter->run++;
+
+	SplitJob job;
+	job.meshes = meshes;
+	job.results = splitter->results.data();
+
+	int cacheHits = 0;
+	int triangles = 0;
+	for (int m = 0; m < count; m++) {
+		uint64_t hash = hashMesh(meshes[m]);
+
+		StaticMeshSplitResult *found = nullptr;
+		auto cached = splitter->cache.find(hash);
+		if (cached != splitter->cache.end()) {
+			for (size_t i = 0; i < cached->second.size() && !found; i++) {
+				if (isResultOf(*cached->second[i], meshes[m]))
+					found = cached->second[i];
+			}
+		}
+		if (found) {
+			// a mesh met earlier in this run is split once, by the first job
+			found->lastRun = splitter->run;
+			splitter->results[m] = found;
+			cacheHits++;
+			continue;
+		}
+
+		// evicting can remove cache entries, so it goes before the new result is added
+		std::vector<StaticMeshSplitResult *> &range = splitter->ranges[hashRange(meshes[m])];
+		if (range.size() >= STATIC_MESH_SPLIT_MAX_CACHED)
+			evictRange(splitter, range);
+
+		StaticMeshSplitResult *result = new StaticMeshSplitResult();
+		result->key = meshes[m].key;
+		result->base = meshes[m].base;
+		result->count = meshes[m].count;
+		result->lightBounds.assign(meshes[m].lightBounds, meshes[m].lightBounds + meshes[m].numLights * 6);
+		result->hash = hash;
+		result->lastRun = splitter->run;
+		splitter->cache[hash].push_back(result);
+		range.push_back(result);
+		splitter->results[m] = result;
+		job.work.push_back(m);
+		triangles += meshes[m].count / 3;
+	}
+
+	pc::parallel_for((int) job.work.size(), STATIC_MESH_SPLIT_GRAIN, splitMeshes, &job);
+
+	int groups = 0;
+	for (int m = 0; m < count; m++)
+		groups += (int) splitter->results[m]->groups.size();
+
+	splitter->stats.meshes = count;
+	splitter->stats.cacheHits = cacheHits;
+	splitter->stats.triangles = triangles;
+	splitter->stats.groups = groups;
+	return groups;
+}
+
+CCALL const StaticMeshSplitGroup *static_mesh_split_get_groups(StaticMeshSplitter *splitter, int mesh, int *count) {
+	const StaticMeshSplitResult *result = splitter->results[mesh];
+	*count = (int) result->groups.size();
+	return result->groups.data();
+}
+
+CCALL const uint32_t *static_mesh_split_get_indices(StaticMeshSplitter *splitter, int mesh, int *count) {
+	const StaticMeshSplitResult *result = splitter->results[mesh];
+	*count = (int) result->indices.size();
+	return result->indices.data();
+}
+
+CCALL StaticMeshSplitStats *static_mesh_split_get_stats(StaticMeshSplitter *splitter) {
+	return &splitter->stats;
+}
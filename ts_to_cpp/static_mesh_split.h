@@ -0,0 +1,107 @@
+#ifndef STATIC_MESH_SPLIT_H
+#define STATIC_MESH_SPLIT_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Light split of static meshes, the work of pc.ForwardRenderer#prepareStaticMeshes.
+ *
+ * Every triangle of a static mesh is tested against the boxes of the static point and spot lights
+ * touching the mesh instance, and the triangles are grouped by the set of lights they overlap. Each
+ * group becomes an index list with its own bounds, drawn with only those lights. The test reads
+ * the vertex and index arrays directly, four lights at a time, and meshes are split between the
+ * threads of the pool.
+ *
+ * Results are cached by the mesh key, the index range and the light boxes, which are in the local
+ * space of the mesh, so preparing the same meshes with the same static lights again (a reload of
+ * the level, or a layer preparing again after a light was toggled back) only looks them up. The
+ * cache is hashed, and every result keeps its inputs, which are compared on a hit so that two
+ * meshes with the same hash never share a result.
+ *
+ * As in prepareStaticMeshes, at most STATIC_MESH_SPLIT_MAX_CACHED light setups are cached per index
+ * range of a mesh, since lights that keep moving make new ones every time. When a range needs one
+ * more, the results of the range that the current run does not use are freed.
+ */
+
+// light sets are tracked in a 32 bit mask per triangle, as in prepareStaticMeshes
+#define STATIC_MESH_SPLIT_MAX_LIGHTS 32
+
+// meshes per job, a mesh can have many triangles
+#define STATIC_MESH_SPLIT_GRAIN 1
+
+// cached results per index range of a mesh, maxStaticSplits in prepareStaticMeshes
+#define STATIC_MESH_SPLIT_MAX_CACHED 8
+
+struct StaticMeshSplitMesh {
+	uint64_t key;               // identifies the vertex and index data, e.g. the id of the pc.Mesh
+	const float *vertices;
+	int vertexSize;             // in floats
+	int offsetPosition;         // in floats
+	const void *indices;
+	int bytesPerIndex;          // 2 or 4
+	int base;                   // first index and number of indices, pc.Mesh#primitive
+	int count;
+	const float *lightBounds;   // min xyz, max xyz per light, in the local space of the mesh
+	int numLights;
+};
+
+struct StaticMeshSplitGroup {
+	uint32_t lightMask;  // bit i set for light i of the mesh
+	int firstIndex;      // into the indices of the result
+	int numIndices;
+	float aabb[6];       // local space min xyz, max xyz
+};
+
+struct StaticMeshSplitResult {
+	std::vector<StaticMeshSplitGroup> groups;  // ascending light mask
+	std::vector<uint32_t> indices;
+
+	// the cache key, StaticMeshSplitMesh fields the result was made from
+	uint64_t key;
+	int base;
+	int count;
+	std::vector<float> lightBounds;
+
+	uint64_t hash;
+	int lastRun;  // the run that last returned the result
+};
+
+struct StaticMeshSplitStats {
+	int meshes;
+	int cacheHits;
+	int triangles;  // triangles tested by the last run, cached meshes excluded
+	int groups;
+};
+
+struct StaticMeshSplitter {
+	// by hash, results with the same hash share an entry
+	std::unordered_map<uint64_t, std::vector<StaticMeshSplitResult *> > cache;
+	// the same results by index range (key, base and count), to bound the light setups per range
+	std::unordered_map<uint64_t, std::vector<StaticMeshSplitResult *> > ranges;
+	std::vector<StaticMeshSplitResult *> results;  // per mesh of the last run, owned by the cache
+	int run;
+	StaticMeshSplitStats stats;
+};
+
+CCALL StaticMeshSplitter *static_mesh_split_create();
+CCALL void static_mesh_split_destroy(StaticMeshSplitter *splitter);
+
+// Splits count meshes, or finds them in the cache. Returns the number of groups of all meshes.
+// Meshes with no light produce a single group, or none when they have no triangles.
+CCALL int static_mesh_split_run(StaticMeshSplitter *splitter, const StaticMeshSplitMesh *meshes, int count);
+
+// Groups and indices of mesh i of the last run. Indices are vertex indices of the mesh, three per
+// triangle, and stay valid until the next run or until the cache is cleared.
+CCALL const StaticMeshSplitGroup *static_mesh_split_get_groups(StaticMeshSplitter *splitter, int mesh, int *count);
+CCALL const uint32_t *static_mesh_split_get_indices(StaticMeshSplitter *splitter, int mesh, int *count);
+
+// Drops every cached result, e.g. when meshes were destroyed.
+CCALL void static_mesh_split_clear_cache(StaticMeshSplitter *splitter);
+
+CCALL StaticMeshSplitStats *static_mesh_split_get_stats(StaticMeshSplitter *splitter);
+
+#endif
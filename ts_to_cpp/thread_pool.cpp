@@ -0,0 +1,223 @@
+#include "thread_pool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pc {
+	struct Job {
+		ParallelForFunc func;
+		void *userData;
+		int begin;
+		int end;
+		JobCounter *counter;
+	};
+
+	// Deques are short and contended rarely, a lock per deque keeps stealing simple and safe.
+	class WorkDeque {
+	public:
+		void push(const Job &job) {
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(job);
+		}
+
+		// owner end, newest job first for cache locality
+		bool pop(Job &job) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (jobs.empty())
+				return false;
+			job = jobs.back();
+			jobs.pop_back();
+			return true;
+		}
+
+		// thief end, oldest job first, which is usually the largest remaining piece of work
+		bool steal(Job &job) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (jobs.empty())
+				return false;
+			job = jobs.front();
+			jobs.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	static std::vector<std::thread> workers;
+	// deque 0 is shared by all threads outside the pool, worker i owns deque i + 1
+	static std::vector<WorkDeque *> deques;
+	static thread_local int dequeIndex = 0;
+
+	static std::atomic<int> queuedJobs(0);
+	static std::atomic<bool> shuttingDown(false);
+	static std::mutex sleepMutex;
+	static std::condition_variable sleepWake;
+
+	static std::atomic<unsigned int> jobsRun(0);
+	static std::atomic<unsigned int> jobsStolen(0);
+
+	static bool findJob(Job &job) {
+		int numDeques = (int) deques.size();
+		if (deques[dequeIndex]->pop(job))
+			return true;
+
+		for (int i = 1; i < numDeques; i++) {
+			int victim = (dequeIndex + i) % numDeques;
+			if (deques[victim]->steal(job)) {
+				jobsStolen.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void runJob(const Job &job) {
+		queuedJobs.fetch_sub(1);
+		job.func(job.userData, job.begin, job.end);
+		jobsRun.fetch_add(1, std::memory_order_relaxed);
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	static void workerMain(int index) {
+		dequeIndex = index;
+		for (;;) {
+			Job job;
+			if (findJob(job)) {
+				runJob(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepWake.wait(lock, [] { return shuttingDown.load() || queuedJobs.load() > 0; });
+			if (shuttingDown.load())
+				return;
+		}
+	}
+
+	static void wakeWorkers(int numJobs) {
+		// taking the lock orders the wake up after a worker's check of queuedJobs
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		if (numJobs == 1)
+			sleepWake.notify_one();
+		else
+			sleepWake.notify_all();
+	}
+
+	void job_submit(ParallelForFunc func, void *userData, int begin, int end, JobCounter *counter) {
+		if (workers.empty()) {
+			func(userData, begin, end);
+			return;
+		}
+
+		Job job;
+		job.func = func;
+		job.userData = userData;
+		job.begin = begin;
+		job.end = end;
+		job.counter = counter;
+
+		counter->pending.fetch_add(1);
+		deques[dequeIndex]->push(job);
+		queuedJobs.fetch_add(1);
+		wakeWorkers(1);
+	}
+
+	void job_wait(JobCounter *counter) {
+		while (counter->pending.load(std::memory_order_acquire) > 0) {
+			Job job;
+			if (findJob(job))
+				runJob(job);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void parallel_for(int count, int grain, ParallelForFunc func, void *userData) {
+		if (count <= 0)
+			return;
+		if (grain < 1)
+			grain = 1;
+
+		if (workers.empty() || count <= grain) {
+			func(userData, 0, count);
+			return;
+		}
+
+		int numRanges = (count + grain - 1) / grain;
+		JobCounter counter;
+		counter.pending = numRanges;
+
+		// queue the ranges back to front so the owner pops them front to back
+		WorkDeque *deque = deques[dequeIndex];
+		for (int range = numRanges - 1; range >= 0; range--) {
+			Job job;
+			job.func = func;
+			job.userData = userData;
+			job.begin = range * grain;
+			job.end = job.begin + grain < count ? job.begin + grain : count;
+			job.counter = &counter;
+			deque->push(job);
+		}
+		queuedJobs.fetch_add(numRanges);
+		wakeWorkers(numRanges);
+
+		job_wait(&counter);
+	}
+}
+
+CCALL void thread_pool_init(int numThreads) {
+	thread_pool_shutdown();
+
+	if (numThreads < 0) {
+		int hardware = (int) std::thread::hardware_concurrency();
+		numThreads = hardware > 1 ? hardware - 1 : 0;
+	}
+	if (numThreads == 0)
+		return;
+
+	pc::shuttingDown = false;
+	for (int i = 0; i <= numThreads; i++)
+		pc::deques.push_back(new pc::WorkDeque());
+	for (int i = 0; i < numThreads; i++)
+		pc::workers.push_back(std::thread(pc::workerMain, i + 1));
+}
+
+CCALL void thread_pool_shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(pc::sleepMutex);
+		pc::shuttingDown = true;
+	}
+	pc::sleepWake.notify_all();
+	for (size_t i = 0; i < pc::workers.size(); i++)
+		pc::workers[i].join();
+	pc::workers.clear();
+
+	for (size_t i = 0; i < pc::deques.size(); i++)
+		delete pc::deques[i];
+	pc::deques.clear();
+	pc::queuedJobs = 0;
+}
+
+CCALL int thread_pool_get_num_threads() {
+	return (int) pc::workers.size();
+}
+
+CCALL unsigned int thread_pool_get_jobs_run() {
+	return pc::jobsRun.load();
+}
+
+CCALL unsigned int thread_pool_get_jobs_stolen() {
+	return pc::jobsStolen.load();
+}
+
+CCALL void thread_pool_reset_stats() {
+	pc::jobsRun = 0;
+	pc::jobsStolen = 0;
+}
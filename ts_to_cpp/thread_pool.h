@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "include_ccall.h"
+
+#include <atomic>
+
+/**
+ * Job system shared by the native kernels.
+ *
+ * Every worker owns a deque of jobs. It pushes and pops work at the back of its own deque and, when
+ * that runs dry, steals from the front of the others. Threads outside the pool (the main thread)
+ * share one extra deque. A thread waiting for its jobs keeps running queued jobs instead of blocking.
+ *
+ * The pool is empty until thread_pool_init is called, in which case everything simply runs on the
+ * calling thread. The wasm build needs -s USE_PTHREADS=1 for the workers to exist.
+ *
+ * thread_pool_init and thread_pool_shutdown must not be called while jobs are running.
+ */
+
+// Starts numThreads workers (the calling thread always helps out as well). Passing 0 keeps
+// everything on the calling thread, a negative value uses one worker per extra hardware thread.
+CCALL void thread_pool_init(int numThreads);
+CCALL void thread_pool_shutdown();
+CCALL int thread_pool_get_num_threads();
+
+// Counters since the last reset, handy to check how well work is spread.
+CCALL unsigned int thread_pool_get_jobs_run();
+CCALL unsigned int thread_pool_get_jobs_stolen();
+CCALL void thread_pool_reset_stats();
+
+namespace pc {
+	typedef void (*ParallelForFunc)(void *userData, int begin, int end);
+
+	// Number of queued jobs that have not finished yet.
+	struct JobCounter {
+		std::atomic<int> pending;
+		JobCounter() : pending(0) {}
+	};
+
+	// Queues func(userData, begin, end) on the calling thread's deque. Without workers it runs
+	// immediately.
+	void job_submit(ParallelForFunc func, void *userData, int begin, int end, JobCounter *counter);
+
+	// Runs queued jobs until every job of counter finished.
+	void job_wait(JobCounter *counter);
+
+	// Calls func over [0, count) split into ranges of at most grain items and returns once every
+	// range is done. Ranges run in any order and on any thread, so func must only write data owned
+	// by its range. Calls may be nested.
+	void parallel_for(int count, int grain, ParallelForFunc func, void *userData);
+}
+
+#endif
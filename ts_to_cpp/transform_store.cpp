@@ -0,0 +1,374 @@
+#include "transform_store.h"
+#include "native_math.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <string.h>
+
+using namespace pc::native;
+
+static void resizeSlots(TransformStore *store, int size) {
+	store->localPosition.resize(size * 3);
+	store->localRotation.resize(size * 4);
+	store->localScale.resize(size * 3);
+	store->localTransform.resize(size * 16);
+	store->worldTransform.resize(size * 16);
+	store->parent.resize(size);
+	store->flags.resize(size);
+	store->slotHandle.resize(size);
+	store->changed.resize(size);
+}
+
+CCALL TransformStore *transform_store_create(int capacity) {
+	TransformStore *store = new TransformStore();
+	store->count = 0;
+	store->orderDirty = false;
+	store->nodesUpdated = 0;
+
+	store->localPosition.reserve(capacity * 3);
+	store->localRotation.reserve(capacity * 4);
+	store->localScale.reserve(capacity * 3);
+	store->localTransform.reserve(capacity * 16);
+	store->worldTransform.reserve(capacity * 16);
+	store->parent.reserve(capacity);
+	store->flags.reserve(capacity);
+	store->slotHandle.reserve(capacity);
+	store->changed.reserve(capacity);
+	store->handleSlot.reserve(capacity);
+	store->handleParent.reserve(capacity);
+	return store;
+}
+
+CCALL void transform_store_destroy(TransformStore *store) {
+	delete store;
+}
+
+CCALL int transform_store_add(TransformStore *store) {
+	int handle;
+	if (!store->freeHandles.empty()) {
+		handle = store->freeHandles.back();
+		store->freeHandles.pop_back();
+	} else {
+		handle = (int) store->handleSlot.size();
+		store->handleSlot.push_back(-1);
+		store->handleParent.push_back(-1);
+	}
+
+	// new nodes are roots, appending them keeps the depth order valid
+	int slot = store->count++;
+	resizeSlots(store, store->count);
+
+	float *p = &store->localPosition[slot * 3];
+	float *r = &store->localRotation[slot * 4];
+	float *s = &store->localScale[slot * 3];
+	p[0] = p[1] = p[2] = 0;
+	r[0] = r[1] = r[2] = 0;
+	r[3] = 1;
+	s[0] = s[1] = s[2] = 1;
+	mat4SetIdentity(&store->localTransform[slot * 16]);
+	mat4SetIdentity(&store->worldTransform[slot * 16]);
+	store->parent[slot] = -1;
+	store->flags[slot] = TRANSFORM_STORE_ENABLED;
+	store->slotHandle[slot] = handle;
+	store->changed[slot] = 0;
+
+	store->handleSlot[handle] = slot;
+	store->handleParent[handle] = -1;
+
+	if (!store->levelOffsets.empty())
+		store->levelOffsets.back() = store->count;
+	return handle;
+}
+
+static inline void dirtify(TransformStore *store, int handle, uint8_t bits) {
+	store->flags[store->handleSlot[handle]] |= bits;
+}
+
+CCALL void transform_store_remove(TransformStore *store, int handle) {
+	int numHandles = (int) store->handleSlot.size();
+	for (int h = 0; h < numHandles; h++) {
+		if (store->handleSlot[h] >= 0 && store->handleParent[h] == handle) {
+			store->handleParent[h] = -1;
+			dirtify(store, h, TRANSFORM_STORE_DIRTY_WORLD);
+		}
+	}
+
+	// the slot is dropped when the store is next sorted
+	store->handleParent[handle] = -1;
+	store->handleSlot[handle] = -1;
+	store->freeHandles.push_back(handle);
+	store->orderDirty = true;
+}
+
+CCALL int transform_store_set_parent(TransformStore *store, int handle, int parentHandle) {
+	// a node under itself would never be reached by the breadth first sort
+	for (int h = parentHandle; h != -1; h = store->handleParent[h]) {
+		if (h == handle)
+			return 0;
+	}
+
+	store->handleParent[handle] = parentHandle;
+	dirtify(store, handle, TRANSFORM_STORE_DIRTY_WORLD);
+	store->orderDirty = true;
+	return 1;
+}
+
+CCALL void transform_store_set_local_position(TransformStore *store, int handle, float x, float y, float z) {
+	float *p = &store->localPosition[store->handleSlot[handle] * 3];
+	p[0] = x;
+	p[1] = y;
+	p[2] = z;
+	dirtify(store, handle, TRANSFORM_STORE_DIRTY_LOCAL);
+}
+
+CCALL void transform_store_set_local_rotation(TransformStore *store, int handle, float x, float y, float z, float w) {
+	float *r = &store->localRotation[store->handleSlot[handle] * 4];
+	r[0] = x;
+	r[1] = y;
+	r[2] = z;
+	r[3] = w;
+	dirtify(store, handle, TRANSFORM_STORE_DIRTY_LOCAL);
+}
+
+CCALL void transform_store_set_local_scale(TransformStore *store, int handle, float x, float y, float z) {
+	float *s = &store->localScale[store->handleSlot[handle] * 3];
+	s[0] = x;
+	s[1] = y;
+	s[2] = z;
+	dirtify(store, handle, TRANSFORM_STORE_DIRTY_LOCAL);
+}
+
+static void setFlag(TransformStore *store, int handle, uint8_t flag, int value) {
+	uint8_t &flags = store->flags[store->handleSlot[handle]];
+	if (value)
+		flags |= flag;
+	else
+		flags &= ~flag;
+}
+
+CCALL void transform_store_set_enabled(TransformStore *store, int handle, int enabled) {
+	setFlag(store, handle, TRANSFORM_STORE_ENABLED, enabled);
+}
+
+CCALL void transform_store_set_scale_compensation(TransformStore *store, int handle, int scaleCompensation) {
+	setFlag(store, handle, TRANSFORM_STORE_SCALE_COMPENSATION, scaleCompensation);
+	dirtify(store, handle, TRANSFORM_STORE_DIRTY_WORLD);
+}
+
+template <typename T>
+static void permute(std::vector<T> &data, const std::vector<int32_t> &order, int stride) {
+	std::vector<T> sorted(order.size() * stride);
+	for (size_t i = 0; i < order.size(); i++)
+		memcpy(&sorted[i * stride], &data[order[i] * stride], sizeof(T) * stride);
+	data.swap(sorted);
+}
+
+// Sorts the live slots breadth first: roots in their current order, then the children of every
+// level grouped by parent. Parents therefore always precede their children.
+static void sortByDepth(TransformStore *store) {
+	int numHandles = (int) store->handleSlot.size();
+
+	// children of every handle, in current slot order so that the sort is stable
+	std::vector<int32_t> childStart(numHandles + 1, 0);
+	for (int slot = 0; slot < store->count; slot++) {
+		int h = store->slotHandle[slot];
+		if (store->handleSlot[h] == slot && store->handleParent[h] >= 0)
+			childStart[store->handleParent[h] + 1]++;
+	}
+	for (int h = 0; h < numHandles; h++)
+		childStart[h + 1] += childStart[h];
+
+	std::vector<int32_t> children(childStart[numHandles]);
+	std::vector<int32_t> fill(childStart.begin(), childStart.end() - 1);
+	std::vector<int32_t> order; // old slots in new order
+	order.reserve(store->count);
+	for (int slot = 0; slot < store->count; slot++) {
+		int h = store->slotHandle[slot];
+		if (store->handleSlot[h] != slot)
+			continue;
+		if (store->handleParent[h] >= 0)
+			children[fill[store->handleParent[h]]++] = h;
+		else
+			order.push_back(slot);
+	}
+
+	store->levelOffsets.clear();
+	size_t levelStart = 0;
+	while (levelStart < order.size()) {
+		size_t levelEnd = order.size();
+		store->levelOffsets.push_back((int32_t) levelStart);
+		for (size_t i = levelStart; i < levelEnd; i++) {
+			int h = store->slotHandle[order[i]];
+			for (int c = childStart[h]; c < childStart[h + 1]; c++)
+				order.push_back(store->handleSlot[children[c]]);
+		}
+		levelStart = levelEnd;
+	}
+	store->levelOffsets.push_back((int32_t) order.size());
+
+	store->count = (int) order.size();
+	permute(store->localPosition, order, 3);
+	permute(store->localRotation, order, 4);
+	permute(store->localScale, order, 3);
+	permute(store->localTransform, order, 16);
+	permute(store->worldTransform, order, 16);
+	permute(store->flags, order, 1);
+	permute(store->slotHandle, order, 1);
+	store->changed.assign(store->count, 0);
+
+	for (int slot = 0; slot < store->count; slot++)
+		store->handleSlot[store->slotHandle[slot]] = slot;
+
+	store->parent.resize(store->count);
+	for (int slot = 0; slot < store->count; slot++) {
+		int parentHandle = store->handleParent[store->slotHandle[slot]];
+		store->parent[slot] = parentHandle >= 0 ? store->handleSlot[parentHandle] : -1;
+	}
+
+	store->orderDirty = false;
+}
+
+// Same as the scaleCompensation branch of pc.GraphNode#_sync.
+static void syncScaleCompensated(TransformStore *store, int slot) {
+	int parent = store->parent[slot];
+	const float *parentWorld = &store->worldTransform[parent * 16];
+	const float *localScale = &store->localScale[slot * 3];
+
+	// find the parent of the first uncompensated node up in the hierarchy and use its scale * localScale
+	float scale[3] = { localScale[0], localScale[1], localScale[2] };
+	float parentWorldScale[3] = { 1, 1, 1 };
+	int scaleFrom = parent;
+	while (scaleFrom >= 0 && (store->flags[scaleFrom] & TRANSFORM_STORE_SCALE_COMPENSATION))
+		scaleFrom = store->parent[scaleFrom];
+	if (scaleFrom >= 0) {
+		scaleFrom = store->parent[scaleFrom];
+		if (scaleFrom >= 0) {
+			mat4GetScale(&store->worldTransform[scaleFrom * 16], parentWorldScale);
+			for (int i = 0; i < 3; i++)
+				scale[i] = parentWorldScale[i] * localScale[i];
+		}
+	}
+
+	// rotation is as usual
+	float parentRotation[4], rotation[4];
+	quatSetFromMat4(parentRotation, parentWorld);
+	quatMul(rotation, parentRotation, &store->localRotation[slot * 4]);
+
+	// find the matrix to transform the position with
+	float compensated[16];
+	const float *positionTransform = parentWorld;
+	if (store->flags[parent] & TRANSFORM_STORE_SCALE_COMPENSATION) {
+		const float *parentLocalScale = &store->localScale[parent * 3];
+		float parentScale[3] = { parentWorldScale[0] * parentLocalScale[0], parentWorldScale[1] * parentLocalScale[1], parentWorldScale[2] * parentLocalScale[2] };
+		mat4SetTRS(compensated, &parentWorld[12], parentRotation, parentScale);
+		positionTransform = compensated;
+	}
+
+	float position[3];
+	mat4TransformPoint(positionTransform, &store->localPosition[slot * 3], position);
+	mat4SetTRS(&store->worldTransform[slot * 16], position, rotation, scale);
+}
+
+// Updates the slots [begin, end). Every slot only reads its parent, so the slots of one depth
+// level can be swept in any order and on any thread once the previous levels are done.
+static int sweep(TransformStore *store, int begin, int end) {
+	int updated = 0;
+	uint8_t *flags = &store->flags[0];
+	uint8_t *changed = &store->changed[0];
+	const int32_t *parents = &store->parent[0];
+
+	// changed doubles as the "active in hierarchy" marker: 0 inactive, 1 active and clean,
+	// 2 active and updated this sweep
+	for (int slot = begin; slot < end; slot++) {
+		int parent = parents[slot];
+		uint8_t f = flags[slot];
+
+		bool parentActive = parent < 0 || changed[parent] != 0;
+		bool parentChanged = parent >= 0 && changed[parent] == 2;
+
+		if (!(f & TRANSFORM_STORE_ENABLED) || !parentActive) {
+			// keep the node dirty until its subtree is synced again
+			if (parentChanged)
+				flags[slot] |= TRANSFORM_STORE_DIRTY_WORLD;
+			changed[slot] = 0;
+			continue;
+		}
+
+		if (f & TRANSFORM_STORE_DIRTY_LOCAL)
+			mat4SetTRS(&store->localTransform[slot * 16], &store->localPosition[slot * 3], &store->localRotation[slot * 4], &store->localScale[slot * 3]);
+
+		if ((f & (TRANSFORM_STORE_DIRTY_LOCAL | TRANSFORM_STORE_DIRTY_WORLD)) || parentChanged) {
+			float *world = &store->worldTransform[slot * 16];
+			if (parent < 0)
+				memcpy(world, &store->localTransform[slot * 16], sizeof(float) * 16);
+			else if (f & TRANSFORM_STORE_SCALE_COMPENSATION)
+				syncScaleCompensated(store, slot);
+			else
+				mat4MulAffine(world, &store->worldTransform[parent * 16], &store->localTransform[slot * 16]);
+
+			flags[slot] = f & ~(TRANSFORM_STORE_DIRTY_LOCAL | TRANSFORM_STORE_DIRTY_WORLD);
+			changed[slot] = 2;
+			updated++;
+		} else {
+			changed[slot] = 1;
+		}
+	}
+
+	return updated;
+}
+
+struct SweepJob {
+	TransformStore *store;
+	int levelBegin;
+	std::atomic<int> updated;
+};
+
+static void sweepLevelRange(void *userData, int begin, int end) {
+	SweepJob *job = (SweepJob *) userData;
+	int updated = sweep(job->store, job->levelBegin + begin, job->levelBegin + end);
+	job->updated.fetch_add(updated, std::memory_order_relaxed);
+}
+
+CCALL int transform_store_update(TransformStore *store) {
+	if (store->orderDirty)
+		sortByDepth(store);
+
+	int updated;
+	if (thread_pool_get_num_threads() == 0 || store->levelOffsets.empty()) {
+		updated = sweep(store, 0, store->count);
+	} else {
+		// one level at a time, parallel_for returning acts as the barrier between levels. Each
+		// node is computed from the same inputs whichever thread runs it, so the results do not
+		// depend on the number of threads.
+		SweepJob job;
+		job.store = store;
+		job.updated = 0;
+		for (size_t level = 0; level + 1 < store->levelOffsets.size(); level++) {
+			job.levelBegin = store->levelOffsets[level];
+			pc::parallel_for(store->levelOffsets[level + 1] - job.levelBegin, TRANSFORM_STORE_SWEEP_GRAIN, sweepLevelRange, &job);
+		}
+		updated = job.updated.load();
+	}
+
+	store->nodesUpdated = updated;
+	return updated;
+}
+
+CCALL const float *transform_store_get_local_transform(TransformStore *store, int handle) {
+	return &store->localTransform[store->handleSlot[handle] * 16];
+}
+
+CCALL const float *transform_store_get_world_transform(TransformStore *store, int handle) {
+	return &store->worldTransform[store->handleSlot[handle] * 16];
+}
+
+CCALL int transform_store_get_depth(TransformStore *store, int handle) {
+	int depth = 0;
+	for (int h = store->handleParent[handle]; h >= 0; h = store->handleParent[h])
+		depth++;
+	return depth;
+}
+
+CCALL int transform_store_get_count(TransformStore *store) {
+	return store->count;
+}
@@ -0,0 +1,85 @@
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+
+#include "include_ccall.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Contiguous transform storage for pc.GraphNode.
+ *
+ * Local position, rotation, scale, local transform and world transform of every node live in SoA
+ * arrays, sorted breadth first so that every parent precedes its children and siblings are
+ * adjacent. World transforms are then brought up to date in one linear sweep instead of the
+ * recursion in pc.GraphNode#syncHierarchy.
+ *
+ * Nodes are referred to by the stable handle returned by transform_store_add, which the caller
+ * keeps next to its node; pc.GraphNode does not store one yet. Sorting only happens in
+ * transform_store_update after the hierarchy changed, and it moves data between slots, so pointers
+ * returned by the getters are only valid until the next update.
+ */
+
+#define TRANSFORM_STORE_DIRTY_LOCAL 0x01
+#define TRANSFORM_STORE_DIRTY_WORLD 0x02
+#define TRANSFORM_STORE_ENABLED 0x04
+#define TRANSFORM_STORE_SCALE_COMPENSATION 0x08
+
+// nodes per job when a depth level is swept on the thread pool
+#define TRANSFORM_STORE_SWEEP_GRAIN 256
+
+struct TransformStore {
+	// per slot, in depth order
+	std::vector<float> localPosition;  // xyz
+	std::vector<float> localRotation;  // xyzw
+	std::vector<float> localScale;     // xyz
+	std::vector<float> localTransform; // 16 per slot
+	std::vector<float> worldTransform; // 16 per slot
+	std::vector<int32_t> parent;       // parent slot, -1 for roots
+	std::vector<uint8_t> flags;
+	std::vector<int32_t> slotHandle;
+	// first slot of every depth level, plus one past the last slot
+	std::vector<int32_t> levelOffsets;
+	// scratch for the sweep: 0 inactive, 1 active and unchanged, 2 active and the world transform
+	// of the slot changed
+	std::vector<uint8_t> changed;
+	int count;
+
+	// per handle
+	std::vector<int32_t> handleSlot;   // -1 when the handle is free
+	std::vector<int32_t> handleParent; // parent handle, -1 for roots
+	std::vector<int32_t> freeHandles;
+
+	bool orderDirty;
+	int nodesUpdated;
+};
+
+CCALL TransformStore *transform_store_create(int capacity);
+CCALL void transform_store_destroy(TransformStore *store);
+
+// Adds a root node with an identity transform and returns its handle.
+CCALL int transform_store_add(TransformStore *store);
+// Removes a node, its children become roots.
+CCALL void transform_store_remove(TransformStore *store, int handle);
+// Pass -1 to make the node a root. Returns 0 and leaves the hierarchy unchanged when parentHandle
+// is the node itself or one of its descendants, 1 otherwise.
+CCALL int transform_store_set_parent(TransformStore *store, int handle, int parentHandle);
+
+CCALL void transform_store_set_local_position(TransformStore *store, int handle, float x, float y, float z);
+CCALL void transform_store_set_local_rotation(TransformStore *store, int handle, float x, float y, float z, float w);
+CCALL void transform_store_set_local_scale(TransformStore *store, int handle, float x, float y, float z);
+CCALL void transform_store_set_enabled(TransformStore *store, int handle, int enabled);
+CCALL void transform_store_set_scale_compensation(TransformStore *store, int handle, int scaleCompensation);
+
+// Re-sorts the store if the hierarchy changed and updates every dirty world transform, skipping
+// disabled subtrees like pc.GraphNode#syncHierarchy. Returns the number of nodes updated.
+// With thread pool workers running, every depth level is split into chunks that are updated in
+// parallel. The results are identical to the single threaded sweep.
+CCALL int transform_store_update(TransformStore *store);
+
+CCALL const float *transform_store_get_local_transform(TransformStore *store, int handle);
+CCALL const float *transform_store_get_world_transform(TransformStore *store, int handle);
+CCALL int transform_store_get_depth(TransformStore *store, int handle);
+CCALL int transform_store_get_count(TransformStore *store);
+
+#endif